@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ */
+
+#ifndef __ASM_ARM_CRC32_H
+#define __ASM_ARM_CRC32_H
+
+#include <linux/types.h>
+
+/**
+ * crc32_le_arm64() - Update a CRC32 (IEEE 802.3 polynomial)
+ *
+ * This works on the raw CRC register, i.e. the caller must invert the CRC
+ * before and after, as needed.
+ *
+ * @crc: Current CRC value
+ * @buf: Data to add
+ * @len: Number of bytes of data
+ * Return: updated CRC value
+ */
+u32 crc32_le_arm64(u32 crc, const u8 *buf, size_t len);
+
+/**
+ * crc32c_le_arm64() - Update a CRC32C (Castagnoli polynomial)
+ *
+ * This works on the raw CRC register, i.e. the caller must invert the CRC
+ * before and after, as needed.
+ *
+ * @crc: Current CRC value
+ * @buf: Data to add
+ * @len: Number of bytes of data
+ * Return: updated CRC value
+ */
+u32 crc32c_le_arm64(u32 crc, const u8 *buf, size_t len);
+
+/**
+ * crc32_pmull() - Carry-less multiply two 32-bit values
+ *
+ * This uses the PMULL instruction, so is only available with ARM64_NEON
+ *
+ * @a: First value
+ * @b: Second value
+ * Return: 64-bit carry-less product of @a and @b
+ */
+u64 crc32_pmull(u32 a, u32 b);
+
+#endif
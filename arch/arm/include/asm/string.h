@@ -9,9 +9,25 @@
 #undef __HAVE_ARCH_STRRCHR
 extern char * strrchr(const char * s, int c);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRCHR)
+#define __HAVE_ARCH_STRCHR
+#else
 #undef __HAVE_ARCH_STRCHR
+#endif
 extern char * strchr(const char * s, int c);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRLEN)
+#define __HAVE_ARCH_STRLEN
+#define __HAVE_ARCH_STRNLEN
+#endif
+extern __kernel_size_t strlen(const char *);
+extern __kernel_size_t strnlen(const char *, __kernel_size_t);
+
+#if CONFIG_IS_ENABLED(USE_ARCH_STRCMP)
+#define __HAVE_ARCH_STRCMP
+#endif
+extern int strcmp(const char *, const char *);
+
 #if CONFIG_IS_ENABLED(USE_ARCH_MEMCPY)
 #define __HAVE_ARCH_MEMCPY
 #endif
@@ -24,9 +40,18 @@ extern void * memcpy(void *, const void *, __kernel_size_t);
 #endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_MEMCHR)
+#define __HAVE_ARCH_MEMCHR
+#else
 #undef __HAVE_ARCH_MEMCHR
+#endif
 extern void * memchr(const void *, int, __kernel_size_t);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_MEMCMP)
+#define __HAVE_ARCH_MEMCMP
+#endif
+extern int memcmp(const void *, const void *, __kernel_size_t);
+
 #undef __HAVE_ARCH_MEMZERO
 #if CONFIG_IS_ENABLED(USE_ARCH_MEMSET)
 #define __HAVE_ARCH_MEMSET
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ *
+ * Data is processed eight bytes at a time once aligned. Each CRC32 instruction
+ * depends on the result of the previous one, so large buffers are split into
+ * three lanes which are processed together, hiding the latency of the
+ * instruction. The lane results are then combined by multiplying by x^n mod P,
+ * using PMULL if available.
+ */
+
+#include <efi_loader.h>
+#include <asm/crc32.h>
+
+enum {
+	CRC32_POLY_LE	= 0xedb88320,
+	CRC32C_POLY_LE	= 0x82f63b78,
+
+	/* Number of bytes in each lane when interleaving */
+	CRC32_LANE_SIZE	= 1024,
+	CRC32_LANE_WORDS = CRC32_LANE_SIZE / sizeof(u64),
+
+	/*
+	 * x^(8 * CRC32_LANE_SIZE) mod P, in bit-reflected form, for shifting a
+	 * CRC past a lane of zeroes
+	 */
+	CRC32_LANE_SHIFT	= 0x6427800e,
+	CRC32C_LANE_SHIFT	= 0xe4172b16,
+
+	/*
+	 * x^(8 * CRC32_LANE_SIZE - 33) mod P, used instead when the product
+	 * is calculated with PMULL and reduced with a CRC32 instruction. The
+	 * reduction multiplies by x^32 and PMULL by x, since the operands are
+	 * bit-reflected.
+	 */
+	CRC32_LANE_PMULL	= 0xbbf2f6d6,
+	CRC32C_LANE_PMULL	= 0x170076fa,
+};
+
+static __always_inline u32 crc_b(u32 crc, u8 val, bool castagnoli)
+{
+	return castagnoli ? __builtin_aarch64_crc32cb(crc, val) :
+		__builtin_aarch64_crc32b(crc, val);
+}
+
+static __always_inline u32 crc_w(u32 crc, u32 val, bool castagnoli)
+{
+	return castagnoli ? __builtin_aarch64_crc32cw(crc, val) :
+		__builtin_aarch64_crc32w(crc, val);
+}
+
+static __always_inline u32 crc_x(u32 crc, u64 val, bool castagnoli)
+{
+	return castagnoli ? __builtin_aarch64_crc32cx(crc, val) :
+		__builtin_aarch64_crc32x(crc, val);
+}
+
+/**
+ * multmodp() - Multiply two polynomials modulo P
+ *
+ * This is the method used by zlib's crc32_combine(). The values are
+ * bit-reflected, with x^0 in the top bit.
+ *
+ * @a: First polynomial
+ * @b: Second polynomial
+ * @poly: Bit-reflected polynomial P, without the x^32 term
+ * Return: a * b mod P
+ */
+static u32 __efi_runtime multmodp(u32 a, u32 b, u32 poly)
+{
+	u32 m = 1U << 31;
+	u32 p = 0;
+
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if (!(a & (m - 1)))
+				break;
+		}
+		m >>= 1;
+		b = b & 1 ? (b >> 1) ^ poly : b >> 1;
+	}
+
+	return p;
+}
+
+/* Return the CRC of the data followed by a lane of zeroes */
+static __always_inline u32 crc_shift_lane(u32 crc, bool castagnoli)
+{
+	if (IS_ENABLED(CONFIG_ARM64_NEON))
+		return crc_x(0, crc32_pmull(crc, castagnoli ?
+				CRC32C_LANE_PMULL : CRC32_LANE_PMULL),
+			     castagnoli);
+
+	return castagnoli ? multmodp(CRC32C_LANE_SHIFT, crc, CRC32C_POLY_LE) :
+		multmodp(CRC32_LANE_SHIFT, crc, CRC32_POLY_LE);
+}
+
+static __always_inline u32 crc32_arm64(u32 crc, const u8 *buf, size_t len,
+				       bool castagnoli)
+{
+	const u64 *p;
+	size_t i;
+
+	/* Unaligned access may fault with the MMU off, so align first */
+	while (len && ((ulong)buf & 7)) {
+		crc = crc_b(crc, *buf++, castagnoli);
+		len--;
+	}
+
+	p = (const u64 *)buf;
+	while (len >= 3 * CRC32_LANE_SIZE) {
+		const u64 *p1 = p + CRC32_LANE_WORDS;
+		const u64 *p2 = p1 + CRC32_LANE_WORDS;
+		u32 crc1 = 0, crc2 = 0;
+
+		for (i = 0; i < CRC32_LANE_WORDS; i++) {
+			crc = crc_x(crc, p[i], castagnoli);
+			crc1 = crc_x(crc1, p1[i], castagnoli);
+			crc2 = crc_x(crc2, p2[i], castagnoli);
+		}
+		crc = crc_shift_lane(crc, castagnoli) ^ crc1;
+		crc = crc_shift_lane(crc, castagnoli) ^ crc2;
+		p += 3 * CRC32_LANE_WORDS;
+		len -= 3 * CRC32_LANE_SIZE;
+	}
+
+	for (; len >= sizeof(u64); len -= sizeof(u64))
+		crc = crc_x(crc, *p++, castagnoli);
+
+	buf = (const u8 *)p;
+	if (len >= sizeof(u32)) {
+		crc = crc_w(crc, *(const u32 *)buf, castagnoli);
+		buf += sizeof(u32);
+		len -= sizeof(u32);
+	}
+	while (len--)
+		crc = crc_b(crc, *buf++, castagnoli);
+
+	return crc;
+}
+
+u32 __efi_runtime crc32_le_arm64(u32 crc, const u8 *buf, size_t len)
+{
+	return crc32_arm64(crc, buf, len, false);
+}
+
+u32 __efi_runtime crc32c_le_arm64(u32 crc, const u8 *buf, size_t len)
+{
+	return crc32_arm64(crc, buf, len, true);
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Carry-less multiply for combining CRC32 results
+ *
+ * This is built without -mgeneral-regs-only, so it is kept separate from the
+ * rest of the CRC32 code.
+ */
+
+#include <linux/types.h>
+#include <arm_neon.h>
+#include <efi_loader.h>
+#include <asm/crc32.h>
+
+u64 __efi_runtime crc32_pmull(u32 a, u32 b)
+{
+	poly128_t prod = vmull_p64(a, b);
+
+	return vgetq_lane_u64(vreinterpretq_u64_p128(prod), 0);
+}
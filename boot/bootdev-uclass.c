@@ -129,7 +129,7 @@ int bootdev_find_in_blk(struct udevice *dev, struct udevice *blk,
 	else
 		strcpy(partstr, "whole");
 	snprintf(name, sizeof(name), "%s.%s", dev->name, partstr);
-	bflow->name = strdup(name);
+	bflow->name = bootflow_strdup(bflow, name);
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 
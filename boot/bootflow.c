@@ -7,6 +7,7 @@
 #define LOG_CATEGORY UCLASS_BOOTSTD
 
 #include <common.h>
+#include <arena.h>
 #include <bootdev.h>
 #include <bootflow.h>
 #include <bootmeth.h>
@@ -462,14 +463,36 @@ void bootflow_init(struct bootflow *bflow, struct udevice *bootdev,
 
 void bootflow_free(struct bootflow *bflow)
 {
-	free(bflow->name);
-	free(bflow->subdir);
-	free(bflow->fname);
 	if (!(bflow->flags & BOOTFLOWF_STATIC_BUF))
 		free(bflow->buf);
-	free(bflow->os_name);
-	free(bflow->fdt_fname);
+	free(bflow->cmdline);
 	free(bflow->bootmeth_priv);
+	arena_free(bflow->arena);
+}
+
+/* Strings in a bootflow are short, so a small chunk holds them all */
+#define BOOTFLOW_ARENA_SIZE	0x200
+
+static struct arena *bootflow_arena(struct bootflow *bflow)
+{
+	if (!bflow->arena)
+		bflow->arena = arena_new(BOOTFLOW_ARENA_SIZE);
+
+	return bflow->arena;
+}
+
+char *bootflow_strdup(struct bootflow *bflow, const char *s)
+{
+	struct arena *arena = bootflow_arena(bflow);
+
+	return arena ? arena_strdup(arena, s) : NULL;
+}
+
+char *bootflow_strndup(struct bootflow *bflow, const char *s, size_t n)
+{
+	struct arena *arena = bootflow_arena(bflow);
+
+	return arena ? arena_strndup(arena, s, n) : NULL;
 }
 
 void bootflow_remove(struct bootflow *bflow)
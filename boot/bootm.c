@@ -251,13 +251,21 @@ static void boot_start_lmb(struct bootm_headers *images)
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
 }
+
+/* Free any region arrays left over from a previous bootm */
+static void boot_stop_lmb(struct bootm_headers *images)
+{
+	lmb_uninit(&images->lmb);
+}
 #else
 #define lmb_reserve(lmb, base, size)
 static inline void boot_start_lmb(struct bootm_headers *images) { }
+static inline void boot_stop_lmb(struct bootm_headers *images) { }
 #endif
 
 static int bootm_start(void)
 {
+	boot_stop_lmb(&images);
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -1110,8 +1118,12 @@ int bootm_run_states(struct bootm_info *bmi, int states)
 	}
 
 	/* Now run the OS! We hope this doesn't return */
-	if (!ret && (states & BOOTM_STATE_OS_GO))
+	if (!ret && (states & BOOTM_STATE_OS_GO)) {
+		/* Records still waiting for the console would be lost */
+		if (IS_ENABLED(CONFIG_LOG_RING_DRAIN))
+			log_ring_flush();
 		ret = boot_selected_os(BOOTM_STATE_OS_GO, bmi, boot_fn);
+	}
 
 	/* Deal with any fallout */
 err:
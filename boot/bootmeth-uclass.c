@@ -277,8 +277,7 @@ int bootmeth_try_file(struct bootflow *bflow, struct blk_desc *desc,
 	snprintf(path, sizeof(path), "%s%s", prefix ? prefix : "", fname);
 	log_debug("trying: %s\n", path);
 
-	free(bflow->fname);
-	bflow->fname = strdup(path);
+	bflow->fname = bootflow_strdup(bflow, path);
 	if (!bflow->fname)
 		return log_msg_ret("name", -ENOMEM);
 
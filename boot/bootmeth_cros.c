@@ -231,13 +231,13 @@ static int cros_read_buf(struct bootflow *bflow, void *buf, ulong size,
 					    map_sysmem(kern_base, 0));
 	log_debug("version %s\n", version);
 	if (version)
-		bflow->name = strdup(version);
+		bflow->name = bootflow_strdup(bflow, version);
 #endif
 	if (!bflow->name)
-		bflow->name = strdup("ChromeOS");
+		bflow->name = bootflow_strdup(bflow, "ChromeOS");
 	if (!bflow->name)
 		return log_msg_ret("nam", -ENOMEM);
-	bflow->os_name = strdup("ChromeOS");
+	bflow->os_name = bootflow_strdup(bflow, "ChromeOS");
 	if (!bflow->os_name)
 		return log_msg_ret("os", -ENOMEM);
 
@@ -291,7 +291,7 @@ static int distro_efi_try_bootflow_files(struct udevice *dev,
 	}
 
 	if (*fname) {
-		bflow->fdt_fname = strdup(fname);
+		bflow->fdt_fname = bootflow_strdup(bflow, fname);
 		if (!bflow->fdt_fname)
 			return log_msg_ret("fil", -ENOMEM);
 	}
@@ -364,7 +364,7 @@ static int distro_efi_read_bootflow_net(struct bootflow *bflow)
 	bootfile_name = env_get("bootfile");
 	if (!bootfile_name)
 		return log_msg_ret("bootfile_name", ret);
-	bflow->fname = strdup(bootfile_name);
+	bflow->fname = bootflow_strdup(bflow, bootfile_name);
 
 	/* do the hideous EFI hack */
 	efi_set_bootdev("Net", "", bflow->fname, map_sysmem(addr, 0),
@@ -382,7 +382,7 @@ static int distro_efi_read_bootflow_net(struct bootflow *bflow)
 	if (ret)
 		return log_msg_ret("nam", ret);
 
-	bflow->fdt_fname = strdup(fname);
+	bflow->fdt_fname = bootflow_strdup(bflow, fname);
 	if (!bflow->fdt_fname)
 		return log_msg_ret("fil", -ENOMEM);
 
@@ -88,7 +88,7 @@ static int extlinux_fill_info(struct bootflow *bflow)
 		tok = strsep(&p, " ");
 		if (p) {
 			if (!strcmp("label", tok)) {
-				bflow->os_name = strdup(p);
+				bflow->os_name = bootflow_strdup(bflow, p);
 				if (!bflow->os_name)
 					return log_msg_ret("os", -ENOMEM);
 			}
@@ -88,15 +88,16 @@ static int extlinux_pxe_read_bootflow(struct udevice *dev,
 		last_slash = strrchr(bootdir, '/');
 		if (last_slash) {
 			path_len = (last_slash - bootdir) + 1;
-			bflow->subdir = malloc(path_len + 1);
-			memcpy(bflow->subdir, bootdir, path_len);
-			bflow->subdir[path_len] = '\0';
+			bflow->subdir = bootflow_strndup(bflow, bootdir,
+							 path_len);
+			if (!bflow->subdir)
+				return log_msg_ret("sub", -ENOMEM);
 		}
 	}
 	snprintf(fname, sizeof(fname), "%s%s",
 		 bflow->subdir ? bflow->subdir : "", EXTLINUX_FNAME);
 
-	bflow->fname = strdup(fname);
+	bflow->fname = bootflow_strdup(bflow, fname);
 	if (!bflow->fname)
 		return log_msg_ret("name", -ENOMEM);
 
@@ -38,7 +38,7 @@ static int qfw_read_bootflow(struct udevice *dev, struct bootflow *bflow)
 	load = env_get_hex("kernel_addr_r", 0);
 	initrd = env_get_hex("ramdisk_addr_r", 0);
 	log_debug("setup kernel %s %lx %lx\n", qfw_dev->name, load, initrd);
-	bflow->name = strdup("qfw");
+	bflow->name = bootflow_strdup(bflow, "qfw");
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 
@@ -55,7 +55,7 @@ static int script_fill_info(struct bootflow *bflow)
 	}
 
 	if (name) {
-		bflow->os_name = strdup(name);
+		bflow->os_name = bootflow_strdup(bflow, name);
 		if (!bflow->os_name)
 			return log_msg_ret("os", -ENOMEM);
 	}
@@ -95,7 +95,7 @@ static int script_read_bootflow_file(struct udevice *bootstd,
 	if (ret)
 		return log_msg_ret("try", ret);
 
-	bflow->subdir = strdup(prefix ? prefix : "");
+	bflow->subdir = bootflow_strdup(bflow, prefix ? prefix : "");
 	if (!bflow->subdir)
 		return log_msg_ret("prefix", -ENOMEM);
 
@@ -10,6 +10,7 @@
 #include <abuf.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
 #include <stdio_dev.h>
@@ -2100,6 +2101,375 @@ int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 	}
 	return err;
 }
+
+/**
+ * struct overlay_label - Entry in the label index for a batch of overlays
+ *
+ * @name: Label name (allocated), or NULL if this slot is empty
+ * @phandle: Phandle of the node the label refers to in the base tree
+ */
+struct overlay_label {
+	char *name;
+	u32 phandle;
+};
+
+/**
+ * struct overlay_index - Label index for a batch of overlays
+ *
+ * This maps labels in the base tree's /__symbols__ node to phandles, so that
+ * the __fixups__ of each overlay in a batch can be resolved without looking
+ * up the path of each label again in the (growing) base tree.
+ *
+ * @tab: Hash table of labels, using open addressing
+ * @size: Number of slots in @tab (a power of two)
+ * @count: Number of slots in use
+ */
+struct overlay_index {
+	struct overlay_label *tab;
+	uint size;
+	uint count;
+};
+
+static uint overlay_label_hash(const char *name)
+{
+	uint hash = 0;
+
+	while (*name)
+		hash = hash * 31 + *name++;
+
+	return hash;
+}
+
+static struct overlay_label *overlay_index_find(struct overlay_index *idx,
+						const char *name)
+{
+	uint mask = idx->size - 1;
+	uint i;
+
+	if (!idx->size)
+		return NULL;
+	for (i = overlay_label_hash(name) & mask; idx->tab[i].name;
+	     i = (i + 1) & mask) {
+		if (!strcmp(idx->tab[i].name, name))
+			return &idx->tab[i];
+	}
+
+	return &idx->tab[i];
+}
+
+static int overlay_index_grow(struct overlay_index *idx)
+{
+	struct overlay_index new = {};
+	uint i;
+
+	new.size = idx->size ? idx->size * 2 : 64;
+	new.tab = calloc(new.size, sizeof(*new.tab));
+	if (!new.tab)
+		return -FDT_ERR_NOSPACE;
+	for (i = 0; i < idx->size; i++) {
+		if (idx->tab[i].name)
+			*overlay_index_find(&new, idx->tab[i].name) =
+				idx->tab[i];
+	}
+	new.count = idx->count;
+	free(idx->tab);
+	*idx = new;
+
+	return 0;
+}
+
+/**
+ * overlay_index_add() - Add the label of a node in the base tree to the index
+ *
+ * Labels which cannot be resolved to a phandle are left out, so that libfdt
+ * reports the problem when the overlay is applied.
+ *
+ * @idx: Index to update
+ * @fdt: Base tree
+ * @label: Label name
+ * @path: Path of the node in @fdt which the label refers to
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if out of memory
+ */
+static int overlay_index_add(struct overlay_index *idx, const void *fdt,
+			     const char *label, const char *path)
+{
+	struct overlay_label *entry;
+	u32 phandle;
+	int node, ret;
+
+	node = path ? fdt_path_offset(fdt, path) : -FDT_ERR_NOTFOUND;
+	phandle = node >= 0 ? fdt_get_phandle(fdt, node) : 0;
+
+	entry = overlay_index_find(idx, label);
+	if (entry && entry->name) {
+		entry->phandle = phandle;
+		return 0;
+	}
+	if (!phandle)
+		return 0;
+	if ((idx->count + 1) * 2 > idx->size) {
+		ret = overlay_index_grow(idx);
+		if (ret)
+			return ret;
+		entry = overlay_index_find(idx, label);
+	}
+	entry->name = strdup(label);
+	if (!entry->name)
+		return -FDT_ERR_NOSPACE;
+	entry->phandle = phandle;
+	idx->count++;
+
+	return 0;
+}
+
+static void overlay_index_uninit(struct overlay_index *idx)
+{
+	uint i;
+
+	for (i = 0; i < idx->size; i++)
+		free(idx->tab[i].name);
+	free(idx->tab);
+}
+
+static int overlay_index_init(struct overlay_index *idx, const void *fdt)
+{
+	const char *label, *path;
+	int symbols, prop, ret;
+
+	memset(idx, '\0', sizeof(*idx));
+	symbols = fdt_path_offset(fdt, "/__symbols__");
+	if (symbols < 0)
+		return 0;
+
+	fdt_for_each_property_offset(prop, fdt, symbols) {
+		path = fdt_getprop_by_offset(fdt, prop, &label, NULL);
+		if (!path)
+			continue;
+		ret = overlay_index_add(idx, fdt, label, path);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * overlay_resolve_fixup() - Write a phandle into each place listed in a fixup
+ *
+ * @fdto: Overlay to update
+ * @value: Value of the __fixups__ property, a list of "path:name:offset"
+ *	strings
+ * @len: Length of @value in bytes
+ * @phandle: Phandle to write
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int overlay_resolve_fixup(void *fdto, const char *value, int len,
+				 u32 phandle)
+{
+	fdt32_t val = cpu_to_fdt32(phandle);
+	const char *end = value + len;
+
+	while (value < end) {
+		const char *name, *sep;
+		int entry_len, node, ret;
+		char *endp;
+		ulong poffset;
+
+		entry_len = strnlen(value, end - value);
+		if (value + entry_len == end)
+			return -FDT_ERR_BADOVERLAY;
+		name = memchr(value, ':', entry_len);
+		if (!name++)
+			return -FDT_ERR_BADOVERLAY;
+		sep = strchr(name, ':');
+		if (!sep || sep == name)
+			return -FDT_ERR_BADOVERLAY;
+		poffset = simple_strtoul(sep + 1, &endp, 10);
+		if (*endp || endp == sep + 1)
+			return -FDT_ERR_BADOVERLAY;
+
+		node = fdt_path_offset_namelen(fdto, value, name - 1 - value);
+		if (node < 0)
+			return node == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : node;
+		ret = fdt_setprop_inplace_namelen_partial(fdto, node, name,
+							  sep - name, poffset,
+							  &val, sizeof(val));
+		if (ret)
+			return ret;
+		value += entry_len + 1;
+	}
+
+	return 0;
+}
+
+/**
+ * overlay_index_fixup() - Resolve the __fixups__ of an overlay using the index
+ *
+ * Each fixup whose label is in the index is resolved and removed from the
+ * overlay. Anything else is left for fdt_overlay_apply() to deal with.
+ *
+ * @idx: Index of labels in the base tree
+ * @fdto: Overlay to update
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int overlay_index_fixup(struct overlay_index *idx, void *fdto)
+{
+	struct overlay_label *entry;
+	int fixups, prop, prev;
+	const char *value, *label;
+	int len, ret;
+
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return fixups;
+
+	prev = -1;
+	prop = fdt_first_property_offset(fdto, fixups);
+	while (prop >= 0) {
+		value = fdt_getprop_by_offset(fdto, prop, &label, &len);
+		if (!value)
+			return len;
+		entry = overlay_index_find(idx, label);
+		if (!entry || !entry->name || !entry->phandle) {
+			prev = prop;
+			prop = fdt_next_property_offset(fdto, prop);
+			continue;
+		}
+		ret = overlay_resolve_fixup(fdto, value, len, entry->phandle);
+		if (!ret)
+			ret = fdt_delprop(fdto, fixups, label);
+		if (ret)
+			return ret;
+
+		/* the next property has moved into the place of this one */
+		prop = prev < 0 ? fdt_first_property_offset(fdto, fixups) :
+			fdt_next_property_offset(fdto, prev);
+	}
+	if (prop != -FDT_ERR_NOTFOUND)
+		return prop;
+
+	return 0;
+}
+
+/**
+ * overlay_get_labels() - Get a copy of the labels defined by an overlay
+ *
+ * The overlay is destroyed when it is applied, so the labels it adds to the
+ * base tree must be noted beforehand.
+ *
+ * @fdto: Overlay to check
+ * @countp: Returns the number of labels
+ * Return: Allocated list of allocated label names, NULL if there are none or
+ *	on error (in which case @countp is set to a -ve FDT error)
+ */
+static char **overlay_get_labels(const void *fdto, int *countp)
+{
+	const char *label;
+	char **labels;
+	int symbols, prop;
+	int count = 0;
+
+	*countp = 0;
+	symbols = fdt_path_offset(fdto, "/__symbols__");
+	if (symbols < 0)
+		return NULL;
+	fdt_for_each_property_offset(prop, fdto, symbols)
+		count++;
+	if (!count)
+		return NULL;
+
+	labels = calloc(count, sizeof(char *));
+	if (!labels) {
+		*countp = -FDT_ERR_NOSPACE;
+		return NULL;
+	}
+	count = 0;
+	fdt_for_each_property_offset(prop, fdto, symbols) {
+		if (!fdt_getprop_by_offset(fdto, prop, &label, NULL))
+			continue;
+		labels[count] = strdup(label);
+		if (!labels[count]) {
+			while (count--)
+				free(labels[count]);
+			free(labels);
+			*countp = -FDT_ERR_NOSPACE;
+			return NULL;
+		}
+		count++;
+	}
+	*countp = count;
+
+	return labels;
+}
+
+/**
+ * overlay_index_update() - Add the labels from an applied overlay to the index
+ *
+ * @idx: Index to update
+ * @fdt: Base tree, with the overlay applied
+ * @labels: Labels defined by the overlay, as returned by overlay_get_labels()
+ * @count: Number of labels
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if out of memory
+ */
+static int overlay_index_update(struct overlay_index *idx, const void *fdt,
+				char **labels, int count)
+{
+	int symbols, i, ret;
+
+	symbols = fdt_path_offset(fdt, "/__symbols__");
+	if (symbols < 0)
+		return 0;
+	for (i = 0; i < count; i++) {
+		ret = overlay_index_add(idx, fdt, labels[i],
+					fdt_getprop(fdt, symbols, labels[i],
+						    NULL));
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_overlay_apply_batch(void *fdt, void *const fdtos[], int count)
+{
+	struct overlay_index idx;
+	char **labels;
+	int i, j, num, err;
+
+	if (count == 1)
+		return fdt_overlay_apply_verbose(fdt, fdtos[0]);
+
+	err = overlay_index_init(&idx, fdt);
+	if (err)
+		printf("failed to index overlay labels: %s\n",
+		       fdt_strerror(err));
+	for (i = 0; !err && i < count; i++) {
+		err = overlay_index_fixup(&idx, fdtos[i]);
+		if (err) {
+			printf("failed to resolve overlay %d: %s\n", i,
+			       fdt_strerror(err));
+			break;
+		}
+
+		labels = overlay_get_labels(fdtos[i], &num);
+		err = num < 0 ? num : fdt_overlay_apply_verbose(fdt, fdtos[i]);
+		if (!err) {
+			err = overlay_index_update(&idx, fdt, labels, num);
+			if (err)
+				printf("failed to index labels of overlay %d: %s\n",
+				       i, fdt_strerror(err));
+		}
+		for (j = 0; labels && j < num; j++)
+			free(labels[j]);
+		free(labels);
+	}
+	overlay_index_uninit(&idx);
+
+	return err;
+}
 #endif
 
 /**
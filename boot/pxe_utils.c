@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <arena.h>
 #include <command.h>
 #include <dm.h>
 #include <env.h>
@@ -224,49 +225,15 @@ static int get_relfile_envaddr(struct pxe_context *ctx, const char *file_path,
 /**
  * label_create() - crate a new PXE label
  *
- * Allocates memory for and initializes a pxe_label. This uses malloc, so the
- * result must be free()'d to reclaim the memory.
+ * Allocates memory for and initializes a pxe_label. The label and its string
+ * members are allocated from the menu's arena and are freed along with it.
  *
+ * @arena: Arena to allocate from
  * Returns a pointer to the label, or NULL if out of memory
  */
-static struct pxe_label *label_create(void)
+static struct pxe_label *label_create(struct arena *arena)
 {
-	struct pxe_label *label;
-
-	label = malloc(sizeof(struct pxe_label));
-	if (!label)
-		return NULL;
-
-	memset(label, 0, sizeof(struct pxe_label));
-
-	return label;
-}
-
-/**
- * label_destroy() - free the memory used by a pxe_label
- *
- * This frees @label itself as well as memory used by its name,
- * kernel, config, append, initrd, fdt, fdtdir and fdtoverlay members, if
- * they're non-NULL.
- *
- * So - be sure to only use dynamically allocated memory for the members of
- * the pxe_label struct, unless you want to clean it up first. These are
- * currently only created by the pxe file parsing code.
- *
- * @label: Label to free
- */
-static void label_destroy(struct pxe_label *label)
-{
-	free(label->name);
-	free(label->kernel_label);
-	free(label->kernel);
-	free(label->config);
-	free(label->append);
-	free(label->initrd);
-	free(label->fdt);
-	free(label->fdtdir);
-	free(label->fdtoverlays);
-	free(label);
+	return arena_zalloc(arena, sizeof(struct pxe_label));
 }
 
 /**
@@ -857,9 +824,9 @@ enum lex_state {
  * The location of *p is updated to point to the first character after the end
  * of the token - the ending delimiter.
  *
- * Memory for t->val is allocated using malloc and must be free()'d to reclaim
- * it.
+ * Memory for t->val is allocated from @arena and is freed along with it.
  *
+ * @arena: Arena to allocate from
  * @p: Points to a pointer to the current position in the input being processed.
  *	Updated to point at the first character after the current token
  * @t: Pointers to a token to fill in
@@ -867,7 +834,8 @@ enum lex_state {
  * @lower: true to convert the string to lower case when storing
  * Returns the new value of t->val, on success, NULL if out of memory
  */
-static char *get_string(char **p, struct token *t, char delim, int lower)
+static char *get_string(struct arena *arena, char **p, struct token *t,
+			char delim, int lower)
 {
 	char *b, *e;
 	size_t len, i;
@@ -892,7 +860,7 @@ static char *get_string(char **p, struct token *t, char delim, int lower)
 	 * Allocate memory to hold the string, and copy it in, converting
 	 * characters to lowercase if lower is != 0.
 	 */
-	t->val = malloc(len + 1);
+	t->val = arena_alloc(arena, len + 1);
 	if (!t->val)
 		return NULL;
 
@@ -936,10 +904,12 @@ static void get_keyword(struct token *t)
  * We have to keep track of which state we're in to know if we're looking to get
  * a string literal or a keyword.
  *
+ * @arena: Arena to allocate the token value from
  * @p: Points to a pointer to the current position in the input being processed.
  *	Updated to point at the first character after the current token
  */
-static void get_token(char **p, struct token *t, enum lex_state state)
+static void get_token(struct arena *arena, char **p, struct token *t,
+		      enum lex_state state)
 {
 	char *c = *p;
 
@@ -965,7 +935,7 @@ static void get_token(char **p, struct token *t, enum lex_state state)
 		t->type = T_EOF;
 		c++;
 	} else if (state == L_SLITERAL) {
-		get_string(&c, t, '\n', 0);
+		get_string(arena, &c, t, '\n', 0);
 	} else if (state == L_KEYWORD) {
 		/*
 		 * when we expect a keyword, we first get the next string
@@ -974,7 +944,7 @@ static void get_token(char **p, struct token *t, enum lex_state state)
 		 * converted to a keyword token of the appropriate type, and
 		 * if not, it remains a string token.
 		 */
-		get_string(&c, t, ' ', 1);
+		get_string(arena, &c, t, ' ', 1);
 		get_keyword(t);
 	}
 
@@ -1006,12 +976,12 @@ static void eol_or_eof(char **c)
  * Parse a string literal and store a pointer it at *dst. String literals
  * terminate at the end of the line.
  */
-static int parse_sliteral(char **c, char **dst)
+static int parse_sliteral(struct arena *arena, char **c, char **dst)
 {
 	struct token t;
 	char *s = *c;
 
-	get_token(c, &t, L_SLITERAL);
+	get_token(arena, c, &t, L_SLITERAL);
 
 	if (t.type != T_STRING) {
 		printf("Expected string literal: %.*s\n", (int)(*c - s), s);
@@ -1026,12 +996,12 @@ static int parse_sliteral(char **c, char **dst)
 /*
  * Parse a base 10 (unsigned) integer and store it at *dst.
  */
-static int parse_integer(char **c, int *dst)
+static int parse_integer(struct arena *arena, char **c, int *dst)
 {
 	struct token t;
 	char *s = *c;
 
-	get_token(c, &t, L_SLITERAL);
+	get_token(arena, c, &t, L_SLITERAL);
 	if (t.type != T_STRING) {
 		printf("Expected string: %.*s\n", (int)(*c - s), s);
 		return -EINVAL;
@@ -1039,8 +1009,6 @@ static int parse_integer(char **c, int *dst)
 
 	*dst = simple_strtol(t.val, NULL, 10);
 
-	free(t.val);
-
 	return 1;
 }
 
@@ -1064,7 +1032,7 @@ static int handle_include(struct pxe_context *ctx, char **c, unsigned long base,
 	char *buf;
 	int ret;
 
-	err = parse_sliteral(c, &include_path);
+	err = parse_sliteral(cfg->arena, c, &include_path);
 	if (err < 0) {
 		printf("Expected include path: %.*s\n", (int)(*c - s), s);
 		return err;
@@ -1100,11 +1068,11 @@ static int parse_menu(struct pxe_context *ctx, char **c, struct pxe_menu *cfg,
 	char *s = *c;
 	int err = 0;
 
-	get_token(c, &t, L_KEYWORD);
+	get_token(cfg->arena, c, &t, L_KEYWORD);
 
 	switch (t.type) {
 	case T_TITLE:
-		err = parse_sliteral(c, &cfg->title);
+		err = parse_sliteral(cfg->arena, c, &cfg->title);
 
 		break;
 
@@ -1113,7 +1081,7 @@ static int parse_menu(struct pxe_context *ctx, char **c, struct pxe_menu *cfg,
 		break;
 
 	case T_BACKGROUND:
-		err = parse_sliteral(c, &cfg->bmp);
+		err = parse_sliteral(cfg->arena, c, &cfg->bmp);
 		break;
 
 	default:
@@ -1139,19 +1107,20 @@ static int parse_label_menu(char **c, struct pxe_menu *cfg,
 
 	s = *c;
 
-	get_token(c, &t, L_KEYWORD);
+	get_token(cfg->arena, c, &t, L_KEYWORD);
 
 	switch (t.type) {
 	case T_DEFAULT:
 		if (!cfg->default_label)
-			cfg->default_label = strdup(label->name);
+			cfg->default_label = arena_strdup(cfg->arena,
+							  label->name);
 
 		if (!cfg->default_label)
 			return -ENOMEM;
 
 		break;
 	case T_LABEL:
-		parse_sliteral(c, &label->menu);
+		parse_sliteral(cfg->arena, c, &label->menu);
 		break;
 	default:
 		printf("Ignoring malformed menu command: %.*s\n",
@@ -1167,17 +1136,18 @@ static int parse_label_menu(char **c, struct pxe_menu *cfg,
  * Handles parsing a 'kernel' label.
  * expecting "filename" or "<fit_filename>#cfg"
  */
-static int parse_label_kernel(char **c, struct pxe_label *label)
+static int parse_label_kernel(struct arena *arena, char **c,
+			      struct pxe_label *label)
 {
 	char *s;
 	int err;
 
-	err = parse_sliteral(c, &label->kernel);
+	err = parse_sliteral(arena, c, &label->kernel);
 	if (err < 0)
 		return err;
 
 	/* copy the kernel label to compare with FDT / INITRD when FIT is used */
-	label->kernel_label = strdup(label->kernel);
+	label->kernel_label = arena_strdup(arena, label->kernel);
 	if (!label->kernel_label)
 		return -ENOMEM;
 
@@ -1185,7 +1155,7 @@ static int parse_label_kernel(char **c, struct pxe_label *label)
 	if (!s)
 		return 1;
 
-	label->config = strdup(s);
+	label->config = arena_strdup(arena, s);
 	if (!label->config)
 		return -ENOMEM;
 
@@ -1204,20 +1174,22 @@ static int parse_label_kernel(char **c, struct pxe_label *label)
  */
 static int parse_label(char **c, struct pxe_menu *cfg)
 {
+	struct arena *arena = cfg->arena;
+	struct arena_mark mark;
 	struct token t;
-	int len;
 	char *s = *c;
 	struct pxe_label *label;
 	int err;
 
-	label = label_create();
+	arena_mark(arena, &mark);
+	label = label_create(arena);
 	if (!label)
 		return -ENOMEM;
 
-	err = parse_sliteral(c, &label->name);
+	err = parse_sliteral(arena, c, &label->name);
 	if (err < 0) {
 		printf("Expected label name: %.*s\n", (int)(*c - s), s);
-		label_destroy(label);
+		arena_rollback(arena, &mark);
 		return -EINVAL;
 	}
 
@@ -1225,7 +1197,7 @@ static int parse_label(char **c, struct pxe_menu *cfg)
 
 	while (1) {
 		s = *c;
-		get_token(c, &t, L_KEYWORD);
+		get_token(arena, c, &t, L_KEYWORD);
 
 		err = 0;
 		switch (t.type) {
@@ -1235,51 +1207,52 @@ static int parse_label(char **c, struct pxe_menu *cfg)
 
 		case T_KERNEL:
 		case T_LINUX:
-			err = parse_label_kernel(c, label);
+			err = parse_label_kernel(arena, c, label);
 			break;
 
 		case T_APPEND:
-			err = parse_sliteral(c, &label->append);
-			if (label->initrd)
+			err = parse_sliteral(arena, c, &label->append);
+			if (err < 0 || label->initrd)
 				break;
 			s = strstr(label->append, "initrd=");
 			if (!s)
 				break;
 			s += 7;
-			len = (int)(strchr(s, ' ') - s);
-			label->initrd = malloc(len + 1);
-			strncpy(label->initrd, s, len);
-			label->initrd[len] = '\0';
+			label->initrd = arena_strndup(arena, s,
+						      strcspn(s, " "));
+			if (!label->initrd)
+				err = -ENOMEM;
 
 			break;
 
 		case T_INITRD:
 			if (!label->initrd)
-				err = parse_sliteral(c, &label->initrd);
+				err = parse_sliteral(arena, c, &label->initrd);
 			break;
 
 		case T_FDT:
 			if (!label->fdt)
-				err = parse_sliteral(c, &label->fdt);
+				err = parse_sliteral(arena, c, &label->fdt);
 			break;
 
 		case T_FDTDIR:
 			if (!label->fdtdir)
-				err = parse_sliteral(c, &label->fdtdir);
+				err = parse_sliteral(arena, c, &label->fdtdir);
 			break;
 
 		case T_FDTOVERLAYS:
 			if (!label->fdtoverlays)
-				err = parse_sliteral(c, &label->fdtoverlays);
+				err = parse_sliteral(arena, c,
+						     &label->fdtoverlays);
 			break;
 
 		case T_LOCALBOOT:
 			label->localboot = 1;
-			err = parse_integer(c, &label->localboot_val);
+			err = parse_integer(arena, c, &label->localboot_val);
 			break;
 
 		case T_IPAPPEND:
-			err = parse_integer(c, &label->ipappend);
+			err = parse_integer(arena, c, &label->ipappend);
 			break;
 
 		case T_KASLRSEED:
@@ -1335,7 +1308,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 	while (1) {
 		s = p;
 
-		get_token(&p, &t, L_KEYWORD);
+		get_token(cfg->arena, &p, &t, L_KEYWORD);
 
 		err = 0;
 		switch (t.type) {
@@ -1347,7 +1320,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 			break;
 
 		case T_TIMEOUT:
-			err = parse_integer(&p, &cfg->timeout);
+			err = parse_integer(cfg->arena, &p, &cfg->timeout);
 			break;
 
 		case T_LABEL:
@@ -1356,14 +1329,10 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 
 		case T_DEFAULT:
 		case T_ONTIMEOUT:
-			err = parse_sliteral(&p, &label_name);
-
-			if (label_name) {
-				if (cfg->default_label)
-					free(cfg->default_label);
+			err = parse_sliteral(cfg->arena, &p, &label_name);
 
+			if (err > 0)
 				cfg->default_label = label_name;
-			}
 
 			break;
 
@@ -1374,7 +1343,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 			break;
 
 		case T_PROMPT:
-			err = parse_integer(&p, &cfg->prompt);
+			err = parse_integer(cfg->arena, &p, &cfg->prompt);
 			// Do not fail if prompt configuration is undefined
 			if (err <  0)
 				eol_or_eof(&p);
@@ -1398,35 +1367,31 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 }
 
 /*
+ * The menu, its labels and all their strings are allocated from the menu's
+ * arena, so freeing that frees everything.
  */
 void destroy_pxe_menu(struct pxe_menu *cfg)
 {
-	struct list_head *pos, *n;
-	struct pxe_label *label;
-
-	free(cfg->title);
-	free(cfg->default_label);
-
-	list_for_each_safe(pos, n, &cfg->labels) {
-		label = list_entry(pos, struct pxe_label, list);
-
-		label_destroy(label);
-	}
-
-	free(cfg);
+	arena_free(cfg->arena);
 }
 
 struct pxe_menu *parse_pxefile(struct pxe_context *ctx, unsigned long menucfg)
 {
 	struct pxe_menu *cfg;
+	struct arena *arena;
 	char *buf;
 	int r;
 
-	cfg = malloc(sizeof(struct pxe_menu));
-	if (!cfg)
+	arena = arena_new(0);
+	if (!arena)
 		return NULL;
 
-	memset(cfg, 0, sizeof(struct pxe_menu));
+	cfg = arena_zalloc(arena, sizeof(struct pxe_menu));
+	if (!cfg) {
+		arena_free(arena);
+		return NULL;
+	}
+	cfg->arena = arena;
 
 	INIT_LIST_HEAD(&cfg->labels);
 
@@ -139,7 +139,7 @@ int vbe_simple_read_bootflow_fw(struct udevice *dev, struct bootflow *bflow)
 	}
 
 	/* set up the bootflow with the info we obtained */
-	bflow->name = strdup(fdt_get_name(buf, node, NULL));
+	bflow->name = bootflow_strdup(bflow, fdt_get_name(buf, node, NULL));
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 	bflow->blk = blk;
@@ -15,6 +15,36 @@ static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+static int do_bootstage_events(struct cmd_tbl *cmdtp, int flag, int argc,
+			       char *const argv[])
+{
+	enum bootstage_events_fmt fmt = BOOTSTAGE_EVENTS_LIST;
+	int ret;
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "clear")) {
+			bootstage_events_clear();
+			return 0;
+		} else if (!strcmp(argv[1], "chrome")) {
+			fmt = BOOTSTAGE_EVENTS_CHROME;
+		} else if (!strcmp(argv[1], "folded")) {
+			fmt = BOOTSTAGE_EVENTS_FOLDED;
+		} else {
+			return CMD_RET_USAGE;
+		}
+	}
+
+	ret = bootstage_events_show(fmt);
+	if (ret) {
+		printf("Cannot show events (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+#endif
+
 static int get_base_size(int argc, char *const argv[], ulong *basep,
 			 ulong *sizep)
 {
@@ -61,6 +91,9 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
+#if CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+	U_BOOT_CMD_MKENT(events, 2, 1, do_bootstage_events, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
 };
@@ -91,6 +124,10 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
+#if CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+	"events [chrome|folded]      - Show timing events\n"
+	"events clear                - Drop all timing events\n"
+#endif
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
 );
@@ -750,23 +750,25 @@ static int do_fdt(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
 	/* apply an overlay */
 	else if (strncmp(argv[1], "ap", 2) == 0) {
-		unsigned long addr;
+		void *blobs[CONFIG_SYS_MAXARGS];
 		struct fdt_header *blob;
-		int ret;
+		int i, ret;
 
-		if (argc != 3)
+		if (argc < 3)
 			return CMD_RET_USAGE;
 
 		if (!working_fdt)
 			return CMD_RET_FAILURE;
 
-		addr = hextoul(argv[2], NULL);
-		blob = map_sysmem(addr, 0);
-		if (!fdt_valid(&blob))
-			return CMD_RET_FAILURE;
+		for (i = 2; i < argc; i++) {
+			blob = map_sysmem(hextoul(argv[i], NULL), 0);
+			if (!fdt_valid(&blob))
+				return CMD_RET_FAILURE;
+			blobs[i - 2] = blob;
+		}
 
 		/* apply method prints messages on error */
-		ret = fdt_overlay_apply_verbose(working_fdt, blob);
+		ret = fdt_overlay_apply_batch(working_fdt, blobs, argc - 2);
 		if (ret)
 			return CMD_RET_FAILURE;
 	}
@@ -1116,7 +1118,7 @@ static int fdt_print(const char *pathp, char *prop, int depth)
 U_BOOT_LONGHELP(fdt,
 	"addr [-c] [-q] <addr> [<size>]  - Set the [control] fdt location to <addr>\n"
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
-	"fdt apply <addr>                    - Apply overlay to the DT\n"
+	"fdt apply <addr> [<addr>...]        - Apply overlay(s) to the DT\n"
 #endif
 #ifdef CONFIG_OF_BOARD_SETUP
 	"fdt boardsetup                      - Do board-specific set up\n"
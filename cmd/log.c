@@ -369,12 +369,31 @@ static int do_log_rec(struct cmd_tbl *cmdtp, int flag, int argc,
 	line = dectoul(argv[4], NULL);
 	func = argv[5];
 	msg = argv[6];
-	if (_log(cat, level, file, line, func, "%s\n", msg))
+	/* The strings are on the command line, so cannot be kept */
+	if (_log(cat, level | LOGL_TRANSIENT, file, line, func, "%s\n", msg))
 		return CMD_RET_FAILURE;
 
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(LOG_RING)
+static int do_log_ring(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	if (argc > 1) {
+		if (strcmp(argv[1], "-c"))
+			return CMD_RET_USAGE;
+		log_ring_clear();
+		return 0;
+	}
+	log_ring_flush();
+	if (log_ring_show() < 0)
+		return CMD_RET_FAILURE;
+
+	return 0;
+}
+#endif
+
 U_BOOT_LONGHELP(log,
 	"level [<level>] - get/set log level\n"
 	"categories - list log categories\n"
@@ -404,7 +423,11 @@ U_BOOT_LONGHELP(log,
 	"\tc=category, l=level, F=file, L=line number, f=function, m=msg\n"
 	"\tor 'default', or 'all' for all\n"
 	"log rec <category> <level> <file> <line> <func> <message> - "
-		"output a log record");
+		"output a log record"
+#if CONFIG_IS_ENABLED(LOG_RING)
+	"\nlog ring [-c] - show records in the ring buffer, or clear it"
+#endif
+	);
 
 U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(level, 2, 1, do_log_level),
@@ -416,4 +439,7 @@ U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(filter-remove, 4, 1, do_log_filter_remove),
 	U_BOOT_SUBCMD_MKENT(format, 2, 1, do_log_format),
 	U_BOOT_SUBCMD_MKENT(rec, 7, 1, do_log_rec),
+#if CONFIG_IS_ENABLED(LOG_RING)
+	U_BOOT_SUBCMD_MKENT(ring, 2, 1, do_log_ring),
+#endif
 );
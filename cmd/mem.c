@@ -17,6 +17,7 @@
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <div64.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
@@ -24,6 +25,7 @@
 #include <log.h>
 #include <mapmem.h>
 #include <rand.h>
+#include <time.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -31,6 +33,7 @@
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <u-boot/crc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1241,6 +1244,46 @@ mod_mem(struct cmd_tbl *cmdtp, int incrflag, int flag, int argc,
 
 #ifdef CONFIG_CMD_CRC32
 
+#ifdef CONFIG_CRC32_BENCH
+static void crc32_bench_show(const char *name, u32 crc, ulong len, ulong us)
+{
+	printf("%-6s %08x  %lu us", name, crc, us);
+	if (us)
+		printf(", %llu MiB/s", lldiv((u64)len * 1000000, us) >> 20);
+	printf("\n");
+}
+
+static int crc32_bench(int argc, char *const argv[])
+{
+	ulong addr, len, start;
+	const u8 *buf;
+	u32 crc;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	addr = hextoul(argv[0], NULL);
+	len = hextoul(argv[1], NULL);
+	buf = map_sysmem(addr, len);
+
+	start = timer_get_us();
+	crc = crc32(0, buf, len);
+	crc32_bench_show("crc32", crc, len, timer_get_us() - start);
+
+	if (IS_ENABLED(CONFIG_CRC32C)) {
+		u32 table[256];
+
+		crc32c_init(table, 0x82f63b78);
+		start = timer_get_us();
+		crc = ~crc32c_cal(~0, (const char *)buf, len, table);
+		crc32_bench_show("crc32c", crc, len, timer_get_us() - start);
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+#endif
+
 static int do_mem_crc(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -1253,6 +1296,10 @@ static int do_mem_crc(struct cmd_tbl *cmdtp, int flag, int argc,
 
 	av = argv + 1;
 	ac = argc - 1;
+#ifdef CONFIG_CRC32_BENCH
+	if (!strcmp(*av, "-b"))
+		return crc32_bench(ac - 1, av + 1);
+#endif
 #ifdef CONFIG_CRC32_VERIFY
 	if (strcmp(*av, "-v") == 0) {
 		flags |= HASH_FLAG_VERIFY | HASH_FLAG_ENV;
@@ -1360,12 +1407,19 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_CRC32
 
+#ifdef CONFIG_CRC32_BENCH
+#define CRC32_BENCH_HELP	"\n-b address count\n    - measure crc32 speed over memory area"
+#else
+#define CRC32_BENCH_HELP	""
+#endif
+
 #ifndef CONFIG_CRC32_VERIFY
 
 U_BOOT_CMD(
 	crc32,	4,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]"
+	CRC32_BENCH_HELP
 );
 
 #else	/* CONFIG_CRC32_VERIFY */
@@ -1375,6 +1429,7 @@ U_BOOT_CMD(
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
 	"-v address count crc\n    - verify crc of memory area"
+	CRC32_BENCH_HELP
 );
 
 #endif	/* CONFIG_CRC32_VERIFY */
@@ -732,6 +732,8 @@ static int do_net_stats(struct cmd_tbl *cmdtp, int flag, int argc, char *const a
 		printf("  %s: %llu\n", &strings[off], values[i]);
 		off += ETH_GSTRING_LEN;
 	};
+	kfree(values);
+	kfree(strings);
 
 	return CMD_RET_SUCCESS;
 
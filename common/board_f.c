@@ -19,6 +19,7 @@
 #include <cyclic.h>
 #include <display_options.h>
 #include <dm.h>
+#include <early_arena.h>
 #include <env.h>
 #include <env_internal.h>
 #include <event.h>
@@ -598,6 +599,22 @@ static int reserve_bootstage(void)
 	return 0;
 }
 
+static int reserve_early_arena(void)
+{
+#ifdef CONFIG_EARLY_ARENA
+	int size = early_arena_finish();
+
+	if (size) {
+		gd->start_addr_sp = reserve_stack_aligned(size);
+		gd->new_early_arena = map_sysmem(gd->start_addr_sp, size);
+		debug("Reserving %#x Bytes for early arena at: %08lx\n", size,
+		      gd->start_addr_sp);
+	}
+#endif
+
+	return 0;
+}
+
 __weak int arch_reserve_stacks(void)
 {
 	return 0;
@@ -719,6 +736,18 @@ static int reloc_bloblist(void)
 	return 0;
 }
 
+static int reloc_early_arena(void)
+{
+#ifdef CONFIG_EARLY_ARENA
+	if (gd->flags & GD_FLG_SKIP_RELOC)
+		return 0;
+	if (gd->new_early_arena)
+		return early_arena_relocate(gd->new_early_arena);
+#endif
+
+	return 0;
+}
+
 static int setup_reloc(void)
 {
 	if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
@@ -965,6 +994,7 @@ static const init_fnc_t init_sequence_f[] = {
 	reserve_global_data,
 	reserve_fdt,
 	reserve_bootstage,
+	reserve_early_arena,
 	reserve_bloblist,
 	reserve_arch,
 	reserve_stacks,
@@ -977,6 +1007,7 @@ static const init_fnc_t init_sequence_f[] = {
 	reloc_fdt,
 	reloc_bootstage,
 	reloc_bloblist,
+	reloc_early_arena,
 	setup_reloc,
 #if defined(CONFIG_X86) || defined(CONFIG_ARC)
 	copy_uboot_to_ram,
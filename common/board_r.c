@@ -154,6 +154,8 @@ static int initr_reloc_global_data(void)
 	 */
 	gd->env_addr += gd->reloc_off;
 #endif
+	/* The early environment index is in the pre-relocation malloc() pool */
+	gd_set_env_index(NULL);
 #ifdef CONFIG_EFI_LOADER
 	/*
 	 * On the ARM architecture gd is mapped to a fixed register (r9 or x18).
@@ -36,16 +36,43 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+/**
+ * struct bootstage_event - A timing event
+ *
+ * @start_us: Start time in microseconds
+ * @duration_us: Duration in microseconds
+ * @count: Number of operations merged into this event (block reads)
+ * @type: Type of event (enum bootstage_event_type)
+ * @name: Name of event, truncated if necessary
+ */
+struct bootstage_event {
+	u32 start_us;
+	u32 duration_us;
+	u16 count;
+	u8 type;
+	char name[21];
+};
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+	uint event_count;	/* Total number of events added */
+	struct bootstage_event event[CONFIG_BOOTSTAGE_EVENT_COUNT];
+#endif
 };
 
 enum {
 	BOOTSTAGE_VERSION	= 0,
 	BOOTSTAGE_MAGIC		= 0xb00757a3,
 	BOOTSTAGE_DIGITS	= 9,
+
+	/* Block reads closer together than this are merged into one event */
+	BOOTSTAGE_BURST_GAP_US	= 1000,
+
+	/* Maximum nesting of events in the folded-stack output */
+	BOOTSTAGE_EVENT_MAX_DEPTH = 16,
 };
 
 struct bootstage_hdr {
@@ -359,6 +386,222 @@ void bootstage_report(void)
 	}
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+static const char *const bootstage_event_name[BOOTSTAGE_EVENT_TYPE_COUNT] = {
+	"initcall",
+	"probe",
+	"pre_probe",
+	"post_probe",
+	"blk_read",
+	"sparse_write",
+};
+
+ulong bootstage_event_start(void)
+{
+	/* The timer may not be usable until bootstage is set up */
+	if (!gd->bootstage)
+		return 0;
+
+	return timer_get_boot_us();
+}
+
+void bootstage_event_end(enum bootstage_event_type type, const char *name,
+			 ulong start_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_event *ev;
+	u32 now;
+
+	if (!data || !start_us)
+		return;
+	now = timer_get_boot_us();
+
+	if (type == BOOTSTAGE_EVENT_BLK_READ && data->event_count) {
+		ev = &data->event[(data->event_count - 1) %
+				  CONFIG_BOOTSTAGE_EVENT_COUNT];
+		if (ev->type == type && ev->count != U16_MAX &&
+		    (u32)start_us - (ev->start_us + ev->duration_us) <
+		    BOOTSTAGE_BURST_GAP_US &&
+		    !strncmp(ev->name, name, sizeof(ev->name) - 1)) {
+			ev->duration_us = now - ev->start_us;
+			ev->count++;
+			return;
+		}
+	}
+
+	ev = &data->event[data->event_count++ % CONFIG_BOOTSTAGE_EVENT_COUNT];
+	ev->start_us = start_us;
+	ev->duration_us = now - (u32)start_us;
+	ev->count = 1;
+	ev->type = type;
+	strlcpy(ev->name, name, sizeof(ev->name));
+}
+
+void bootstage_events_clear(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+	if (data)
+		data->event_count = 0;
+}
+
+static int h_compare_event(const void *e1, const void *e2)
+{
+	const struct bootstage_event *ev1 = e1, *ev2 = e2;
+
+	/* Put the outer event first if two start at the same time */
+	if (ev1->start_us != ev2->start_us)
+		return ev1->start_us < ev2->start_us ? -1 : 1;
+	if (ev1->duration_us != ev2->duration_us)
+		return ev1->duration_us > ev2->duration_us ? -1 : 1;
+
+	return 0;
+}
+
+static void show_event_list(const struct bootstage_event *events, int count)
+{
+	const struct bootstage_event *ev;
+	int i;
+
+	printf("%11s%11s%6s  %s\n", "Start", "Elapsed", "Count", "Event");
+	for (i = 0, ev = events; i < count; i++, ev++) {
+		print_grouped_ull(ev->start_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(ev->duration_us, BOOTSTAGE_DIGITS);
+		printf("%6u  %s:%s\n", ev->count, bootstage_event_name[ev->type],
+		       ev->name);
+	}
+}
+
+/* Write a string for use inside a JSON string, escaping as needed */
+static void print_json_str(const char *str)
+{
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			printf("\\u%04x", *str);
+		else
+			putc(*str);
+	}
+}
+
+static void show_event_chrome(const struct bootstage_event *events, int count)
+{
+	const struct bootstage_event *ev;
+	int i;
+
+	printf("[\n");
+	for (i = 0, ev = events; i < count; i++, ev++) {
+		printf("{\"name\":\"%s:", bootstage_event_name[ev->type]);
+		print_json_str(ev->name);
+		printf("\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":1,\"tid\":1,\"args\":{\"count\":%u}}%s\n",
+		       bootstage_event_name[ev->type], ev->start_us,
+		       ev->duration_us, ev->count, i < count - 1 ? "," : "");
+	}
+	printf("]\n");
+}
+
+/*
+ * Each line gives the names of the event and all events containing it,
+ * outermost first, followed by the time spent in the event but not in any
+ * other event inside it. The events must be sorted by h_compare_event().
+ */
+static int show_event_folded(const struct bootstage_event *events, int count)
+{
+	const struct bootstage_event *ev;
+	int stack[BOOTSTAGE_EVENT_MAX_DEPTH];
+	int *parent;
+	u32 *self;
+	int depth, i;
+
+	parent = malloc(count * (sizeof(*parent) + sizeof(*self)));
+	if (!parent)
+		return -ENOMEM;
+	self = (u32 *)(parent + count);
+
+	for (i = 0, depth = 0, ev = events; i < count; i++, ev++) {
+		u32 end = ev->start_us + ev->duration_us;
+
+		/* Drop events which do not contain this one */
+		while (depth) {
+			const struct bootstage_event *top = &events[stack[depth - 1]];
+
+			if (end <= top->start_us + top->duration_us)
+				break;
+			depth--;
+		}
+		parent[i] = depth ? stack[depth - 1] : -1;
+		if (parent[i] != -1)
+			self[parent[i]] -= ev->duration_us;
+		self[i] = ev->duration_us;
+		if (depth < BOOTSTAGE_EVENT_MAX_DEPTH)
+			stack[depth++] = i;
+	}
+
+	for (i = 0; i < count; i++) {
+		int p;
+
+		if (!self[i])
+			continue;
+		for (depth = 0, p = i;
+		     p != -1 && depth < BOOTSTAGE_EVENT_MAX_DEPTH;
+		     p = parent[p])
+			stack[depth++] = p;
+		while (depth--) {
+			ev = &events[stack[depth]];
+			printf("%s:%s%c", bootstage_event_name[ev->type], ev->name,
+			       depth ? ';' : ' ');
+		}
+		printf("%u\n", self[i]);
+	}
+	free(parent);
+
+	return 0;
+}
+
+int bootstage_events_show(enum bootstage_events_fmt fmt)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_event *events;
+	uint count, first, i;
+	int ret = 0;
+
+	if (!data)
+		return -ENOENT;
+	count = min(data->event_count, (uint)CONFIG_BOOTSTAGE_EVENT_COUNT);
+	if (!count)
+		return 0;
+
+	/* Take a copy, oldest first, so that the ring can be sorted */
+	events = malloc(count * sizeof(*events));
+	if (!events)
+		return -ENOMEM;
+	first = data->event_count - count;
+	for (i = 0; i < count; i++)
+		events[i] = data->event[(first + i) %
+					CONFIG_BOOTSTAGE_EVENT_COUNT];
+	qsort(events, count, sizeof(*events), h_compare_event);
+
+	switch (fmt) {
+	case BOOTSTAGE_EVENTS_LIST:
+		show_event_list(events, count);
+		if (data->event_count > count)
+			printf("Overwrote %u older events\n",
+			       data->event_count - count);
+		break;
+	case BOOTSTAGE_EVENTS_CHROME:
+		show_event_chrome(events, count);
+		break;
+	case BOOTSTAGE_EVENTS_FOLDED:
+		ret = show_event_folded(events, count);
+		break;
+	}
+	free(events);
+
+	return ret;
+}
+#endif /* BOOTSTAGE_EVENTS */
+
 /**
  * Append data to a memory buffer
  *
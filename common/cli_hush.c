@@ -335,6 +335,9 @@ struct in_str {
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	struct hush_cache_entry *cache;	/* entry to record parse trees in */
+#endif
 };
 #define b_getch(input) ((input)->get(input))
 #define b_peek(input) ((input)->peek(input))
@@ -1160,6 +1163,9 @@ static void setup_file_in_str(struct in_str *i)
 	i->file = f;
 #endif
 	i->p = NULL;
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	i->cache = NULL;
+#endif
 }
 
 static void setup_string_in_str(struct in_str *i, const char *s)
@@ -1169,6 +1175,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	i->cache = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1586,6 +1595,11 @@ static int run_pipe_real(struct pipe *pi)
 #endif
 		return rcode;
 	} else if (pi->num_progs == 1 && pi->progs[0].argv != NULL) {
+#ifdef __U_BOOT__
+		/* the parse tree may be cached, so count here, not in child */
+		int sp = child->sp;
+#endif
+
 		for (i=0; is_assignment(child->argv[i]); i++) { /* nothing */ }
 		if (i!=0 && child->argv[i]==NULL) {
 			/* assignments, but no command: set the local environment */
@@ -1624,11 +1638,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1761,6 +1775,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1800,7 +1815,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1830,6 +1846,7 @@ static int run_list_real(struct pipe *pi)
 					pi->progs->argv[0]);
 				save_list = list;
 				save_name = pi->progs->argv[0];
+				save_pipe = pi;
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
 			}
@@ -1899,7 +1916,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code = rcode;
 #endif
@@ -1919,6 +1937,17 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/* Left part-way through a "for" loop: put back the variable name */
+	if (list) {
+		while (*list)
+			free(*list++);
+		free(save_pipe->progs->argv[0]);
+		save_pipe->progs->argv[0] = save_name;
+		free(save_list);
+	}
+#endif
 	return rcode;
 }
 
@@ -2029,6 +2058,190 @@ static int run_list(struct pipe *pi)
 	return rcode;
 }
 
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+/*
+ * Cache of parse trees, so that strings which are run repeatedly, such as
+ * boot scripts, variables used with 'run' and commands in loops (which are
+ * expanded and reparsed on each pass), are only parsed once.
+ *
+ * Each entry holds the pipe lists for all the lines in a string, in order, as
+ * parsed with a particular flag. Running a list leaves it as it was, so it can
+ * be run again. Entries are found by hashing the text and then comparing it,
+ * so they never go stale; when the cache is full, the least recently used
+ * entry is replaced. An entry is marked busy while it is being recorded or
+ * run, so that a nested use of the same string parses it afresh.
+ */
+struct hush_cache_entry {
+	char *text;
+	uint hash;
+	int flag;
+	int busy;
+	int bad;		/* parse failed, so do not keep this */
+	ulong last_used;
+	int num_lists;
+	struct pipe **lists;
+};
+
+static struct hush_cache_entry hush_cache[CONFIG_HUSH_CACHE_ENTRIES];
+static struct hush_cache_stats hush_cache_stats;
+static ulong hush_cache_tick;
+
+static uint hush_cache_hash(const char *s)
+{
+	uint hash = 5381;
+
+	while (*s)
+		hash = hash * 33 + (uchar)*s++;
+
+	return hash;
+}
+
+static void hush_cache_free(struct hush_cache_entry *ent)
+{
+	int i;
+
+	for (i = 0; i < ent->num_lists; i++)
+		free_pipe_list(ent->lists[i], 0);
+	free(ent->lists);
+	free(ent->text);
+	memset(ent, '\0', sizeof(*ent));
+}
+
+/* Find a cached entry for @s, or return NULL if none can be used */
+static struct hush_cache_entry *hush_cache_find(const char *s, uint hash,
+						int flag)
+{
+	struct hush_cache_entry *ent;
+
+	for (ent = hush_cache; ent < hush_cache + ARRAY_SIZE(hush_cache);
+	     ent++) {
+		if (ent->text && ent->hash == hash && ent->flag == flag &&
+		    !ent->busy && !strcmp(ent->text, s))
+			return ent;
+	}
+
+	return NULL;
+}
+
+/*
+ * Set up an entry to record the parse trees for @s, returning NULL if it
+ * should not be cached
+ */
+static struct hush_cache_entry *hush_cache_new(const char *s, uint hash,
+					       int flag)
+{
+	struct hush_cache_entry *ent, *lru = NULL;
+
+	/* The cache lives in BSS and the parse depends on IFS */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) || env_get("IFS"))
+		return NULL;
+
+	for (ent = hush_cache; ent < hush_cache + ARRAY_SIZE(hush_cache);
+	     ent++) {
+		/* A busy entry for the same string is already in use */
+		if (ent->busy) {
+			if (ent->hash == hash && ent->flag == flag &&
+			    !strcmp(ent->text, s))
+				return NULL;
+			continue;
+		}
+		if (!ent->text) {
+			lru = ent;
+			break;
+		}
+		if (!lru || ent->last_used < lru->last_used)
+			lru = ent;
+	}
+	if (!lru)
+		return NULL;
+	if (lru->text) {
+		hush_cache_free(lru);
+		hush_cache_stats.evictions++;
+	}
+	lru->text = strdup(s);
+	if (!lru->text)
+		return NULL;
+	lru->hash = hash;
+	lru->flag = flag;
+	lru->busy = 1;
+	lru->last_used = ++hush_cache_tick;
+
+	return lru;
+}
+
+/* Add a pipe list to the entry being recorded; returns 0 if OK */
+static int hush_cache_add(struct hush_cache_entry *ent, struct pipe *pi)
+{
+	struct pipe **lists;
+
+	lists = realloc(ent->lists, (ent->num_lists + 1) * sizeof(*lists));
+	if (!lists) {
+		ent->bad = 1;
+		return -ENOMEM;
+	}
+	ent->lists = lists;
+	ent->lists[ent->num_lists++] = pi;
+
+	return 0;
+}
+
+/* Finish recording an entry, dropping it if parsing failed */
+static void hush_cache_done(struct hush_cache_entry *ent)
+{
+	if (ent->bad)
+		hush_cache_free(ent);
+	else
+		ent->busy = 0;
+}
+
+/* Run all the pipe lists in an entry, like parse_stream_outer() */
+static int hush_cache_run(struct hush_cache_entry *ent)
+{
+	int code = 1;
+	int i;
+
+	ent->busy = 1;
+	ent->last_used = ++hush_cache_tick;
+	for (i = 0; i < ent->num_lists; i++) {
+		code = run_list_real(ent->lists[i]);
+		if (code == -2)		/* exit */
+			break;
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	ent->busy = 0;
+	if (code == -2)
+		return -2;
+
+	return (code != 0) ? 1 : 0;
+}
+
+/* Run a pipe list, keeping it if the input is being recorded */
+static int run_list_cached(struct in_str *inp, struct pipe *pi)
+{
+	if (inp->cache && !inp->cache->bad && !hush_cache_add(inp->cache, pi))
+		return run_list_real(pi);
+
+	return run_list(pi);
+}
+
+void hush_cache_get_stats(struct hush_cache_stats *stats)
+{
+	*stats = hush_cache_stats;
+}
+
+void hush_cache_flush(void)
+{
+	struct hush_cache_entry *ent;
+
+	for (ent = hush_cache; ent < hush_cache + ARRAY_SIZE(hush_cache);
+	     ent++) {
+		if (ent->text && !ent->busy)
+			hush_cache_free(ent);
+	}
+}
+#endif
+
 /* The API for glob is arguably broken.  This routine pushes a non-matching
  * string into the output structure, removing non-backslashed backslashes.
  * If someone can prove me wrong, by performing this function within the
@@ -3207,9 +3420,18 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			done_pipe(&ctx,PIPE_SEQ);
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
+#else
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+			code = run_list_cached(inp, ctx.list_head);
 #else
 			code = run_list(ctx.list_head);
+#endif
 			if (code == -2) {	/* exit */
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+				/* the rest of the input is not parsed */
+				if (inp->cache)
+					inp->cache->bad = 1;
+#endif
 				b_free(&temp);
 				code = 0;
 				/* XXX hackish way to not allow exit from main loop */
@@ -3238,6 +3460,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifdef __U_BOOT__
 			if (inp->__promptme == 0) printf("<INTERRUPT>\n");
 			inp->__promptme = 1;
+#endif
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+			if (inp->cache)
+				inp->cache->bad = 1;
 #endif
 			temp.nonnull = 0;
 			temp.quote = 0;
@@ -3265,22 +3491,51 @@ int parse_string_outer(const char *s, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	char *p = NULL;
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	struct hush_cache_entry *ent;
+	uint hash;
+#endif
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	hash = hush_cache_hash(s);
+	ent = hush_cache_find(s, hash, flag);
+	if (ent) {
+		hush_cache_stats.hits++;
+		rcode = hush_cache_run(ent);
+		return rcode == -2 ? last_return_code : rcode;
+	}
+	hush_cache_stats.misses++;
+	ent = hush_cache_new(s, hash, flag);
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+		input.cache = ent;
+#endif
 		rcode = parse_stream_outer(&input, flag);
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+		if (ent)
+			hush_cache_done(ent);
+#endif
 		free(p);
 		return rcode == -2 ? last_return_code : rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	input.cache = ent;
+#endif
 	rcode = parse_stream_outer(&input, flag);
+#if CONFIG_IS_ENABLED(HUSH_CACHE)
+	if (ent)
+		hush_cache_done(ent);
+#endif
 	return rcode == -2 ? last_return_code : rcode;
 #ifdef __U_BOOT__
 	}
@@ -40,6 +40,8 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		goto err_detach;
 	}
 
+	dfu_set_write_behind(true);
+
 #ifdef CONFIG_DFU_TIMEOUT
 	unsigned long start_time = get_timer(0);
 #endif
@@ -88,6 +90,17 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 			}
 		}
 
+		/*
+		 * Write out a buffer filled by earlier DFU_DNLOAD requests.
+		 * This is done here rather than in the request itself, so that
+		 * the host can carry on sending data into the next buffer.
+		 */
+		ret = dfu_write_pending();
+		if (ret) {
+			pr_err("DFU write failed!");
+			goto exit;
+		}
+
 #ifdef CONFIG_DFU_TIMEOUT
 		unsigned long wait_time = dfu_get_timeout();
 
@@ -108,6 +121,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		dm_usb_gadget_handle_interrupts(udc);
 	}
 exit:
+	dfu_set_write_behind(false);
 	g_dnl_unregister();
 err_detach:
 	udc_device_put(udc);
@@ -608,6 +608,9 @@ void *sbrk(ptrdiff_t increment)
 
 void mem_malloc_init(ulong start, ulong size)
 {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	size -= malloc_slab_init(start, size);
+#endif
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
@@ -1270,10 +1273,33 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 
 */
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+static Void_t *dl_malloc(size_t bytes);
+
+/*
+  Small requests are served from the slab region if possible. This is
+  skipped in test mode so that the dlmalloc() path counts the calls.
+*/
+Void_t *mALLOc(size_t bytes)
+{
+	Void_t *mem;
+
+	if (!malloc_testing) {
+		mem = malloc_slab_alloc(bytes);
+		if (mem)
+			return mem;
+	}
+
+	return dl_malloc(bytes);
+}
+#else
+#define dl_malloc mALLOc
+#endif
+
 #if __STD_C
-Void_t* mALLOc(size_t bytes)
+Void_t* dl_malloc(size_t bytes)
 #else
-Void_t* mALLOc(bytes) size_t bytes;
+Void_t* dl_malloc(bytes) size_t bytes;
 #endif
 {
   mchunkptr victim;                  /* inspected/selected chunk */
@@ -1583,6 +1609,11 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (malloc_slab_free(mem))
+    return;
+#endif
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1742,6 +1773,21 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (malloc_slab_owns(oldmem))
+  {
+    oldsize = malloc_slab_usable_size(oldmem);
+    if (bytes <= oldsize)
+      return oldmem;
+    newmem = mALLOc(bytes);
+    if (!newmem)
+      return NULL;
+    memcpy(newmem, oldmem, oldsize);
+    fREe(oldmem);
+    return newmem;
+  }
+#endif
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1869,7 +1915,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
     /* Must allocate */
 
-    newmem = mALLOc (bytes);
+    newmem = dl_malloc(bytes);
 
     if (newmem == NULL)  /* propagate failure */
       return NULL;
@@ -1974,7 +2020,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(dl_malloc(nb + alignment + MINSIZE));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -1990,7 +2036,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(dl_malloc(bytes));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -2001,7 +2047,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(dl_malloc(bytes + extra));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2158,6 +2204,13 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		memset(mem, 0, sz);
 		return mem;
 	}
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+    if (malloc_slab_owns(mem))
+    {
+      memset(mem, 0, sz);
+      return mem;
+    }
 #endif
     p = mem2chunk(mem);
 
@@ -2307,6 +2360,10 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  else if (malloc_slab_owns(mem))
+    return malloc_slab_usable_size(mem);
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2396,6 +2453,9 @@ void malloc_stats(void)
   printf("max mmap regions = %10u\n",
 	  (unsigned int)max_n_mmaps);
 #endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  malloc_slab_stats();
+#endif
 }
 #endif	/* DEBUG */
 
@@ -2406,8 +2466,14 @@ void malloc_stats(void)
 #ifdef DEBUG
 struct mallinfo mALLINFo(void)
 {
+  struct mallinfo info;
+
   malloc_update_mallinfo();
-  return current_mallinfo;
+  info = current_mallinfo;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  malloc_slab_mallinfo(&info);
+#endif
+  return info;
 }
 #endif	/* DEBUG */
 
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Allocations made before relocation which are kept afterwards
+ *
+ * The pre-relocation malloc() pool is abandoned at relocation, so anything
+ * which is expensive to work out (e.g. DRAM-training results) would otherwise
+ * need to be recalculated. The early arena is a small region allocated from
+ * that pool which is copied to the top of RAM along with global_data. Pointers
+ * into the arena can be registered so that they are adjusted when it moves.
+ */
+
+#define LOG_CATEGORY	LOGC_BOARD
+
+#include <common.h>
+#include <early_arena.h>
+#include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	EARLY_ARENA_ALIGN	= 16,
+};
+
+/**
+ * struct early_arena_hdr - Header at the start of the early arena
+ *
+ * Offsets are from the start of the header. An offset of 0 means 'none'.
+ *
+ * @size: Total size of the arena in bytes, including this header
+ * @used: Number of bytes used, including this header
+ * @fixups: Offset of the most recently added struct early_arena_fixup
+ * @ofs: Offset of the allocation for each ID
+ * @len: Size of the allocation for each ID
+ */
+struct early_arena_hdr {
+	u32 size;
+	u32 used;
+	u32 fixups;
+	u32 ofs[EARLY_ARENA_ID_COUNT];
+	u32 len[EARLY_ARENA_ID_COUNT];
+};
+
+/**
+ * struct early_arena_fixup - Records a pointer to update on relocation
+ *
+ * @next: Offset of the next fixup, or 0 if none
+ * @ofs: Offset of the pointer, from the start of global_data or the arena
+ * @in_gd: true if the pointer is in global_data, false if in the arena
+ */
+struct early_arena_fixup {
+	u32 next;
+	u32 ofs;
+	u32 in_gd;
+};
+
+static struct early_arena_hdr *early_arena_get(bool create)
+{
+	void *base;
+
+	if (!gd->early_arena && create && !(gd->flags & GD_FLG_RELOC)) {
+		base = malloc(CONFIG_EARLY_ARENA_SIZE);
+		if (!base || early_arena_init(base, CONFIG_EARLY_ARENA_SIZE))
+			log_debug("Cannot create early arena\n");
+	}
+
+	return gd->early_arena;
+}
+
+/* Take space from the end of the arena, returning its offset, or 0 if full */
+static uint early_arena_take(struct early_arena_hdr *hdr, int size)
+{
+	uint ofs = ALIGN(hdr->used, EARLY_ARENA_ALIGN);
+
+	if (size < 0 || ofs + size > hdr->size)
+		return 0;
+	hdr->used = ofs + size;
+	memset((char *)hdr + ofs, '\0', size);
+
+	return ofs;
+}
+
+int early_arena_init(void *base, int size)
+{
+	struct early_arena_hdr *hdr = base;
+
+	if (size < sizeof(*hdr))
+		return -ENOSPC;
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->size = size;
+	hdr->used = sizeof(*hdr);
+	gd->early_arena = hdr;
+
+	return 0;
+}
+
+void *early_arena_alloc(enum early_arena_id id, int size)
+{
+	struct early_arena_hdr *hdr;
+	uint ofs;
+
+	if (id <= EARLY_ARENA_NONE || id >= EARLY_ARENA_ID_COUNT)
+		return NULL;
+	hdr = early_arena_get(true);
+	if (!hdr || hdr->ofs[id])
+		return NULL;
+	ofs = early_arena_take(hdr, size);
+	if (!ofs) {
+		log_debug("No space for %x bytes (id %d)\n", size, id);
+		return NULL;
+	}
+	hdr->ofs[id] = ofs;
+	hdr->len[id] = size;
+
+	return (char *)hdr + ofs;
+}
+
+void *early_arena_find(enum early_arena_id id, int *sizep)
+{
+	struct early_arena_hdr *hdr = early_arena_get(false);
+
+	if (!hdr || id <= EARLY_ARENA_NONE || id >= EARLY_ARENA_ID_COUNT ||
+	    !hdr->ofs[id])
+		return NULL;
+	if (sizep)
+		*sizep = hdr->len[id];
+
+	return (char *)hdr + hdr->ofs[id];
+}
+
+int early_arena_add_ptr(void **ptrp)
+{
+	struct early_arena_hdr *hdr = early_arena_get(false);
+	struct early_arena_fixup *fix;
+	ulong ptr = (ulong)ptrp;
+	ulong start, ofs;
+	bool in_gd;
+
+	if (!hdr)
+		return -ENOENT;
+	start = (ulong)hdr;
+	if (ptr >= (ulong)gd && ptr + sizeof(void *) <= (ulong)(gd + 1))
+		in_gd = true;
+	else if (ptr >= start && ptr + sizeof(void *) <= start + hdr->used)
+		in_gd = false;
+	else
+		return -EINVAL;
+
+	ofs = early_arena_take(hdr, sizeof(*fix));
+	if (!ofs)
+		return -ENOSPC;
+	fix = (void *)hdr + ofs;
+	fix->ofs = ptr - (in_gd ? (ulong)gd : start);
+	fix->in_gd = in_gd;
+	fix->next = hdr->fixups;
+	hdr->fixups = ofs;
+
+	return 0;
+}
+
+int early_arena_finish(void)
+{
+	struct early_arena_hdr *hdr = early_arena_get(false);
+
+	if (!hdr)
+		return 0;
+	hdr->size = hdr->used;
+
+	return hdr->used;
+}
+
+int early_arena_relocate(void *new_base)
+{
+	struct early_arena_hdr *hdr = early_arena_get(false);
+	struct early_arena_hdr *new = new_base;
+	struct early_arena_fixup *fix;
+	ulong start, end;
+	long delta;
+	uint ofs;
+
+	if (!hdr)
+		return -ENOENT;
+	start = (ulong)hdr;
+	end = start + hdr->used;
+	delta = (ulong)new - start;
+	log_debug("Relocating early arena from %lx to %p, size %x\n", start,
+		  new, hdr->used);
+	memmove(new, hdr, hdr->used);
+	new->size = new->used;
+
+	for (ofs = new->fixups; ofs; ofs = fix->next) {
+		void *base;
+		ulong *ptrp;
+
+		fix = (void *)new + ofs;
+		base = fix->in_gd ? (void *)gd : (void *)new;
+		ptrp = base + fix->ofs;
+		if (*ptrp >= start && *ptrp < end)
+			*ptrp += delta;
+	}
+	gd->early_arena = new;
+
+	return 0;
+}
@@ -207,6 +207,7 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 {
 	struct log_device *ldev;
 	char buf[CONFIG_SYS_CBSIZE];
+	bool deferred = false;
 
 	/*
 	 * When a log driver writes messages (e.g. via the network stack) this
@@ -221,16 +222,35 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
 		if ((ldev->flags & LOGDF_ENABLE) &&
 		    log_passes_filters(ldev, rec)) {
-			if (!rec->msg) {
-				int len;
-
-				len = vsnprintf(buf, sizeof(buf), fmt, args);
-				rec->msg = buf;
-				gd->log_cont = len && buf[len - 1] != '\n';
+			va_list copy;
+
+			/* Each device may need its own pass over the args */
+			va_copy(copy, args);
+			if (ldev->drv->emit_fmt) {
+				ldev->drv->emit_fmt(ldev, rec, fmt, copy);
+				deferred = true;
+			} else {
+				if (!rec->msg) {
+					int len;
+
+					len = vsnprintf(buf, sizeof(buf), fmt,
+							copy);
+					rec->msg = buf;
+					gd->log_cont = len &&
+						buf[len - 1] != '\n';
+				}
+				ldev->drv->emit(ldev, rec);
 			}
-			ldev->drv->emit(ldev, rec);
+			va_end(copy);
 		}
 	}
+
+	/* Without a formatted message, assume the format gives the ending */
+	if (deferred && !rec->msg) {
+		int len = strlen(fmt);
+
+		gd->log_cont = len && fmt[len - 1] != '\n';
+	}
 	gd->processing_msg = false;
 	return 0;
 }
@@ -255,6 +275,8 @@ int _log(enum log_category_t cat, enum log_level_t level, const char *file,
 	rec.flags = 0;
 	if (level & LOGL_FORCE_DEBUG)
 		rec.flags |= LOGRECF_FORCE_DEBUG;
+	if (level & LOGL_TRANSIENT)
+		rec.flags |= LOGRECF_TRANSIENT;
 	if (gd->log_cont)
 		rec.flags |= LOGRECF_CONT;
 	rec.file = file;
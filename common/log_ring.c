@@ -0,0 +1,765 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log to a ring buffer, formatting messages only when they are needed
+ *
+ * Formatting a message and writing it to a slow serial console can take much
+ * longer than the code which generates it. This driver stores each record in
+ * binary form: the format-string pointer is kept along with a copy of the
+ * arguments and the message is only formatted when the record is shown,
+ * exported or drained to the console.
+ *
+ * With CONFIG_LOG_RING_DRAIN the console log driver is disabled and records
+ * are written to the console by a cyclic function, a little at a time, when
+ * U-Boot is otherwise idle.
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <cyclic.h>
+#include <event.h>
+#include <log.h>
+#include <malloc.h>
+#include <time.h>
+#include <asm/global_data.h>
+#include <linux/ctype.h>
+#include <linux/kernel.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* How often to drain records to the console, in microseconds */
+#define LOG_RING_DRAIN_US	1000
+
+/* Characters to write to the console in one go while draining */
+#define LOG_RING_DRAIN_CHUNK	16
+
+/* Largest message (or set of arguments) stored for a record */
+#define LOG_RING_MAX_DATA	CONFIG_SYS_CBSIZE
+
+/* Space for the record prefix added by log_ring_line() */
+#define LOG_RING_LINE_SIZE	(LOG_RING_MAX_DATA + 100)
+
+enum log_ring_type {
+	LOG_RING_ARGS,		/* @data holds the arguments for @fmt */
+	LOG_RING_MSG,		/* @data holds the message */
+	LOG_RING_PAD,		/* Unused space up to the end of the buffer */
+};
+
+/**
+ * struct log_ring_rec - A record in the ring buffer
+ *
+ * @size: Total size of the record in bytes, including this header
+ * @type: Type of record (enum log_ring_type)
+ * @level: Log level (enum log_level_t)
+ * @flags: Flags from the log record (enum log_rec_flags)
+ * @cat: Log category (enum log_category_t)
+ * @line: Source line number
+ * @file: Source file name. For a LOG_RING_MSG record with LOGRECF_TRANSIENT,
+ *	this is NULL and the name follows the message in @data
+ * @func: Function name, stored in the same way as @file
+ * @fmt: Format string (LOG_RING_ARGS only)
+ * @data: Arguments or message
+ */
+struct log_ring_rec {
+	u32 size;
+	u8 type;
+	u8 level;
+	u8 flags;
+	u16 cat;
+	u16 line;
+	const char *file;
+	const char *func;
+	const char *fmt;
+	char data[];
+};
+
+/* Records are aligned so that the header can be accessed directly */
+#define LOG_RING_ALIGN		sizeof(void *)
+
+/**
+ * struct log_ring - Information about the ring buffer
+ *
+ * Positions count bytes written since the buffer was set up, so do not wrap
+ * around. The offset in @buf is the position modulo @size
+ *
+ * @buf: Buffer holding the records
+ * @size: Size of @buf in bytes
+ * @head: Position at which the next record is written
+ * @tail: Position of the oldest record
+ * @drain: Position of the next record to drain to the console
+ * @skip: true if the next record stored has already been written to the
+ *	console
+ * @cyclic: Cyclic function which drains records, or NULL if none
+ * @line: Line being written to the console while draining
+ * @line_pos: Number of characters of @line which have been written
+ * @line_len: Length of @line
+ */
+struct log_ring {
+	char *buf;
+	ulong size;
+	ulong head;
+	ulong tail;
+	ulong drain;
+	bool skip;
+	struct cyclic_info *cyclic;
+	char *line;
+	int line_pos;
+	int line_len;
+};
+
+static struct log_ring log_ring;
+
+enum log_ring_arg {
+	ARG_NONE,
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_PTR,
+	ARG_STR,
+	ARG_BAD,		/* Cannot be deferred */
+};
+
+/**
+ * struct log_ring_spec - A conversion specification in a format string
+ *
+ * @start: Start of the specification (the '%')
+ * @len: Length of the specification
+ * @stars: Number of '*' (width or precision) arguments
+ * @star_prec: true if the last '*' gives the precision
+ * @prec: Precision given in the format string, or -1 if none
+ * @arg: Type of argument (enum log_ring_arg)
+ */
+struct log_ring_spec {
+	const char *start;
+	int len;
+	int stars;
+	bool star_prec;
+	int prec;
+	enum log_ring_arg arg;
+};
+
+/*
+ * Parse the next conversion in a format string, following vsnprintf(). This
+ * updates *@fmtp to point after the conversion and returns false if there is
+ * none
+ */
+static bool log_ring_next_spec(const char **fmtp, struct log_ring_spec *spec)
+{
+	const char *p = strchr(*fmtp, '%');
+	int qualifier = 0;
+
+	if (!p)
+		return false;
+	spec->start = p++;
+	spec->stars = 0;
+	spec->star_prec = false;
+	spec->prec = -1;
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	if (*p == '*') {
+		spec->stars++;
+		p++;
+	} else {
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->stars++;
+			spec->star_prec = true;
+			p++;
+		} else {
+			spec->prec = 0;
+			while (isdigit(*p))
+				spec->prec = spec->prec * 10 + *p++ - '0';
+		}
+	}
+	if (*p && strchr("hlLZzt", *p)) {
+		qualifier = *p++;
+		if (qualifier == 'l' && *p == 'l') {
+			qualifier = 'L';
+			p++;
+		}
+	}
+
+	switch (*p) {
+	case '%':
+		spec->arg = ARG_NONE;
+		break;
+	case 'c':
+		spec->arg = ARG_INT;
+		break;
+	case 's':
+		spec->arg = qualifier == 'l' ? ARG_BAD : ARG_STR;
+		break;
+	case 'p':
+		/* Extensions such as %pM are formatted straight away */
+		spec->arg = isalnum(p[1]) ? ARG_BAD : ARG_PTR;
+		break;
+	case 'd':
+		if (p[1] == 'E') {
+			spec->arg = ARG_BAD;
+			break;
+		}
+		/* fallthrough */
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		if (qualifier == 'L')
+			spec->arg = ARG_LLONG;
+		else if (qualifier && strchr("lZzt", qualifier))
+			spec->arg = ARG_LONG;
+		else
+			spec->arg = ARG_INT;
+		break;
+	default:
+		spec->arg = ARG_BAD;
+		break;
+	}
+	if (*p)
+		p++;
+	spec->len = p - spec->start;
+	*fmtp = p;
+
+	return true;
+}
+
+/*
+ * Copy the arguments needed by @fmt into @data, returning the number of bytes
+ * used, or -E2BIG if they cannot be stored
+ */
+static int log_ring_save_args(char *data, int size, const char *fmt,
+			      va_list args)
+{
+	struct log_ring_spec spec;
+	int len = 0, prec, i;
+	long long llval;
+	const char *str;
+	long lval;
+	void *ptr;
+	int ival;
+
+#define SAVE(val) do {					\
+		if (len + sizeof(val) > size)		\
+			return -E2BIG;			\
+		memcpy(data + len, &val, sizeof(val));	\
+		len += sizeof(val);			\
+	} while (0)
+
+	while (log_ring_next_spec(&fmt, &spec)) {
+		prec = spec.prec;
+		for (i = 0; i < spec.stars; i++) {
+			ival = va_arg(args, int);
+			SAVE(ival);
+			if (spec.star_prec && i == spec.stars - 1)
+				prec = ival;
+		}
+		switch (spec.arg) {
+		case ARG_NONE:
+			break;
+		case ARG_INT:
+			ival = va_arg(args, int);
+			SAVE(ival);
+			break;
+		case ARG_LONG:
+			lval = va_arg(args, long);
+			SAVE(lval);
+			break;
+		case ARG_LLONG:
+			llval = va_arg(args, long long);
+			SAVE(llval);
+			break;
+		case ARG_PTR:
+			ptr = va_arg(args, void *);
+			SAVE(ptr);
+			break;
+		case ARG_STR:
+			str = va_arg(args, const char *);
+			if (!str)
+				str = "<NULL>";
+			i = prec >= 0 ? strnlen(str, prec) : strlen(str);
+			if (len + i + 1 > size)
+				return -E2BIG;
+			memcpy(data + len, str, i);
+			data[len + i] = '\0';
+			len += i + 1;
+			break;
+		case ARG_BAD:
+			return -E2BIG;
+		}
+	}
+#undef SAVE
+
+	return len;
+}
+
+/* Format the message for a LOG_RING_ARGS record */
+static int log_ring_format_args(const struct log_ring_rec *lrec, char *buf,
+				int size)
+{
+	const char *fmt = lrec->fmt, *data = lrec->data;
+	struct log_ring_spec spec;
+	int len = 0, ret, i;
+	char conv[32];
+	long long llval;
+	int star[2];
+	long lval;
+	void *ptr;
+	int ival;
+
+#define LOAD(val) do {					\
+		memcpy(&val, data, sizeof(val));	\
+		data += sizeof(val);			\
+	} while (0)
+#define OUT(val) (spec.stars == 2 ?					\
+	snprintf(buf + len, size - len, conv, star[0], star[1], val) :	\
+	spec.stars ? snprintf(buf + len, size - len, conv, star[0], val) : \
+	snprintf(buf + len, size - len, conv, val))
+
+	while (len < size - 1) {
+		const char *prev = fmt;
+
+		if (!log_ring_next_spec(&fmt, &spec)) {
+			len += strlcpy(buf + len, prev, size - len);
+			break;
+		}
+		ret = min_t(int, spec.start - prev, size - 1 - len);
+		memcpy(buf + len, prev, ret);
+		len += ret;
+		if (len == size - 1 || spec.len >= sizeof(conv))
+			break;
+		strlcpy(conv, spec.start, spec.len + 1);
+		for (i = 0; i < spec.stars; i++)
+			LOAD(star[i]);
+
+		switch (spec.arg) {
+		case ARG_NONE:
+			ret = snprintf(buf + len, size - len, "%%");
+			break;
+		case ARG_INT:
+			LOAD(ival);
+			ret = OUT(ival);
+			break;
+		case ARG_LONG:
+			LOAD(lval);
+			ret = OUT(lval);
+			break;
+		case ARG_LLONG:
+			LOAD(llval);
+			ret = OUT(llval);
+			break;
+		case ARG_PTR:
+			LOAD(ptr);
+			ret = OUT(ptr);
+			break;
+		case ARG_STR:
+			ret = OUT(data);
+			data += strlen(data) + 1;
+			break;
+		default:
+			ret = 0;
+			break;
+		}
+		len = min(len + ret, size - 1);
+	}
+#undef OUT
+#undef LOAD
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Format the message for a record */
+static int log_ring_msg(const struct log_ring_rec *lrec, char *buf, int size)
+{
+	if (lrec->type == LOG_RING_ARGS)
+		return log_ring_format_args(lrec, buf, size);
+
+	return min_t(int, strlcpy(buf, lrec->data, size), size - 1);
+}
+
+/*
+ * Format a record as the console driver would, returning the length of the
+ * line
+ */
+static int log_ring_line(const struct log_ring_rec *lrec, char *buf,
+			 int size)
+{
+	const char *file = lrec->file, *func = lrec->func;
+	int fmt = gd->log_fmt;
+	int len = 0;
+
+	if (!file) {
+		file = lrec->data + strlen(lrec->data) + 1;
+		func = file + strlen(file) + 1;
+	}
+
+#define ADD(_fmt...) \
+	len += scnprintf(buf + len, size - len, ##_fmt)
+
+	if (!(lrec->flags & LOGRECF_CONT) && fmt != BIT(LOGF_MSG)) {
+		if (fmt & BIT(LOGF_LEVEL))
+			ADD("%s.", log_get_level_name(lrec->level));
+		if (fmt & BIT(LOGF_CAT))
+			ADD("%s,", log_get_cat_name(lrec->cat));
+		if (fmt & BIT(LOGF_FILE))
+			ADD("%s:", file);
+		if (fmt & BIT(LOGF_LINE))
+			ADD("%d-", lrec->line);
+		if (fmt & BIT(LOGF_FUNC)) {
+			if (CONFIG_IS_ENABLED(USE_TINY_PRINTF))
+				ADD("%s()", func);
+			else
+				ADD("%*s()", CONFIG_LOGF_FUNC_PAD, func);
+		}
+		if (fmt & BIT(LOGF_MSG))
+			ADD(" ");
+	}
+#undef ADD
+	if ((fmt & BIT(LOGF_MSG)) && len < size - 1)
+		len += log_ring_msg(lrec, buf + len, size - len);
+
+	return len;
+}
+
+/*
+ * Get the record at *@posp, skipping any padding, or return NULL if there are
+ * no records before @end
+ */
+static struct log_ring_rec *log_ring_get(ulong *posp, ulong end)
+{
+	struct log_ring_rec *lrec;
+	ulong ofs;
+
+	while (*posp != end) {
+		ofs = *posp % log_ring.size;
+		if (log_ring.size - ofs < sizeof(*lrec)) {
+			*posp += log_ring.size - ofs;
+			continue;
+		}
+		lrec = (struct log_ring_rec *)(log_ring.buf + ofs);
+		if (lrec->type != LOG_RING_PAD)
+			return lrec;
+		*posp += lrec->size;
+	}
+
+	return NULL;
+}
+
+/*
+ * Make space for a record of @size bytes and return it, or NULL if it is
+ * larger than the buffer
+ */
+static struct log_ring_rec *log_ring_alloc(ulong size)
+{
+	struct log_ring *ring = &log_ring;
+	struct log_ring_rec *lrec;
+	ulong ofs = ring->head % ring->size;
+	ulong gap = 0;
+
+	if (size > ring->size)
+		return NULL;
+	if (ring->size - ofs < size)
+		gap = ring->size - ofs;
+	while (ring->head + gap + size - ring->tail > ring->size) {
+		lrec = log_ring_get(&ring->tail, ring->head);
+		if (!lrec) {
+			/* Nothing left, so the new record is the only one */
+			ring->tail = ring->head + gap;
+			break;
+		}
+		ring->tail += lrec->size;
+	}
+	if ((long)(ring->drain - ring->tail) < 0)
+		ring->drain = ring->tail;
+	if (gap >= sizeof(*lrec)) {
+		lrec = (struct log_ring_rec *)(ring->buf + ofs);
+		lrec->type = LOG_RING_PAD;
+		lrec->size = gap;
+	}
+	ring->head += gap;
+	lrec = (struct log_ring_rec *)(ring->buf + ring->head % ring->size);
+	ring->head += size;
+	lrec->size = size;
+
+	return lrec;
+}
+
+static void log_ring_drain_cyclic(void *ctx);
+
+/* Set up the buffer, returning false if it is not possible yet */
+static bool log_ring_start(void)
+{
+	struct log_ring *ring = &log_ring;
+
+	if (ring->buf)
+		return true;
+
+	/* Memory allocated before relocation is lost, so wait until after */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return false;
+	ring->size = ALIGN_DOWN(CONFIG_LOG_RING_SIZE, LOG_RING_ALIGN);
+	ring->buf = malloc(ring->size);
+	if (!ring->buf)
+		return false;
+
+	if (IS_ENABLED(CONFIG_LOG_RING_DRAIN)) {
+		struct log_device *ldev, *cons;
+		bool printed = false;
+
+		ring->line = malloc(LOG_RING_LINE_SIZE);
+		cons = log_device_find_by_name("console");
+		if (ring->line && cons && (cons->flags & LOGDF_ENABLE)) {
+			/*
+			 * If the console device comes first, it has already
+			 * written the record which is about to be stored
+			 */
+			list_for_each_entry(ldev, &gd->log_head, sibling_node) {
+				if (ldev == cons)
+					printed = true;
+				if (ldev->drv == LOG_GET_DRIVER(ring))
+					break;
+			}
+			cons->flags &= ~LOGDF_ENABLE;
+			ring->cyclic = cyclic_register(log_ring_drain_cyclic,
+						       LOG_RING_DRAIN_US,
+						       "log_ring", ring);
+			ring->skip = printed;
+		}
+	}
+
+	return true;
+}
+
+static int log_ring_emit_fmt(struct log_device *ldev, struct log_rec *rec,
+			     const char *fmt, va_list args)
+{
+	char data[LOG_RING_MAX_DATA];
+	struct log_ring_rec *lrec;
+	bool transient;
+	int len;
+
+	if (!log_ring_start())
+		return -ENOSYS;
+
+	transient = rec->flags & LOGRECF_TRANSIENT;
+	len = -E2BIG;
+	if (!rec->msg && !transient) {
+		va_list copy;
+
+		va_copy(copy, args);
+		len = log_ring_save_args(data, sizeof(data), fmt, copy);
+		va_end(copy);
+	}
+	if (len < 0) {
+		/* Store the message itself, along with any transient strings */
+		const char *msg = rec->msg;
+		int flen = 0;
+
+		if (!msg) {
+			vsnprintf(data, sizeof(data), fmt, args);
+			msg = data;
+		}
+		if (transient)
+			flen = strlen(rec->file) + strlen(rec->func) + 2;
+		len = strnlen(msg, sizeof(data) - 1 - flen);
+		lrec = log_ring_alloc(ALIGN(sizeof(*lrec) + len + 1 + flen,
+					    LOG_RING_ALIGN));
+		if (!lrec)
+			return -ENOSPC;
+		memcpy(lrec->data, msg, len);
+		lrec->data[len] = '\0';
+		if (transient) {
+			strcpy(lrec->data + len + 1, rec->file);
+			strcpy(lrec->data + len + 2 + strlen(rec->file),
+			       rec->func);
+		}
+		lrec->type = LOG_RING_MSG;
+		lrec->fmt = NULL;
+	} else {
+		lrec = log_ring_alloc(ALIGN(sizeof(*lrec) + len,
+					    LOG_RING_ALIGN));
+		if (!lrec)
+			return -ENOSPC;
+		memcpy(lrec->data, data, len);
+		lrec->type = LOG_RING_ARGS;
+		lrec->fmt = fmt;
+	}
+	lrec->level = rec->level;
+	lrec->flags = rec->flags;
+	lrec->cat = rec->cat;
+	lrec->line = rec->line;
+	lrec->file = transient ? NULL : rec->file;
+	lrec->func = transient ? NULL : rec->func;
+
+	/* A record which was already written is not drained again */
+	if (log_ring.skip) {
+		log_ring.drain = log_ring.head;
+		log_ring.skip = false;
+	}
+
+	return 0;
+}
+
+/*
+ * Write out records which are waiting to be drained, stopping when @max
+ * records have been written or after @budget_us microseconds (if not 0)
+ */
+static int log_ring_drain(int max, ulong budget_us)
+{
+	struct log_ring *ring = &log_ring;
+	struct log_ring_rec *lrec;
+	ulong start = timer_get_us();
+	char chunk[LOG_RING_DRAIN_CHUNK + 1];
+	int count = 0, len;
+
+	if (!ring->line || gd->processing_msg)
+		return 0;
+	while (count < max) {
+		if (ring->line_pos == ring->line_len) {
+			lrec = log_ring_get(&ring->drain, ring->head);
+			if (!lrec)
+				break;
+			ring->line_len = log_ring_line(lrec, ring->line,
+						       LOG_RING_LINE_SIZE);
+			ring->line_pos = 0;
+			ring->drain += lrec->size;
+		}
+		len = min(ring->line_len - ring->line_pos,
+			  LOG_RING_DRAIN_CHUNK);
+		strlcpy(chunk, ring->line + ring->line_pos, len + 1);
+		puts(chunk);
+		ring->line_pos += len;
+		if (ring->line_pos == ring->line_len)
+			count++;
+		if (budget_us && timer_get_us() - start >= budget_us)
+			break;
+	}
+
+	return count;
+}
+
+static void log_ring_drain_cyclic(void *ctx)
+{
+	log_ring_drain(INT_MAX, CONFIG_CYCLIC_MAX_CPU_TIME_US / 2);
+}
+
+int log_ring_flush(void)
+{
+	return log_ring_drain(INT_MAX, 0);
+}
+
+int log_ring_show(void)
+{
+	struct log_ring *ring = &log_ring;
+	struct log_ring_rec *lrec;
+	ulong pos = ring->tail;
+	int count = 0;
+	char *line;
+
+	if (!ring->buf)
+		return 0;
+	line = malloc(LOG_RING_LINE_SIZE);
+	if (!line)
+		return -ENOMEM;
+	while ((lrec = log_ring_get(&pos, ring->head))) {
+		log_ring_line(lrec, line, LOG_RING_LINE_SIZE);
+		puts(line);
+		pos += lrec->size;
+		count++;
+	}
+	free(line);
+
+	return count;
+}
+
+void log_ring_clear(void)
+{
+	struct log_ring *ring = &log_ring;
+
+	log_ring_flush();
+	ring->tail = ring->head;
+	ring->drain = ring->head;
+}
+
+int log_ring_export(char *buf, int size)
+{
+	struct log_ring *ring = &log_ring;
+	struct log_ring_rec *lrec;
+	ulong pos;
+	long total = 0;
+	int len = 0;
+	char *line;
+
+	if (size < 1)
+		return 0;
+	buf[0] = '\0';
+	if (!ring->buf)
+		return 0;
+	line = malloc(LOG_RING_LINE_SIZE);
+	if (!line)
+		return -ENOMEM;
+
+	/* Work out how much space is needed, then skip the oldest records */
+	for (pos = ring->tail; (lrec = log_ring_get(&pos, ring->head));
+	     pos += lrec->size)
+		total += log_ring_line(lrec, line, LOG_RING_LINE_SIZE);
+	for (pos = ring->tail; (lrec = log_ring_get(&pos, ring->head));
+	     pos += lrec->size) {
+		if (total < size)
+			break;
+		total -= log_ring_line(lrec, line, LOG_RING_LINE_SIZE);
+	}
+	for (; (lrec = log_ring_get(&pos, ring->head)); pos += lrec->size)
+		len += log_ring_line(lrec, buf + len, size - len);
+	free(line);
+
+	return len;
+}
+
+/* Write out everything before the prompt appears */
+static int log_ring_main_loop(void)
+{
+	log_ring_flush();
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_MAIN_LOOP, log_ring_main_loop);
+
+/* Write out everything before the devicetree is handed to an OS */
+static int log_ring_ft_fixup(void)
+{
+	log_ring_flush();
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_FT_FIXUP, log_ring_ft_fixup);
+
+#if IS_ENABLED(CONFIG_LOG_RING_BLOBLIST)
+/* Pass the log to the OS just before it is started */
+static int log_ring_handoff(void *ctx, struct event *event)
+{
+	int size = CONFIG_LOG_RING_SIZE;
+	void *blob;
+	int ret;
+
+	log_ring_flush();
+	ret = bloblist_ensure_size_ret(BLOBLISTT_U_BOOT_LOG, &size, &blob);
+	if (ret) {
+		log_debug("Cannot add log to bloblist (err=%d)\n", ret);
+		return 0;
+	}
+	log_ring_export(blob, size);
+
+	return 0;
+}
+EVENT_SPY_FULL(EVT_FT_FIXUP, log_ring_handoff);
+#endif
+
+LOG_DRIVER(ring) = {
+	.name		= "ring",
+	.emit_fmt	= log_ring_emit_fmt,
+	.flags		= LOGDF_ENABLE,
+};
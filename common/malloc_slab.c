@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Size-class front-end for dlmalloc
+ *
+ * Driver model allocates a large number of small objects: devices, their
+ * private data, devres records and so on. Served by dlmalloc, each costs a
+ * chunk header and a bin search, and the objects end up scattered among
+ * larger allocations. Here a region at the top of the malloc() pool is
+ * divided into pages, each holding objects of a single size class. Allocating
+ * and freeing an object is a pop or push on the free list of its page, and
+ * objects have no header.
+ *
+ * Requests which are too large, or for which no page is available, are passed
+ * to dlmalloc as normal.
+ */
+
+#define LOG_CATEGORY	LOGC_ALLOC
+
+#include <common.h>
+#include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <linux/kernel.h>
+#include <valgrind/memcheck.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	SLAB_PAGE_SHIFT	= 12,
+	SLAB_PAGE_SIZE	= 1 << SLAB_PAGE_SHIFT,
+	SLAB_ALIGN	= 16,
+	SLAB_MAX_SIZE	= 512,
+};
+
+/* Object size for each class, a multiple of SLAB_ALIGN */
+static const u16 slab_sizes[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+#define SLAB_CLASSES	ARRAY_SIZE(slab_sizes)
+
+/* Class to use for each request size, indexed by size / SLAB_ALIGN rounded up */
+static const u8 slab_class_of[SLAB_MAX_SIZE / SLAB_ALIGN + 1] = {
+	[0 ... 1] = 0,
+	[2] = 1,
+	[3] = 2,
+	[4] = 3,
+	[5 ... 6] = 4,
+	[7 ... 8] = 5,
+	[9 ... 12] = 6,
+	[13 ... 16] = 7,
+	[17 ... 24] = 8,
+	[25 ... 32] = 9,
+};
+
+/**
+ * struct slab_page - Information about a page in the slab region
+ *
+ * @next: Next page in the list this page is on
+ * @prev: Previous page in the list this page is on (partial list only)
+ * @free: First free object in the page, or NULL if it is full. Each free
+ *	object holds a pointer to the next one
+ * @inuse: Number of objects allocated from this page
+ * @cls: Size class of this page (index into slab_sizes[])
+ */
+struct slab_page {
+	struct slab_page *next;
+	struct slab_page *prev;
+	void *free;
+	u16 inuse;
+	u8 cls;
+};
+
+/**
+ * struct slab_class - Information about a size class
+ *
+ * @partial: List of pages in this class which have free objects
+ * @per_page: Number of objects in each page
+ * @pages: Number of pages in use by this class
+ * @inuse: Number of objects allocated
+ * @allocs: Total number of allocations
+ * @frees: Total number of frees
+ * @fallbacks: Number of requests passed to dlmalloc since no page was free
+ */
+struct slab_class {
+	struct slab_page *partial;
+	uint per_page;
+	uint pages;
+	uint inuse;
+	ulong allocs;
+	ulong frees;
+	ulong fallbacks;
+};
+
+/**
+ * struct slab_region - The region used for small allocations
+ *
+ * @desc: Page descriptors, one for each page
+ * @base: Address of the first page
+ * @end: Address just after the last page
+ * @size: Total size of the region, including the descriptors
+ * @npages: Number of pages
+ * @nfree: Number of pages not in use by any class
+ * @free_pages: List of pages not in use by any class
+ * @classes: Information about each size class
+ */
+struct slab_region {
+	struct slab_page *desc;
+	ulong base;
+	ulong end;
+	ulong size;
+	int npages;
+	int nfree;
+	struct slab_page *free_pages;
+	struct slab_class classes[SLAB_CLASSES];
+};
+
+static struct slab_region slab;
+
+/* The region is only used after relocation, when BSS is available */
+static bool slab_ready(void)
+{
+	return (gd->flags & GD_FLG_FULL_MALLOC_INIT) && slab.npages;
+}
+
+static struct slab_page *slab_page_of(const void *ptr)
+{
+	return &slab.desc[((ulong)ptr - slab.base) >> SLAB_PAGE_SHIFT];
+}
+
+static ulong slab_page_addr(struct slab_page *page)
+{
+	return slab.base + ((ulong)(page - slab.desc) << SLAB_PAGE_SHIFT);
+}
+
+static void slab_link(struct slab_class *cls, struct slab_page *page)
+{
+	page->prev = NULL;
+	page->next = cls->partial;
+	if (page->next)
+		page->next->prev = page;
+	cls->partial = page;
+}
+
+static void slab_unlink(struct slab_class *cls, struct slab_page *page)
+{
+	if (page->prev)
+		page->prev->next = page->next;
+	else
+		cls->partial = page->next;
+	if (page->next)
+		page->next->prev = page->prev;
+	page->next = NULL;
+	page->prev = NULL;
+}
+
+/* Take a page from the free list and divide it into objects of a class */
+static struct slab_page *slab_new_page(int clsnum)
+{
+	struct slab_class *cls = &slab.classes[clsnum];
+	uint size = slab_sizes[clsnum];
+	struct slab_page *page;
+	void **obj, *next;
+	ulong addr;
+	int i;
+
+	page = slab.free_pages;
+	if (!page)
+		return NULL;
+	slab.free_pages = page->next;
+	slab.nfree--;
+
+	addr = slab_page_addr(page);
+	next = NULL;
+	for (i = cls->per_page - 1; i >= 0; i--) {
+		obj = (void **)(addr + i * size);
+		*obj = next;
+		next = obj;
+	}
+	page->free = next;
+	page->inuse = 0;
+	page->cls = clsnum;
+	slab_link(cls, page);
+	cls->pages++;
+
+	return page;
+}
+
+/* Return an empty page to the free list */
+static void slab_release_page(struct slab_class *cls, struct slab_page *page)
+{
+	slab_unlink(cls, page);
+	cls->pages--;
+	page->free = NULL;
+	page->next = slab.free_pages;
+	slab.free_pages = page;
+	slab.nfree++;
+}
+
+ulong malloc_slab_init(ulong start, ulong size)
+{
+	ulong region = CONFIG_SYS_MALLOC_SLAB_SIZE;
+	ulong base, pages, end;
+	int i, npages;
+
+	memset(&slab, '\0', sizeof(slab));
+	if (size / 4 < region) {
+		log_debug("malloc() pool too small for slab region\n");
+		return 0;
+	}
+
+	/* The page descriptors go at the start, followed by the pages */
+	base = ALIGN(start + size - region, sizeof(ulong));
+	end = ALIGN_DOWN(start + size, SLAB_PAGE_SIZE);
+	npages = (end - base) / (SLAB_PAGE_SIZE + sizeof(struct slab_page));
+	pages = ALIGN(base + npages * sizeof(struct slab_page), SLAB_PAGE_SIZE);
+	npages = (end - pages) >> SLAB_PAGE_SHIFT;
+	if (npages <= 0)
+		return 0;
+
+	slab.desc = (struct slab_page *)base;
+	slab.base = pages;
+	slab.end = pages + ((ulong)npages << SLAB_PAGE_SHIFT);
+	slab.size = region;
+	slab.npages = npages;
+	memset(slab.desc, '\0', npages * sizeof(struct slab_page));
+	for (i = npages - 1; i >= 0; i--) {
+		slab.desc[i].next = slab.free_pages;
+		slab.free_pages = &slab.desc[i];
+	}
+	slab.nfree = npages;
+	for (i = 0; i < SLAB_CLASSES; i++)
+		slab.classes[i].per_page = SLAB_PAGE_SIZE / slab_sizes[i];
+	log_debug("slab region %lx-%lx, %d pages\n", slab.base, slab.end,
+		  npages);
+
+	return region;
+}
+
+void *malloc_slab_alloc(size_t bytes)
+{
+	struct slab_class *cls;
+	struct slab_page *page;
+	void **obj;
+	int clsnum;
+
+	if (bytes > SLAB_MAX_SIZE || !slab_ready())
+		return NULL;
+	clsnum = slab_class_of[DIV_ROUND_UP(bytes, SLAB_ALIGN)];
+	cls = &slab.classes[clsnum];
+	page = cls->partial;
+	if (!page) {
+		page = slab_new_page(clsnum);
+		if (!page) {
+			cls->fallbacks++;
+			return NULL;
+		}
+	}
+
+	obj = page->free;
+	page->free = *obj;
+	page->inuse++;
+	if (!page->free)
+		slab_unlink(cls, page);
+	cls->inuse++;
+	cls->allocs++;
+	VALGRIND_MALLOCLIKE_BLOCK(obj, bytes, 0, false);
+
+	return obj;
+}
+
+bool malloc_slab_owns(const void *ptr)
+{
+	ulong addr = (ulong)ptr;
+
+	return slab_ready() && addr >= slab.base && addr < slab.end;
+}
+
+bool malloc_slab_free(void *ptr)
+{
+	struct slab_class *cls;
+	struct slab_page *page;
+	bool was_full;
+
+	if (!malloc_slab_owns(ptr))
+		return false;
+	page = slab_page_of(ptr);
+	cls = &slab.classes[page->cls];
+
+	was_full = !page->free;
+	*(void **)ptr = page->free;
+	VALGRIND_FREELIKE_BLOCK(ptr, 0);
+	page->free = ptr;
+	page->inuse--;
+	cls->inuse--;
+	cls->frees++;
+	if (was_full)
+		slab_link(cls, page);
+
+	/* Keep one partial page so that alloc/free pairs do not thrash */
+	if (!page->inuse && (cls->partial != page || page->next))
+		slab_release_page(cls, page);
+
+	return true;
+}
+
+size_t malloc_slab_usable_size(const void *ptr)
+{
+	return slab_sizes[slab_page_of(ptr)->cls];
+}
+
+void malloc_slab_mallinfo(struct mallinfo *info)
+{
+	ulong inuse = 0;
+	int i;
+
+	if (!slab_ready())
+		return;
+	for (i = 0; i < SLAB_CLASSES; i++)
+		inuse += slab.classes[i].inuse * slab_sizes[i];
+	info->arena += slab.size;
+	info->uordblks += inuse;
+	info->fordblks += slab.size - inuse;
+	info->fsmblks += slab.size - inuse;
+}
+
+void malloc_slab_stats(void)
+{
+	int i;
+
+	if (!slab_ready()) {
+		printf("slab: not in use\n");
+		return;
+	}
+	printf("slab: %d pages of %d bytes at %lx, %d free\n", slab.npages,
+	       SLAB_PAGE_SIZE, slab.base, slab.nfree);
+	printf("%5s %6s %7s %10s %10s %9s\n", "size", "pages", "inuse",
+	       "allocs", "frees", "fallbacks");
+	for (i = 0; i < SLAB_CLASSES; i++) {
+		struct slab_class *cls = &slab.classes[i];
+
+		printf("%5u %6u %7u %10lu %10lu %9lu\n", slab_sizes[i],
+		       cls->pages, cls->inuse, cls->allocs, cls->frees,
+		       cls->fallbacks);
+	}
+}
@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
@@ -432,7 +433,7 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	ulong blks_read, start_us;
 
 	if (!ops->read)
 		return -ENOSYS;
@@ -441,6 +442,7 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 			  start, blkcnt, desc->blksz, buf))
 		return blkcnt;
 
+	start_us = bootstage_event_start();
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
 		int ret;
@@ -458,6 +460,7 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	} else {
 		blks_read = ops->read(dev, start, blkcnt, buf);
 	}
+	bootstage_event_end(BOOTSTAGE_EVENT_BLK_READ, dev->name, start_us);
 
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
@@ -204,6 +204,13 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
+	/* A device cannot be removed part-way through its probe */
+	if (dev_get_flags(dev) & DM_FLAG_PROBE_PENDING) {
+		ret = device_probe(dev);
+		if (ret)
+			return 0;
+	}
+
 	if (!(dev_get_flags(dev) & DM_FLAG_ACTIVATED))
 		return 0;
 
@@ -9,7 +9,9 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
+#include <cyclic.h>
 #include <event.h>
 #include <log.h>
 #include <asm/global_data.h>
@@ -478,7 +480,222 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+/**
+ * device_probe_fail() - Tidy up after a failed probe
+ *
+ * @dev: Device which failed to probe
+ * @remove: true to remove the device, if the uclass has already been notified
+ *	of the probe
+ */
+static void device_probe_fail(struct udevice *dev, bool remove)
+{
+	if (remove && device_remove(dev, DM_REMOVE_NORMAL)) {
+		dm_warn("%s: Device '%s' failed to remove on error path\n",
+			__func__, dev->name);
+	}
+	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
+
+	device_free(dev);
+}
+
+/**
+ * device_probe_complete() - Complete probing a device
+ *
+ * This runs the steps which follow the driver's probe() method
+ *
+ * @dev: Device whose driver has been probed successfully
+ * Return: 0 if OK, -ve on error
+ */
+static int device_probe_complete(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret)
+		goto fail;
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL) {
+		ret = pinctrl_select_state(dev, "default");
+		if (ret && ret != -ENOSYS)
+			log_debug("Device '%s' failed to configure default pinctrl: %d (%s)\n",
+				  dev->name, ret, errno_str(ret));
+	}
+
+	ret = device_notify(dev, EVT_DM_POST_PROBE);
+	if (ret)
+		goto fail;
+
+	return 0;
+fail:
+	device_probe_fail(dev, true);
+
+	return ret;
+}
+
+/**
+ * device_probe_poll() - Wait for a driver's probe() method to finish
+ *
+ * Calls the probe() method of a driver with DM_FLAG_PROBE_ASYNC until it
+ * stops returning -EINPROGRESS
+ *
+ * @dev: Device to poll
+ * Return: 0 if OK, -ve on error
+ */
+static int device_probe_poll(struct udevice *dev)
+{
+	int ret;
+
+	do {
+		schedule();
+		ret = dev->driver->probe(dev);
+	} while (ret == -EINPROGRESS);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(DM_ASYNC_PROBE)
+/**
+ * struct dm_async_probe - A device whose probe is in progress
+ *
+ * @sibling: Next device in the list of pending devices
+ * @dev: Device being probed
+ */
+struct dm_async_probe {
+	struct list_head sibling;
+	struct udevice *dev;
+};
+
+/* Only used after relocation, see device_probe_async() */
+static LIST_HEAD(async_probe_list);
+
+static struct dm_async_probe *device_async_find(struct udevice *dev)
+{
+	struct dm_async_probe *node;
+
+	list_for_each_entry(node, &async_probe_list, sibling) {
+		if (node->dev == dev)
+			return node;
+	}
+
+	return NULL;
+}
+
+/**
+ * device_async_done() - Finish off a device once its probe() method returns
+ *
+ * @dev: Device which was pending
+ * @ret: Return value from the driver's probe() method
+ * Return: 0 if OK, -ve on error
+ */
+static int device_async_done(struct udevice *dev, int ret)
+{
+	dev_bic_flags(dev, DM_FLAG_PROBE_PENDING);
+	if (ret) {
+		device_probe_fail(dev, false);
+		return ret;
+	}
+
+	return device_probe_complete(dev);
+}
+
+/*
+ * Poll one pending device each time we are called. The device is taken off
+ * the list while its driver runs, since the probe() method may itself wait
+ * for another pending device.
+ */
+static void device_async_cyclic(void *ctx)
+{
+	struct dm_async_probe *node;
+	struct udevice *dev;
+	int ret;
+
+	node = list_first_entry_or_null(&async_probe_list,
+					struct dm_async_probe, sibling);
+	if (!node)
+		return;
+	list_del(&node->sibling);
+	dev = node->dev;
+
+	ret = dev->driver->probe(dev);
+	if (ret == -EINPROGRESS) {
+		list_add_tail(&node->sibling, &async_probe_list);
+		return;
+	}
+	free(node);
+
+	ret = device_async_done(dev, ret);
+	if (ret)
+		log_warning("Device '%s' failed async probe: %d (%s)\n",
+			    dev->name, ret, errno_str(ret));
+}
+
+/*
+ * The cyclic function stays registered once added, but all cyclic functions
+ * are dropped before relocation and between tests, so check the list
+ */
+static bool device_async_cyclic_active(void)
+{
+	struct cyclic_info *cyclic;
+
+	hlist_for_each_entry(cyclic, cyclic_get_list(), list) {
+		if (cyclic->func == device_async_cyclic)
+			return true;
+	}
+
+	return false;
+}
+
+static int device_async_add(struct udevice *dev)
+{
+	struct dm_async_probe *node;
+
+	if (!device_async_cyclic_active() &&
+	    !cyclic_register(device_async_cyclic, CONFIG_DM_ASYNC_PROBE_POLL_US,
+			     "dm_async_probe", NULL))
+		return -ENOMEM;
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		return -ENOMEM;
+	node->dev = dev;
+	list_add_tail(&node->sibling, &async_probe_list);
+	dev_or_flags(dev, DM_FLAG_PROBE_PENDING);
+
+	return 0;
+}
+
+/**
+ * device_async_wait() - Wait for a pending device to finish probing
+ *
+ * @dev: Device with DM_FLAG_PROBE_PENDING set
+ * Return: 0 if OK, -EDEADLK if called from the device's own probe() method,
+ *	other -ve on error
+ */
+static int device_async_wait(struct udevice *dev)
+{
+	struct dm_async_probe *node;
+
+	node = device_async_find(dev);
+	if (!node)
+		return -EDEADLK;
+	list_del(&node->sibling);
+	free(node);
+
+	return device_async_done(dev, device_probe_poll(dev));
+}
+#else
+static int device_async_add(struct udevice *dev)
+{
+	return -ENOSYS;
+}
+
+static int device_async_wait(struct udevice *dev)
+{
+	return -ENOSYS;
+}
+#endif
+
+static int device_do_probe(struct udevice *dev, bool async)
 {
 	const struct driver *drv;
 	int ret;
@@ -486,6 +703,10 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+	if (CONFIG_IS_ENABLED(DM_ASYNC_PROBE) &&
+	    (dev_get_flags(dev) & DM_FLAG_PROBE_PENDING))
+		return async ? 0 : device_async_wait(dev);
+
 	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
 		return 0;
 
@@ -582,40 +803,45 @@ int device_probe(struct udevice *dev)
 
 	if (drv->probe) {
 		ret = drv->probe(dev);
+		if (ret == -EINPROGRESS && (drv->flags & DM_FLAG_PROBE_ASYNC)) {
+			if (async && !device_async_add(dev))
+				return 0;
+			ret = device_probe_poll(dev);
+		}
 		if (ret)
 			goto fail;
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
+	return device_probe_complete(dev);
+fail:
+	device_probe_fail(dev, false);
 
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL) {
-		ret = pinctrl_select_state(dev, "default");
-		if (ret && ret != -ENOSYS)
-			log_debug("Device '%s' failed to configure default pinctrl: %d (%s)\n",
-				  dev->name, ret, errno_str(ret));
-	}
+	return ret;
+}
 
-	ret = device_notify(dev, EVT_DM_POST_PROBE);
-	if (ret)
-		goto fail_event;
+int device_probe(struct udevice *dev)
+{
+	ulong start_us;
+	int ret;
 
-	return 0;
-fail_event:
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
-fail:
-	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS) || !dev || device_active(dev))
+		return device_do_probe(dev, false);
 
-	device_free(dev);
+	start_us = bootstage_event_start();
+	ret = device_do_probe(dev, false);
+	bootstage_event_end(BOOTSTAGE_EVENT_PROBE, dev->name, start_us);
 
 	return ret;
 }
 
+int device_probe_async(struct udevice *dev)
+{
+	bool async = CONFIG_IS_ENABLED(DM_ASYNC_PROBE) &&
+		(gd->flags & GD_FLG_RELOC);
+
+	return device_do_probe(dev, async);
+}
+
 void *dev_get_plat(const struct udevice *dev)
 {
 	if (!dev) {
@@ -1145,6 +1371,8 @@ int device_set_name(struct udevice *dev, const char *name)
 		return -ENOMEM;
 	dev->name = name;
 	device_set_name_alloced(dev);
+	if (dev->uclass)
+		uclass_index_invalidate(dev->uclass);
 
 	return 0;
 }
@@ -106,6 +106,9 @@ int dm_init(bool of_live)
 		gd->uclass_root = &DM_UCLASS_ROOT_S_NON_CONST;
 		INIT_LIST_HEAD(DM_UCLASS_ROOT_NON_CONST);
 	}
+	ret = uclass_index_init();
+	if (ret)
+		return ret;
 
 	if (CONFIG_IS_ENABLED(OF_PLATDATA_INST)) {
 		ret = dm_setup_inst();
@@ -296,6 +299,13 @@ static int dm_probe_devices(struct udevice *dev, bool pre_reloc_only)
 		ret = device_probe(dev);
 		if (ret)
 			return ret;
+	} else if (CONFIG_IS_ENABLED(DM_ASYNC_PROBE) && !pre_reloc_only &&
+		   (dev->driver->flags & DM_FLAG_PROBE_ASYNC)) {
+		/* Start slow devices early; they finish in the background */
+		ret = device_probe_async(dev);
+		if (ret)
+			log_debug("Device '%s' failed to start probe: %d\n",
+				  dev->name, ret);
 	}
 
 probe_children:
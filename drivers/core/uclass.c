@@ -9,6 +9,7 @@
 #define LOG_CATEGORY LOGC_DM
 
 #include <common.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
@@ -25,22 +26,193 @@ DECLARE_GLOBAL_DATA_PTR;
 
 struct uclass *uclass_find(enum uclass_id key)
 {
+	struct uclass **idx = gd_uclass_idx();
 	struct uclass *uc;
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+	if (idx && key >= 0 && key < UCLASS_COUNT && idx[key])
+		return idx[key];
+
 	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
-		if (uc->uc_drv->id == key)
+		if (uc->uc_drv->id == key) {
+			if (idx)
+				idx[key] = uc;
 			return uc;
+		}
+	}
+
+	return NULL;
+}
+
+int uclass_index_init(void)
+{
+	struct uclass **idx = gd_uclass_idx();
+
+	if (!CONFIG_IS_ENABLED(DM_UCLASS_INDEX) || !(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	/* Any existing uclasses have been abandoned, so just clear it */
+	if (idx) {
+		memset(idx, '\0', UCLASS_COUNT * sizeof(*idx));
+		return 0;
+	}
+	idx = calloc(UCLASS_COUNT, sizeof(*idx));
+	if (!idx)
+		return -ENOMEM;
+	gd_set_uclass_idx(idx);
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void uclass_index_invalidate(struct uclass *uc)
+{
+	free(uc->seq_idx);
+	uc->seq_idx = NULL;
+	uc->seq_idx_size = 0;
+	free(uc->name_idx);
+	uc->name_idx = NULL;
+	uc->name_idx_size = 0;
+}
+
+static uint uclass_name_hash(const char *name, int len)
+{
+	uint hash = 0;
+
+	while (len--)
+		hash = hash * 31 + *name++;
+
+	return hash;
+}
+
+/*
+ * Build the sequence-number index for a uclass. If two devices have the same
+ * sequence number, the first one in the uclass wins, as with a linear search.
+ */
+static int uclass_build_seq_idx(struct uclass *uc)
+{
+	struct udevice *dev;
+	int size = 0;
+
+	uclass_foreach_dev(dev, uc)
+		size = max(size, dev->seq_ + 1);
+	if (!size)
+		return -ENOENT;
+	uc->seq_idx = calloc(size, sizeof(struct udevice *));
+	if (!uc->seq_idx)
+		return -ENOMEM;
+	uc->seq_idx_size = size;
+	uclass_foreach_dev(dev, uc) {
+		if (dev->seq_ >= 0 && !uc->seq_idx[dev->seq_])
+			uc->seq_idx[dev->seq_] = dev;
+	}
+
+	return 0;
+}
+
+/* Build an open-addressed hash table of the devices in a uclass, by name */
+static int uclass_build_name_idx(struct uclass *uc)
+{
+	struct udevice *dev;
+	int count = 0;
+	int size;
+
+	uclass_foreach_dev(dev, uc)
+		count++;
+	if (!count)
+		return -ENOENT;
+
+	/* Keep the table no more than half full */
+	for (size = 8; size < count * 2; size <<= 1)
+		;
+	uc->name_idx = calloc(size, sizeof(struct udevice *));
+	if (!uc->name_idx)
+		return -ENOMEM;
+	uc->name_idx_size = size;
+	uclass_foreach_dev(dev, uc) {
+		int len = strlen(dev->name);
+		uint i = uclass_name_hash(dev->name, len);
+		struct udevice *slot;
+
+		for (;; i++) {
+			slot = uc->name_idx[i & (size - 1)];
+			if (!slot) {
+				uc->name_idx[i & (size - 1)] = dev;
+				break;
+			}
+			/* Keep the first device with this name */
+			if (!strcmp(slot->name, dev->name))
+				break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * uclass_find_seq_idx() - Look up a device in a uclass's sequence index
+ *
+ * @uc: uclass to search
+ * @seq: Sequence number to find
+ * Return: device found, or NULL if not in the index (in which case a linear
+ *	search is needed)
+ */
+static struct udevice *uclass_find_seq_idx(struct uclass *uc, int seq)
+{
+	struct udevice *dev;
+
+	if (!gd_uclass_idx())
+		return NULL;
+	if (!uc->seq_idx && uclass_build_seq_idx(uc))
+		return NULL;
+	if (seq < 0 || seq >= uc->seq_idx_size)
+		return NULL;
+	dev = uc->seq_idx[seq];
+
+	/* A device's sequence number can be changed after it is bound */
+	return dev && dev->seq_ == seq ? dev : NULL;
+}
+
+/**
+ * uclass_find_name_idx() - Look up a device in a uclass's name index
+ *
+ * @uc: uclass to search
+ * @name: Name to find (need not be nul-terminated)
+ * @len: Length of name
+ * Return: device found, or NULL if not in the index (in which case a linear
+ *	search is needed)
+ */
+static struct udevice *uclass_find_name_idx(struct uclass *uc,
+					    const char *name, int len)
+{
+	struct udevice *dev;
+	uint i;
+
+	if (!gd_uclass_idx())
+		return NULL;
+	if (!uc->name_idx && uclass_build_name_idx(uc))
+		return NULL;
+	for (i = uclass_name_hash(name, len);; i++) {
+		dev = uc->name_idx[i & (uc->name_idx_size - 1)];
+		if (!dev)
+			return NULL;
+		if (!strncmp(dev->name, name, len) && !dev->name[len])
+			return dev;
 	}
+}
+#else
+static struct udevice *uclass_find_seq_idx(struct uclass *uc, int seq)
+{
+	return NULL;
+}
 
+static struct udevice *uclass_find_name_idx(struct uclass *uc,
+					    const char *name, int len)
+{
 	return NULL;
 }
+#endif
 
 /**
  * uclass_add() - Create new uclass in list
@@ -86,6 +258,8 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, DM_UCLASS_ROOT_NON_CONST);
+	if (gd_uclass_idx())
+		gd_uclass_idx()[id] = uc;
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -102,6 +276,8 @@ fail:
 		uclass_set_priv(uc, NULL);
 	}
 	list_del(&uc->sibling_node);
+	if (gd_uclass_idx())
+		gd_uclass_idx()[id] = NULL;
 fail_mem:
 	free(uc);
 
@@ -135,6 +311,9 @@ int uclass_destroy(struct uclass *uc)
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
+	if (gd_uclass_idx() && gd_uclass_idx()[uc_drv->id] == uc)
+		gd_uclass_idx()[uc_drv->id] = NULL;
+	uclass_index_invalidate(uc);
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
 	free(uc);
@@ -288,6 +467,10 @@ int uclass_find_device_by_namelen(enum uclass_id id, const char *name, int len,
 	if (ret)
 		return ret;
 
+	*devp = uclass_find_name_idx(uc, name, len);
+	if (*devp)
+		return 0;
+
 	uclass_foreach_dev(dev, uc) {
 		if (!strncmp(dev->name, name, len) &&
 		    strlen(dev->name) == len) {
@@ -336,12 +519,16 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq, struct udevice **devp)
 
 	*devp = NULL;
 	log_debug("%d\n", seq);
-	if (seq == -1)
+	if (seq < 0)
 		return -ENODEV;
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
 
+	*devp = uclass_find_seq_idx(uc, seq);
+	if (*devp)
+		return 0;
+
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d '%s'\n", dev->seq_, dev->name);
 		if (dev->seq_ == seq) {
@@ -694,6 +881,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_index_invalidate(uc);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -709,6 +897,7 @@ int uclass_bind_device(struct udevice *dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+	uclass_index_invalidate(uc);
 
 	return ret;
 }
@@ -732,6 +921,7 @@ int uclass_pre_unbind_device(struct udevice *dev)
 int uclass_unbind_device(struct udevice *dev)
 {
 	list_del(&dev->uclass_node);
+	uclass_index_invalidate(dev->uclass);
 
 	return 0;
 }
@@ -744,7 +934,11 @@ int uclass_pre_probe_device(struct udevice *dev)
 
 	uc_drv = dev->uclass->uc_drv;
 	if (uc_drv->pre_probe) {
+		ulong start_us = bootstage_event_start();
+
 		ret = uc_drv->pre_probe(dev);
+		bootstage_event_end(BOOTSTAGE_EVENT_PRE_PROBE, uc_drv->name,
+				    start_us);
 		if (ret)
 			return ret;
 	}
@@ -777,7 +971,11 @@ int uclass_post_probe_device(struct udevice *dev)
 
 	uc_drv = dev->uclass->uc_drv;
 	if (uc_drv->post_probe) {
+		ulong start_us = bootstage_event_start();
+
 		ret = uc_drv->post_probe(dev);
+		bootstage_event_end(BOOTSTAGE_EVENT_POST_PROBE, uc_drv->name,
+				    start_us);
 		if (ret)
 			return ret;
 	}
@@ -184,10 +184,23 @@ static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
 static enum dfu_device_type dfu_buf_device_type;
 
+/*
+ * Full buffers waiting to be written by dfu_write_pending(). They form a
+ * ring of CONFIG_DFU_WRITE_BUFFERS buffers, starting at dfu_wb_head and
+ * followed by the buffer being filled.
+ */
+static bool dfu_write_behind;
+static struct dfu_entity *dfu_wb_entity;
+static long dfu_wb_len[CONFIG_DFU_WRITE_BUFFERS];
+static int dfu_wb_head;
+static int dfu_wb_count;
+
 unsigned char *dfu_free_buf(void)
 {
 	free(dfu_buf);
 	dfu_buf = NULL;
+	dfu_wb_head = 0;
+	dfu_wb_count = 0;
 	return dfu_buf;
 }
 
@@ -217,10 +230,11 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 	if (dfu->max_buf_size && dfu_buf_size > dfu->max_buf_size)
 		dfu_buf_size = dfu->max_buf_size;
 
-	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+			   dfu_buf_size * CONFIG_DFU_WRITE_BUFFERS);
 	if (dfu_buf == NULL)
 		printf("%s: Could not memalign 0x%lx bytes\n",
-		       __func__, dfu_buf_size);
+		       __func__, dfu_buf_size * CONFIG_DFU_WRITE_BUFFERS);
 
 	dfu_buf_device_type = dfu->dev_type;
 	return dfu_buf;
@@ -243,31 +257,111 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
+static int dfu_write_buffer(struct dfu_entity *dfu, u8 *buf, long w_size)
+{
+	int ret;
+
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	if (ret)
+		debug("%s: Write error!\n", __func__);
+
+	/* update offset */
+	dfu->offset += w_size;
+
+	puts("#");
+
+	return ret;
+}
+
+/* Write the oldest queued buffer */
+static int dfu_write_buffer_queued(struct dfu_entity *dfu)
+{
+	u8 *buf = dfu_buf + dfu_wb_head * dfu_buf_size;
+	long w_size = dfu_wb_len[dfu_wb_head];
+
+	dfu_wb_head = (dfu_wb_head + 1) % CONFIG_DFU_WRITE_BUFFERS;
+	dfu_wb_count--;
+
+	return dfu_write_buffer(dfu, buf, w_size);
+}
+
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 {
 	long w_size;
 	int ret;
 
+	/* queued buffers go first, to keep the data in order */
+	while (dfu_wb_count) {
+		ret = dfu_write_buffer_queued(dfu);
+		if (ret)
+			return ret;
+	}
+
 	/* flush size? */
 	w_size = dfu->i_buf - dfu->i_buf_start;
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
-
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
-	if (ret)
-		debug("%s: Write error!\n", __func__);
+	ret = dfu_write_buffer(dfu, dfu->i_buf_start, w_size);
 
 	/* point back */
 	dfu->i_buf = dfu->i_buf_start;
 
-	/* update offset */
-	dfu->offset += w_size;
+	return ret;
+}
 
-	puts("#");
+/*
+ * Hand a full buffer over to dfu_write_pending() and start filling the next
+ * one. If write-behind is not in use, the buffer is written straight away.
+ */
+static int dfu_write_buffer_queue(struct dfu_entity *dfu)
+{
+	int ret, idx;
+
+	if (CONFIG_DFU_WRITE_BUFFERS == 1 || !dfu_write_behind)
+		return dfu_write_buffer_drain(dfu);
+
+	if (dfu->i_buf == dfu->i_buf_start)
+		return 0;
+
+	/* no free buffer left, so wait for the oldest one */
+	if (dfu_wb_count == CONFIG_DFU_WRITE_BUFFERS - 1) {
+		ret = dfu_write_buffer_queued(dfu);
+		if (ret)
+			return ret;
+	}
+
+	idx = (dfu_wb_head + dfu_wb_count) % CONFIG_DFU_WRITE_BUFFERS;
+	dfu_wb_len[idx] = dfu->i_buf - dfu->i_buf_start;
+	dfu_wb_count++;
+	dfu_wb_entity = dfu;
+
+	idx = (idx + 1) % CONFIG_DFU_WRITE_BUFFERS;
+	dfu->i_buf_start = dfu_buf + idx * dfu_buf_size;
+	dfu->i_buf_end = dfu->i_buf_start + dfu_buf_size;
+	dfu->i_buf = dfu->i_buf_start;
+
+	return 0;
+}
+
+void dfu_set_write_behind(bool enable)
+{
+	dfu_write_behind = enable;
+}
+
+int dfu_write_pending(void)
+{
+	struct dfu_entity *dfu = dfu_wb_entity;
+	int ret;
+
+	if (!dfu_wb_count)
+		return 0;
+
+	ret = dfu_write_buffer_queued(dfu);
+	if (ret) {
+		dfu_transaction_cleanup(dfu);
+		dfu_error_callback(dfu, "DFU write error");
+	}
 
 	return ret;
 }
@@ -278,6 +372,8 @@ void dfu_transaction_cleanup(struct dfu_entity *dfu)
 	dfu->crc = 0;
 	dfu->offset = 0;
 	dfu->i_blk_seq_num = 0;
+	dfu_wb_head = 0;
+	dfu_wb_count = 0;
 	dfu->i_buf_start = dfu_get_buf(dfu);
 	dfu->i_buf_end = dfu->i_buf_start;
 	dfu->i_buf = dfu->i_buf_start;
@@ -375,7 +471,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_queue(dfu);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			dfu_error_callback(dfu, "DFU write error");
@@ -395,14 +491,26 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	memcpy(dfu->i_buf, buf, size);
 	dfu->i_buf += size;
 
-	/* if end or if buffer full flush */
-	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
+	/* hash the data while it is still in the cache */
+	if (dfu_hash_algo && size)
+		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc, buf,
+					   size, 0);
+
+	/* if end flush, if buffer full queue it */
+	if (size == 0) {
 		ret = dfu_write_buffer_drain(dfu);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			dfu_error_callback(dfu, "DFU write error");
 			return ret;
 		}
+	} else if ((dfu->i_buf + size) > dfu->i_buf_end) {
+		ret = dfu_write_buffer_queue(dfu);
+		if (ret) {
+			dfu_transaction_cleanup(dfu);
+			dfu_error_callback(dfu, "DFU write error");
+			return ret;
+		}
 	}
 
 	return 0;
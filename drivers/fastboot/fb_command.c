@@ -267,7 +267,9 @@ u32 fastboot_data_remaining(void)
  *
  * Copies image data from fastboot_data to fastboot_buf_addr. Writes to
  * response. fastboot_bytes_received is updated to indicate the number
- * of bytes that have been transferred.
+ * of bytes that have been transferred. Data which the transport received in
+ * place, at the next position in fastboot_buf_addr, is not copied; data
+ * which landed further up in the buffer is moved down.
  *
  * On completion sets image_size and ${filesize} to the total size of the
  * downloaded image.
@@ -278,6 +280,7 @@ void fastboot_data_download(const void *fastboot_data,
 {
 #define BYTES_PER_DOT	0x20000
 	u32 pre_dot_num, now_dot_num;
+	void *dst;
 
 	if (fastboot_data_len == 0 ||
 	    (fastboot_bytes_received + fastboot_data_len) >
@@ -287,8 +290,9 @@ void fastboot_data_download(const void *fastboot_data,
 		return;
 	}
 	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	dst = fastboot_buf_addr + fastboot_bytes_received;
+	if (dst != fastboot_data)
+		memmove(dst, fastboot_data, fastboot_data_len);
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
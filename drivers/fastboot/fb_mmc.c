@@ -165,6 +165,35 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	if (fastboot_progress_callback)
+		fastboot_progress_callback("erasing");
+
+	return blk_derase(sparse->dev_desc, blk, blkcnt);
+}
+
+/*
+ * Let the sparse writer erase blocks for FILL chunks, on eMMC devices where
+ * the erased contents are known
+ */
+static void fb_mmc_sparse_setup_erase(struct sparse_storage *sparse,
+				      struct blk_desc *dev_desc)
+{
+	struct mmc *mmc = find_mmc_device(dev_desc->devnum);
+
+	if (!mmc || IS_SD(mmc) || !mmc->ext_csd || !mmc->erase_grp_size)
+		return;
+
+	sparse->erase = fb_mmc_sparse_erase;
+	sparse->erase_align = mmc->can_trim ? 1 : mmc->erase_grp_size;
+	sparse->erase_val = mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT] ?
+		0xffffffff : 0;
+}
+
 static void write_raw_image(struct blk_desc *dev_desc,
 			    struct disk_partition *info, const char *part_name,
 			    void *buffer, u32 download_bytes, char *response)
@@ -611,7 +640,7 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 
 	if (is_sparse_image(download_buffer)) {
 		struct fb_mmc_sparse sparse_priv;
-		struct sparse_storage sparse;
+		struct sparse_storage sparse = {};
 		int err;
 
 		sparse_priv.dev_desc = dev_desc;
@@ -622,6 +651,7 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
 		sparse.mssg = fastboot_fail;
+		fb_mmc_sparse_setup_erase(&sparse, dev_desc);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
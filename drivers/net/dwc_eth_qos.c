@@ -753,6 +753,7 @@ static int eqos_start(struct udevice *dev)
 
 	eqos->tx_desc_idx = 0;
 	eqos->rx_desc_idx = 0;
+	eqos->rx_ready = 0;
 
 	ret = eqos->config->ops->eqos_start_resets(dev);
 	if (ret < 0) {
@@ -1095,6 +1096,33 @@ err:
 	return ret;
 }
 
+/* Add the hardware's count of packets dropped on receive to the statistics */
+static void eqos_update_rx_missed(struct eqos_priv *eqos)
+{
+	u32 val = readl(&eqos->mtl_regs->rxq0_missed_packet_overflow_cnt);
+
+	eqos->stats[EQOS_STAT_RX_MISSED] +=
+		(val >> EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_MIS_SHIFT) &
+		EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_MIS_MASK;
+	eqos->stats[EQOS_STAT_RX_OVERRUNS] +=
+		val & EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_OVF_MASK;
+}
+
+/* Wait for the hardware to hand a TX descriptor back */
+static int eqos_tx_wait(struct eqos_priv *eqos, struct eqos_desc *tx_desc)
+{
+	int i;
+
+	for (i = 0; i < 1000000; i++) {
+		eqos->config->ops->eqos_inval_desc(tx_desc);
+		if (!(readl(&tx_desc->des3) & EQOS_DESC3_OWN))
+			return 0;
+		udelay(1);
+	}
+
+	return -ETIMEDOUT;
+}
+
 static void eqos_stop(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1104,6 +1132,13 @@ static void eqos_stop(struct udevice *dev)
 
 	if (!eqos->started)
 		return;
+
+	/* Let the last packet queued for transmission go out */
+	eqos_tx_wait(eqos, eqos_get_desc(eqos, (eqos->tx_desc_idx +
+						EQOS_DESCRIPTORS_TX - 1) %
+					 EQOS_DESCRIPTORS_TX, false));
+	eqos_update_rx_missed(eqos);
+
 	eqos->started = false;
 	eqos->reg_access_ok = false;
 
@@ -1152,20 +1187,35 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
 	struct eqos_desc *tx_desc;
-	int i;
+	void *buf;
 
 	debug("%s(dev=%p, packet=%p, length=%d):\n", __func__, dev, packet,
 	      length);
 
-	memcpy(eqos->tx_dma_buf, packet, length);
-	eqos->config->ops->eqos_flush_buffer(eqos->tx_dma_buf, length);
-
+	/*
+	 * Each descriptor has its own buffer, so there is no need to wait for
+	 * the packet to be sent, only for the descriptor to be free
+	 */
 	tx_desc = eqos_get_desc(eqos, eqos->tx_desc_idx, false);
+	if (eqos_tx_wait(eqos, tx_desc)) {
+		debug("%s: TX timeout\n", __func__);
+		eqos->stats[EQOS_STAT_TX_DROPPED]++;
+		return -ETIMEDOUT;
+	}
+
+	/* Pick up the status of the last packet sent with this descriptor */
+	if (tx_desc->des3 & EQOS_DESC3_ES)
+		eqos->stats[EQOS_STAT_TX_ERRORS]++;
+
+	buf = eqos->tx_dma_buf + eqos->tx_desc_idx * EQOS_MAX_PACKET_SIZE;
+	memcpy(buf, packet, length);
+	eqos->config->ops->eqos_flush_buffer(buf, length);
+
 	eqos->tx_desc_idx++;
 	eqos->tx_desc_idx %= EQOS_DESCRIPTORS_TX;
 
-	tx_desc->des0 = lower_32_bits((ulong)eqos->tx_dma_buf);
-	tx_desc->des1 = upper_32_bits((ulong)eqos->tx_dma_buf);
+	tx_desc->des0 = lower_32_bits((ulong)buf);
+	tx_desc->des1 = upper_32_bits((ulong)buf);
 	tx_desc->des2 = length;
 	/*
 	 * Make sure that if HW sees the _OWN write below, it will see all the
@@ -1177,17 +1227,46 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 
 	writel((ulong)eqos_get_desc(eqos, eqos->tx_desc_idx, false),
 		&eqos->dma_regs->ch0_txdesc_tail_pointer);
+	eqos->stats[EQOS_STAT_TX_PACKETS]++;
+	eqos->stats[EQOS_STAT_TX_BYTES] += length;
 
-	for (i = 0; i < 1000000; i++) {
-		eqos->config->ops->eqos_inval_desc(tx_desc);
-		if (!(readl(&tx_desc->des3) & EQOS_DESC3_OWN))
-			return 0;
-		udelay(1);
+	/*
+	 * Flushing a descriptor writes back its whole cache line. If that is
+	 * shared with other descriptors, none of them may be owned by the
+	 * hardware when the next one is flushed, or its updates to them would
+	 * be overwritten. So wait for the packet to go out.
+	 */
+	if (eqos->desc_per_cacheline > 1 && eqos_tx_wait(eqos, tx_desc)) {
+		debug("%s: TX timeout\n", __func__);
+		return -ETIMEDOUT;
 	}
 
-	debug("%s: TX timeout\n", __func__);
+	return 0;
+}
 
-	return -ETIMEDOUT;
+/*
+ * Count the descriptors from rx_desc_idx onwards which have been filled by the
+ * hardware, up to the end of the ring. These are invalidated with a single
+ * cache operation, rather than one for each packet. Descriptors which are
+ * found to be filled stay that way until they are freed, so they need not be
+ * invalidated again.
+ */
+static int eqos_rx_scan(struct eqos_priv *eqos)
+{
+	struct eqos_desc *rx_desc;
+	int count, i;
+
+	count = min(ETH_PACKETS_BATCH_RECV,
+		    EQOS_DESCRIPTORS_RX - eqos->rx_desc_idx);
+	rx_desc = eqos_get_desc(eqos, eqos->rx_desc_idx, true);
+	eqos->config->ops->eqos_inval_buffer(rx_desc, count * eqos->desc_size);
+	for (i = 0; i < count; i++) {
+		rx_desc = eqos_get_desc(eqos, eqos->rx_desc_idx + i, true);
+		if (rx_desc->des3 & EQOS_DESC3_OWN)
+			break;
+	}
+
+	return i;
 }
 
 static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
@@ -1196,10 +1275,12 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	struct eqos_desc *rx_desc;
 	int length;
 
+	if (!eqos->rx_ready) {
+		eqos->rx_ready = eqos_rx_scan(eqos);
+		if (!eqos->rx_ready)
+			return -EAGAIN;
+	}
 	rx_desc = eqos_get_desc(eqos, eqos->rx_desc_idx, true);
-	eqos->config->ops->eqos_inval_desc(rx_desc);
-	if (rx_desc->des3 & EQOS_DESC3_OWN)
-		return -EAGAIN;
 
 	debug("%s(dev=%p, flags=%x):\n", __func__, dev, flags);
 
@@ -1208,6 +1289,11 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	length = rx_desc->des3 & 0x7fff;
 	debug("%s: *packetp=%p, length=%d\n", __func__, *packetp, length);
 
+	if (rx_desc->des3 & EQOS_DESC3_ES)
+		eqos->stats[EQOS_STAT_RX_ERRORS]++;
+	eqos->stats[EQOS_STAT_RX_PACKETS]++;
+	eqos->stats[EQOS_STAT_RX_BYTES] += length;
+
 	eqos->config->ops->eqos_inval_buffer(*packetp, length);
 
 	return length;
@@ -1262,10 +1348,43 @@ static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 
 	eqos->rx_desc_idx++;
 	eqos->rx_desc_idx %= EQOS_DESCRIPTORS_RX;
+	if (eqos->rx_ready)
+		eqos->rx_ready--;
 
 	return 0;
 }
 
+static const char eqos_stat_strings[EQOS_STAT_COUNT][ETH_GSTRING_LEN] = {
+	[EQOS_STAT_RX_PACKETS]	= "rx_packets",
+	[EQOS_STAT_RX_BYTES]	= "rx_bytes",
+	[EQOS_STAT_RX_ERRORS]	= "rx_errors",
+	[EQOS_STAT_RX_MISSED]	= "rx_missed",
+	[EQOS_STAT_RX_OVERRUNS]	= "rx_overruns",
+	[EQOS_STAT_TX_PACKETS]	= "tx_packets",
+	[EQOS_STAT_TX_BYTES]	= "tx_bytes",
+	[EQOS_STAT_TX_ERRORS]	= "tx_errors",
+	[EQOS_STAT_TX_DROPPED]	= "tx_dropped",
+};
+
+static int eqos_get_sset_count(struct udevice *dev)
+{
+	return EQOS_STAT_COUNT;
+}
+
+static void eqos_get_strings(struct udevice *dev, u8 *data)
+{
+	memcpy(data, eqos_stat_strings, sizeof(eqos_stat_strings));
+}
+
+static void eqos_get_stats(struct udevice *dev, u64 *data)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+
+	if (eqos->started)
+		eqos_update_rx_missed(eqos);
+	memcpy(data, eqos->stats, sizeof(eqos->stats));
+}
+
 static int eqos_probe_resources_core(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1290,6 +1409,14 @@ static int eqos_probe_resources_core(struct udevice *dev)
 	}
 	eqos->desc_per_cacheline = ARCH_DMA_MINALIGN / eqos->desc_size;
 
+	/* Receive descriptors are returned to the hardware a cache line at a time */
+	if (EQOS_DESCRIPTORS_RX % eqos->desc_per_cacheline) {
+		log_err("RX descriptors must be a multiple of %d\n",
+			eqos->desc_per_cacheline);
+		ret = -EINVAL;
+		goto err;
+	}
+
 	eqos->tx_descs = eqos_alloc_descs(eqos, EQOS_DESCRIPTORS_TX);
 	if (!eqos->tx_descs) {
 		debug("%s: eqos_alloc_descs(tx) failed\n", __func__);
@@ -1304,7 +1431,7 @@ static int eqos_probe_resources_core(struct udevice *dev)
 		goto err_free_tx_descs;
 	}
 
-	eqos->tx_dma_buf = memalign(EQOS_BUFFER_ALIGN, EQOS_MAX_PACKET_SIZE);
+	eqos->tx_dma_buf = memalign(EQOS_BUFFER_ALIGN, EQOS_TX_BUFFER_SIZE);
 	if (!eqos->tx_dma_buf) {
 		debug("%s: memalign(tx_dma_buf) failed\n", __func__);
 		ret = -ENOMEM;
@@ -1603,6 +1730,9 @@ static const struct eth_ops eqos_ops = {
 	.free_pkt = eqos_free_pkt,
 	.write_hwaddr = eqos_write_hwaddr,
 	.read_rom_hwaddr	= eqos_read_rom_hwaddr,
+	.get_sset_count = eqos_get_sset_count,
+	.get_strings = eqos_get_strings,
+	.get_stats = eqos_get_stats,
 };
 
 static struct eqos_ops eqos_tegra186_ops = {
@@ -103,7 +103,7 @@ struct eqos_mtl_regs {
 	u32 txq0_quantum_weight;			/* 0xd18 */
 	u32 unused_d1c[(0xd30 - 0xd1c) / 4];	/* 0xd1c */
 	u32 rxq0_operation_mode;			/* 0xd30 */
-	u32 unused_d34;				/* 0xd34 */
+	u32 rxq0_missed_packet_overflow_cnt;	/* 0xd34 */
 	u32 rxq0_debug;				/* 0xd38 */
 };
 
@@ -128,6 +128,10 @@ struct eqos_mtl_regs {
 #define EQOS_MTL_RXQ0_OPERATION_MODE_EHFC		BIT(7)
 #define EQOS_MTL_RXQ0_OPERATION_MODE_RSF		BIT(5)
 
+#define EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_MIS_SHIFT	16
+#define EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_MIS_MASK	0x7ff
+#define EQOS_MTL_RXQ0_MISSED_PACKET_OVERFLOW_CNT_OVF_MASK	0x7ff
+
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_SHIFT			16
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_MASK			0x7fff
 #define EQOS_MTL_RXQ0_DEBUG_RXQSTS_SHIFT		4
@@ -194,11 +198,12 @@ struct eqos_tegra186_regs {
 #define EQOS_AUTO_CAL_STATUS_ACTIVE			BIT(31)
 
 /* Descriptors */
-#define EQOS_DESCRIPTORS_TX	4
-#define EQOS_DESCRIPTORS_RX	4
+#define EQOS_DESCRIPTORS_TX	CONFIG_DWC_ETH_QOS_TX_DESCS
+#define EQOS_DESCRIPTORS_RX	CONFIG_DWC_ETH_QOS_RX_DESCS
 #define EQOS_DESCRIPTORS_NUM	(EQOS_DESCRIPTORS_TX + EQOS_DESCRIPTORS_RX)
 #define EQOS_BUFFER_ALIGN	ARCH_DMA_MINALIGN
 #define EQOS_MAX_PACKET_SIZE	ALIGN(1568, ARCH_DMA_MINALIGN)
+#define EQOS_TX_BUFFER_SIZE	(EQOS_DESCRIPTORS_TX * EQOS_MAX_PACKET_SIZE)
 #define EQOS_RX_BUFFER_SIZE	(EQOS_DESCRIPTORS_RX * EQOS_MAX_PACKET_SIZE)
 
 struct eqos_desc {
@@ -212,6 +217,7 @@ struct eqos_desc {
 #define EQOS_DESC3_FD		BIT(29)
 #define EQOS_DESC3_LD		BIT(28)
 #define EQOS_DESC3_BUF1V	BIT(24)
+#define EQOS_DESC3_ES		BIT(15)
 
 #define EQOS_AXI_WIDTH_32	4
 #define EQOS_AXI_WIDTH_64	8
@@ -246,6 +252,21 @@ struct eqos_ops {
 	ulong (*eqos_get_tick_clk_rate)(struct udevice *dev);
 };
 
+/* Statistics counters, shown by 'net stats' */
+enum eqos_stat {
+	EQOS_STAT_RX_PACKETS,
+	EQOS_STAT_RX_BYTES,
+	EQOS_STAT_RX_ERRORS,
+	EQOS_STAT_RX_MISSED,
+	EQOS_STAT_RX_OVERRUNS,
+	EQOS_STAT_TX_PACKETS,
+	EQOS_STAT_TX_BYTES,
+	EQOS_STAT_TX_ERRORS,
+	EQOS_STAT_TX_DROPPED,
+
+	EQOS_STAT_COUNT,
+};
+
 struct eqos_priv {
 	struct udevice *dev;
 	const struct eqos_config *config;
@@ -270,6 +291,7 @@ struct eqos_priv {
 	void *tx_descs;
 	void *rx_descs;
 	int tx_desc_idx, rx_desc_idx;
+	int rx_ready;
 	unsigned int desc_size;
 	unsigned int desc_per_cacheline;
 	void *tx_dma_buf;
@@ -279,6 +301,7 @@ struct eqos_priv {
 	bool clk_ck_enabled;
 	unsigned int tx_fifo_sz, rx_fifo_sz;
 	u32 reset_delays[3];
+	u64 stats[EQOS_STAT_COUNT];
 };
 
 void eqos_inval_desc_generic(void *desc);
@@ -799,6 +799,10 @@ out:
 
 /**
  * Pull one frame from the card
+ *
+ * The frame is passed up in place in its DMA buffer. The descriptor stays
+ * owned by us until fecmxc_free_pkt() hands it back to the hardware.
+ *
  * @param[in] dev Our ethernet device to handle
  * Return: Length of packet read
  */
@@ -810,14 +814,8 @@ static int fecmxc_recv(struct udevice *dev, int flags, uchar **packetp)
 	int frame_length, len = 0;
 	uint16_t bd_status;
 	ulong addr, size, end;
-	int i;
-
-	*packetp = memalign(ARCH_DMA_MINALIGN, FEC_MAX_PKT_SIZE);
-	if (*packetp == 0) {
-		printf("%s: error allocating packetp\n", __func__);
-		return -ENOMEM;
-	}
 
+	*packetp = NULL;
 	if (!(readl(&fec->eth->ecntrl) & FEC_ECNTRL_ETHER_EN))
 		return 0;
 
@@ -868,49 +866,27 @@ static int fecmxc_recv(struct udevice *dev, int flags, uchar **packetp)
 	debug("fec_recv: status 0x%x\n", bd_status);
 
 	if (!(bd_status & FEC_RBD_EMPTY)) {
+		addr = readl(&rbd->data_pointer);
+		*packetp = (uchar *)addr;
 		if ((bd_status & FEC_RBD_LAST) && !(bd_status & FEC_RBD_ERR) &&
 		    ((readw(&rbd->data_length) - 4) > 14)) {
-			/* Get buffer address and size */
-			addr = readl(&rbd->data_pointer);
+			/* Get buffer size */
 			frame_length = readw(&rbd->data_length) - 4;
 			/* Invalidate data cache over the buffer */
 			end = roundup(addr + frame_length, ARCH_DMA_MINALIGN);
 			addr &= ~(ARCH_DMA_MINALIGN - 1);
 			invalidate_dcache_range(addr, end);
 
-			/* Fill the buffer and pass it to upper layers */
+			/* Pass the buffer to upper layers */
 #ifdef CFG_FEC_MXC_SWAP_PACKET
 			swap_packet((uint32_t *)addr, frame_length);
 #endif
-
-			memcpy(*packetp, (char *)addr, frame_length);
 			len = frame_length;
 		} else {
 			if (bd_status & FEC_RBD_ERR)
 				debug("error frame: 0x%08lx 0x%08x\n",
 				      addr, bd_status);
 		}
-
-		/*
-		 * Free the current buffer, restart the engine and move forward
-		 * to the next buffer. Here we check if the whole cacheline of
-		 * descriptors was already processed and if so, we mark it free
-		 * as whole.
-		 */
-		size = RXDESC_PER_CACHELINE - 1;
-		if ((fec->rbd_index & size) == size) {
-			i = fec->rbd_index - size;
-			addr = (ulong)&fec->rbd_base[i];
-			for (; i <= fec->rbd_index ; i++) {
-				fec_rbd_clean(i == (FEC_RBD_NUM - 1),
-					      &fec->rbd_base[i]);
-			}
-			flush_dcache_range(addr,
-					   addr + ARCH_DMA_MINALIGN);
-		}
-
-		fec_rx_task_enable(fec);
-		fec->rbd_index = (fec->rbd_index + 1) % FEC_RBD_NUM;
 	}
 	debug("fec_recv: stop\n");
 
@@ -1117,8 +1093,41 @@ static int fecmxc_set_promisc(struct udevice *dev, bool enable)
 
 static int fecmxc_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
-	if (packet)
-		free(packet);
+	struct fec_priv *fec = dev_get_priv(dev);
+	struct fec_bd *rbd = &fec->rbd_base[fec->rbd_index];
+	ulong addr, size;
+	int i;
+
+	/* Nothing to do unless this is the frame returned by fecmxc_recv() */
+	if (!packet || (ulong)packet != (ulong)readl(&rbd->data_pointer))
+		return 0;
+
+	/*
+	 * The stack may have written to the buffer while processing the frame,
+	 * so drop those lines before the hardware fills it again
+	 */
+	addr = (ulong)packet;
+	size = roundup(FEC_MAX_PKT_SIZE, FEC_DMA_RX_MINALIGN);
+	invalidate_dcache_range(addr, addr + size);
+
+	/*
+	 * Free the current buffer, restart the engine and move forward to the
+	 * next buffer. Here we check if the whole cacheline of descriptors was
+	 * already processed and if so, we mark it free as whole.
+	 */
+	size = RXDESC_PER_CACHELINE - 1;
+	if ((fec->rbd_index & size) == size) {
+		i = fec->rbd_index - size;
+		addr = (ulong)&fec->rbd_base[i];
+		for (; i <= fec->rbd_index ; i++) {
+			fec_rbd_clean(i == (FEC_RBD_NUM - 1),
+				      &fec->rbd_base[i]);
+		}
+		flush_dcache_range(addr, addr + ARCH_DMA_MINALIGN);
+	}
+
+	fec_rx_task_enable(fec);
+	fec->rbd_index = (fec->rbd_index + 1) % FEC_RBD_NUM;
 
 	return 0;
 }
@@ -6,6 +6,7 @@
 #include <command.h>
 #include <config.h>
 #include <dm.h>
+#include <early_arena.h>
 #include <hang.h>
 #include <i2c.h>
 #include <ram.h>
@@ -2564,6 +2565,7 @@ static int octeon_ddr_probe(struct udevice *dev)
 	struct ddr_priv *priv = dev_get_priv(dev);
 	struct ofnode_phandle_args l2c_node;
 	struct ddr_conf *ddr_conf_ptr;
+	struct ram_info *info;
 	u32 ddr_conf_valid_mask = 0;
 	u32 measured_ddr_hertz = 0;
 	int conf_table_count;
@@ -2579,9 +2581,18 @@ static int octeon_ddr_probe(struct udevice *dev)
 	int ret;
 	int i;
 
-	/* Don't try to re-init the DDR controller after relocation */
-	if (gd->flags & GD_FLG_RELOC)
+	/*
+	 * Don't try to re-init the DDR controller after relocation, but use
+	 * the results from before, if they were kept
+	 */
+	if (gd->flags & GD_FLG_RELOC) {
+		if (IS_ENABLED(CONFIG_EARLY_ARENA)) {
+			info = early_arena_find(EARLY_ARENA_DRAM, NULL);
+			if (info)
+				priv->info = *info;
+		}
 		return 0;
+	}
 
 	/*
 	 * Dummy read all local variables into cache, so that they are
@@ -2689,6 +2700,11 @@ static int octeon_ddr_probe(struct udevice *dev)
 
 	priv->info.base = CFG_SYS_SDRAM_BASE;
 	priv->info.size = MB(mem_mbytes);
+	if (IS_ENABLED(CONFIG_EARLY_ARENA)) {
+		info = early_arena_alloc(EARLY_ARENA_DRAM, sizeof(*info));
+		if (info)
+			*info = priv->info;
+	}
 
 	/*
 	 * For 6XXX generate a proper error when reading/writing
@@ -15,6 +15,7 @@
 #include <env.h>
 #include <errno.h>
 #include <fastboot.h>
+#include <fastboot-internal.h>
 #include <log.h>
 #include <malloc.h>
 #include <linux/printk.h>
@@ -55,6 +56,13 @@ struct f_fastboot {
 	struct usb_request *in_req, *out_req;
 
 	usb_req *front, *rear;
+
+	/* Requests which receive a download straight into its buffer */
+	struct usb_request *dl_req[CONFIG_FASTBOOT_USB_XFER_COUNT];
+	u32 dl_busy;		/* bit mask of queued download requests */
+	u32 dl_size;		/* total size of the download */
+	u32 dl_next;		/* buffer offset for the next request */
+	u32 dl_inflight;	/* bytes requested but not yet completed */
 };
 
 static char fb_ext_prop_name[] = "DeviceInterfaceGUID";
@@ -209,6 +217,7 @@ extern struct stdio_dev g_fastboot_stdio;
 #endif
 
 static void rx_handler_command(struct usb_ep *ep, struct usb_request *req);
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req);
 
 static void fastboot_fifo_complete(struct usb_ep *ep, struct usb_request *req)
 {
@@ -325,10 +334,20 @@ static void fastboot_unbind(struct usb_configuration *c, struct usb_function *f)
 static void fastboot_disable(struct usb_function *f)
 {
 	struct f_fastboot *f_fb = func_to_fastboot(f);
+	int i;
 
 	usb_ep_disable(f_fb->out_ep);
 	usb_ep_disable(f_fb->in_ep);
 
+	/* The buffers belong to the download buffer, so are not freed */
+	for (i = 0; i < ARRAY_SIZE(f_fb->dl_req); i++) {
+		if (f_fb->dl_req[i]) {
+			usb_ep_free_request(f_fb->out_ep, f_fb->dl_req[i]);
+			f_fb->dl_req[i] = NULL;
+		}
+	}
+	f_fb->dl_busy = 0;
+
 	if (f_fb->out_req) {
 		free(f_fb->out_req->buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
@@ -368,6 +387,7 @@ static int fastboot_set_alt(struct usb_function *f,
 	struct usb_gadget *gadget = cdev->gadget;
 	struct f_fastboot *f_fb = func_to_fastboot(f);
 	const struct usb_endpoint_descriptor *d;
+	int i;
 
 	debug("%s: func: %s intf: %d alt: %d\n",
 	      __func__, f->name, interface, alt);
@@ -387,6 +407,16 @@ static int fastboot_set_alt(struct usb_function *f,
 	}
 	f_fb->out_req->complete = rx_handler_command;
 
+	for (i = 0; i < ARRAY_SIZE(f_fb->dl_req); i++) {
+		f_fb->dl_req[i] = usb_ep_alloc_request(f_fb->out_ep, 0);
+		if (!f_fb->dl_req[i]) {
+			puts("failed to alloc out req\n");
+			ret = -EINVAL;
+			goto err;
+		}
+		f_fb->dl_req[i]->complete = rx_handler_dl_direct;
+	}
+
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in, &ss_ep_in);
 	ret = usb_ep_enable(f_fb->in_ep, d);
 	if (ret) {
@@ -592,6 +622,111 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	usb_ep_queue(ep, req, 0);
 }
 
+/*
+ * Check whether the download can be received in place. The buffer must be
+ * suitably aligned for DMA, with room for the last request to be rounded up
+ * to a whole number of packets
+ */
+static bool fastboot_dl_direct(struct usb_ep *ep)
+{
+	unsigned int maxpacket = usb_endpoint_maxp(ep->desc);
+
+	return IS_ALIGNED((ulong)fastboot_buf_addr, CONFIG_SYS_CACHELINE_SIZE) &&
+		fastboot_data_remaining() + maxpacket <= fastboot_buf_size;
+}
+
+/* Queue download requests for as much of the remaining data as possible */
+static void fastboot_dl_queue(struct f_fastboot *f_fb)
+{
+	struct usb_ep *ep = f_fb->out_ep;
+	unsigned int maxpacket = usb_endpoint_maxp(ep->desc);
+	u32 remaining, received, len;
+	struct usb_request *req;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(f_fb->dl_req); i++) {
+		if (f_fb->dl_busy & BIT(i))
+			continue;
+		remaining = fastboot_data_remaining();
+		if (remaining <= f_fb->dl_inflight)
+			break;
+		len = min_t(u32, remaining - f_fb->dl_inflight,
+			    CONFIG_FASTBOOT_USB_XFER_SIZE);
+		len = roundup(len, maxpacket);
+
+		/*
+		 * Requests normally follow on from each other. After a short
+		 * transfer the data has been moved down, so once nothing is
+		 * outstanding start again just above it
+		 */
+		if (!f_fb->dl_inflight) {
+			received = f_fb->dl_size - remaining;
+			f_fb->dl_next = ALIGN(received, CONFIG_SYS_CACHELINE_SIZE);
+			if (f_fb->dl_next + len > fastboot_buf_size)
+				f_fb->dl_next = received;
+		}
+		if (f_fb->dl_next + len > fastboot_buf_size)
+			break;
+
+		req = f_fb->dl_req[i];
+		req->buf = fastboot_buf_addr + f_fb->dl_next;
+		req->length = len;
+		req->actual = 0;
+		if (usb_ep_queue(ep, req, 0)) {
+			printf("Error on download queue\n");
+			break;
+		}
+		f_fb->dl_busy |= BIT(i);
+		f_fb->dl_next += len;
+		f_fb->dl_inflight += len;
+	}
+}
+
+static void fastboot_dl_start(struct f_fastboot *f_fb)
+{
+	f_fb->dl_size = fastboot_data_remaining();
+	f_fb->dl_next = 0;
+	f_fb->dl_inflight = 0;
+	fastboot_dl_queue(f_fb);
+}
+
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	unsigned int transfer_size = fastboot_data_remaining();
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(f_fb->dl_req); i++) {
+		if (f_fb->dl_req[i] == req)
+			f_fb->dl_busy &= ~BIT(i);
+	}
+	f_fb->dl_inflight -= min(f_fb->dl_inflight, req->length);
+
+	if (req->status != 0) {
+		printf("Bad status: %d\n", req->status);
+		return;
+	}
+
+	if (req->actual < transfer_size)
+		transfer_size = req->actual;
+
+	fastboot_data_download(req->buf, transfer_size, response);
+	if (response[0]) {
+		fastboot_tx_write_str(response);
+	} else if (!fastboot_data_remaining()) {
+		fastboot_data_complete(response);
+		fastboot_tx_write_str(response);
+
+		/* Every request has now completed, so wait for a command */
+		f_fb->out_req->actual = 0;
+		usb_ep_queue(ep, f_fb->out_req, 0);
+		return;
+	}
+
+	fastboot_dl_queue(f_fb);
+}
+
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	g_dnl_trigger_detach();
@@ -636,6 +771,7 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmdbuf = req->buf;
 	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	bool direct = false;
 	int cmd = -1;
 
 	/* init in request FIFO pointer */
@@ -664,8 +800,12 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 	}
 
 	if (!strncmp("DATA", response, 4)) {
-		req->complete = rx_handler_dl_image;
-		req->length = rx_bytes_expected(ep);
+		if (fastboot_dl_direct(ep)) {
+			direct = true;
+		} else {
+			req->complete = rx_handler_dl_image;
+			req->length = rx_bytes_expected(ep);
+		}
 	}
 
 	if (!strncmp("OKAY", response, 4)) {
@@ -698,5 +838,8 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 
 	*cmdbuf = '\0';
 	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+	if (direct)
+		fastboot_dl_start(fastboot_func);
+	else
+		usb_ep_queue(ep, req, 0);
 }
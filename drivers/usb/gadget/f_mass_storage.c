@@ -250,6 +250,7 @@
 #include <linux/bug.h>
 
 #include <linux/err.h>
+#include <linux/math64.h>
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <usb_mass_storage.h>
@@ -346,6 +347,14 @@ struct fsg_common {
 	 * hexadecimal digits) and NUL byte */
 	char inquiry_string[8 + 16 + 4 + 1];
 
+	/* Transfer statistics, reported when the function is released */
+	u64			bytes_read;
+	u64			bytes_written;
+	ulong			read_ms;	/* time in READ commands */
+	ulong			write_ms;	/* time in WRITE commands */
+	ulong			read_storage_ms; /* time reading storage */
+	ulong			write_storage_ms; /* time writing storage */
+
 	struct kref		ref;
 };
 
@@ -704,6 +713,7 @@ static int do_read(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nread;
+	ulong			start, io_start;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -730,6 +740,7 @@ static int do_read(struct fsg_common *common)
 	amount_left = common->data_size_from_cmnd;
 	if (unlikely(amount_left == 0))
 		return -EIO;		/* No default reply */
+	start = get_timer(0);
 
 	for (;;) {
 
@@ -766,11 +777,19 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
+		/*
+		 * Let the controller move on to the next queued transfer
+		 * before blocking on the storage device
+		 */
+		dm_usb_gadget_handle_interrupts(udcdev);
+
 		/* Perform the read */
+		io_start = get_timer(0);
 		rc = ums[common->lun].read_sector(&ums[common->lun],
 				      file_offset / SECTOR_SIZE,
 				      amount / SECTOR_SIZE,
 				      (char __user *)bh->buf);
+		common->read_storage_ms += get_timer(io_start);
 		if (!rc)
 			return -EIO;
 
@@ -792,6 +811,7 @@ static int do_read(struct fsg_common *common)
 		file_offset  += nread;
 		amount_left  -= nread;
 		common->residue -= nread;
+		common->bytes_read += nread;
 		bh->inreq->length = nread;
 		bh->state = BUF_STATE_FULL;
 
@@ -814,6 +834,7 @@ static int do_read(struct fsg_common *common)
 			return -EIO;
 		common->next_buffhd_to_fill = bh->next;
 	}
+	common->read_ms += get_timer(start);
 
 	return -EIO;		/* No default reply */
 }
@@ -824,13 +845,14 @@ static int do_write(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
 	u32			lba;
-	struct fsg_buffhd	*bh;
+	struct fsg_buffhd	*bh, *last;
 	int			get_some_more;
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset;
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nwritten;
+	ulong			start, io_start;
 	int			rc;
 
 	if (curlun->ro) {
@@ -864,6 +886,7 @@ static int do_write(struct fsg_common *common)
 	file_offset = usb_offset = ((loff_t) lba) << 9;
 	amount_left_to_req = common->data_size_from_cmnd;
 	amount_left_to_write = common->data_size_from_cmnd;
+	start = get_timer(0);
 
 	while (amount_left_to_write > 0) {
 
@@ -938,13 +961,35 @@ static int do_write(struct fsg_common *common)
 				break;
 			}
 
+			/*
+			 * Let the controller move on to the next queued
+			 * transfer before blocking on the storage device. Any
+			 * following buffers which are full and next in memory
+			 * are written along with this one, as long as the
+			 * data so far fills each buffer completely. The first
+			 * buffer of a command can be cut short to reach a
+			 * page boundary
+			 */
+			dm_usb_gadget_handle_interrupts(udcdev);
 			amount = bh->outreq->actual;
+			for (last = bh;
+			     last->outreq->actual == FSG_BUFLEN &&
+			     last->next->state == BUF_STATE_FULL &&
+			     last->next->buf == last->buf + FSG_BUFLEN &&
+			     !last->next->outreq->status;
+			     last = last->next) {
+				last->next->state = BUF_STATE_EMPTY;
+				amount += last->next->outreq->actual;
+			}
+			common->next_buffhd_to_drain = last->next;
 
 			/* Perform the write */
+			io_start = get_timer(0);
 			rc = ums[common->lun].write_sector(&ums[common->lun],
 					       file_offset / SECTOR_SIZE,
 					       amount / SECTOR_SIZE,
 					       (char __user *)bh->buf);
+			common->write_storage_ms += get_timer(io_start);
 			if (!rc)
 				return -EIO;
 			nwritten = rc * SECTOR_SIZE;
@@ -966,6 +1011,7 @@ static int do_write(struct fsg_common *common)
 			file_offset += nwritten;
 			amount_left_to_write -= nwritten;
 			common->residue -= nwritten;
+			common->bytes_written += nwritten;
 
 			/* If an error occurred, report it and its position */
 			if (nwritten < amount) {
@@ -977,7 +1023,7 @@ static int do_write(struct fsg_common *common)
 			}
 
 			/* Did the host decide to stop early? */
-			if (bh->outreq->actual != bh->outreq->length) {
+			if (last->outreq->actual != last->outreq->length) {
 				common->short_packet_received = 1;
 				break;
 			}
@@ -989,6 +1035,7 @@ static int do_write(struct fsg_common *common)
 		if (rc)
 			return rc;
 	}
+	common->write_ms += get_timer(start);
 
 	return -EIO;		/* No default reply */
 }
@@ -2450,6 +2497,7 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	struct fsg_buffhd *bh;
 	struct fsg_lun *curlun;
 	int nluns, i, rc;
+	void *buf;
 
 	/* Find out how many LUNs there should be */
 	nluns = ums_count;
@@ -2503,7 +2551,16 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
-	/* Data buffers cyclic list */
+	/*
+	 * Data buffers cyclic list. The buffers are allocated together, so
+	 * that neighbours can be written to storage in one go
+	 */
+	BUILD_BUG_ON(FSG_BUFLEN % PAGE_CACHE_SIZE);
+	buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_NUM_BUFFERS * FSG_BUFLEN);
+	if (unlikely(!buf)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
 	bh = common->buffhds;
 
 	i = FSG_NUM_BUFFERS;
@@ -2514,11 +2571,8 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 buffhds_first_it:
 		bh->inreq_busy = 0;
 		bh->outreq_busy = 0;
-		bh->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
-		if (unlikely(!bh->buf)) {
-			rc = -ENOMEM;
-			goto error_release;
-		}
+		bh->buf = buf;
+		buf += FSG_BUFLEN;
 	} while (--i);
 	bh->next = common->buffhds;
 
@@ -2559,6 +2613,17 @@ error_release:
 	return ERR_PTR(rc);
 }
 
+static void fsg_print_stats(const char *what, u64 bytes, ulong ms,
+			    ulong storage_ms)
+{
+	if (!bytes)
+		return;
+
+	printf("UMS: %s %llu MiB in %lu ms (%llu KiB/s), %lu ms in storage\n",
+	       what, bytes >> 20, ms, div_u64(bytes * 1000, max(ms, 1UL)) >> 10,
+	       storage_ms);
+}
+
 static void fsg_common_release(struct kref *ref)
 {
 	struct fsg_common *common = container_of(ref, struct fsg_common, ref);
@@ -2580,13 +2645,13 @@ static void fsg_common_release(struct kref *ref)
 		kfree(common->luns);
 	}
 
-	{
-		struct fsg_buffhd *bh = common->buffhds;
-		unsigned i = FSG_NUM_BUFFERS;
-		do {
-			kfree(bh->buf);
-		} while (++bh, --i);
-	}
+	/* All the buffers are in one allocation */
+	kfree(common->buffhds[0].buf);
+
+	fsg_print_stats("read", common->bytes_read, common->read_ms,
+			common->read_storage_ms);
+	fsg_print_stats("wrote", common->bytes_written, common->write_ms,
+			common->write_storage_ms);
 
 	if (common->free_storage_on_release)
 		kfree(common);
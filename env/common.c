@@ -15,6 +15,7 @@
 #include <log.h>
 #include <sort.h>
 #include <asm/global_data.h>
+#include <linux/log2.h>
 #include <linux/printk.h>
 #include <linux/stddef.h>
 #include <search.h>
@@ -44,6 +45,19 @@ struct hsearch_data env_htab = {
  */
 static int env_id = 1;
 
+/*
+ * Set when the environment in env_htab was imported from storage, so that
+ * env_relocate() does not need to load it again. This is in BSS so is only
+ * written once the full malloc() pool is available, i.e. after relocation.
+ */
+static bool env_loaded;
+
+static void env_set_loaded(bool loaded)
+{
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT)
+		env_loaded = loaded;
+}
+
 int env_get_id(void)
 {
 	return env_id;
@@ -254,6 +268,21 @@ char *from_env(const char *envvar)
 	return ret;
 }
 
+/* Copy the value of a variable, which is @res bytes long, into @buf */
+static int env_copy_value(const char *name, const char *value, unsigned res,
+			  char *buf, unsigned len)
+{
+	memcpy(buf, value, min(len, res + 1));
+
+	if (len <= res) {
+		buf[len - 1] = '\0';
+		printf("env_buf [%u bytes] too small for value of \"%s\"\n",
+		       len, name);
+	}
+
+	return res;
+}
+
 static int env_get_from_linear(const char *env, const char *name, char *buf,
 			       unsigned len)
 {
@@ -267,7 +296,6 @@ static int env_get_from_linear(const char *env, const char *name, char *buf,
 
 	for (p = env; *p != '\0'; p = end + 1) {
 		const char *value;
-		unsigned res;
 
 		for (end = p; *end != '\0'; ++end)
 			if (end - env >= CONFIG_ENV_SIZE)
@@ -277,19 +305,128 @@ static int env_get_from_linear(const char *env, const char *name, char *buf,
 			continue;
 		value = &p[name_len + 1];
 
-		res = end - value;
-		memcpy(buf, value, min(len, res + 1));
+		return env_copy_value(name, value, end - value, buf, len);
+	}
+
+	return -1;
+}
+
+#if IS_ENABLED(CONFIG_ENV_INDEX_F) && CONFIG_IS_ENABLED(SYS_MALLOC_F)
+static uint env_index_hash(const char *name, size_t len)
+{
+	uint hash = 5381;
+
+	while (len--)
+		hash = hash * 33 + *name++;
+
+	return hash;
+}
+
+/* Find the slot for a variable, which is empty if it is not in the index */
+static u32 *env_index_find(struct env_index *idx, const char *name,
+			   size_t len)
+{
+	uint i = env_index_hash(name, len) & idx->mask;
+	const char *p;
+
+	/* The index is never more than half full, so there is an empty slot */
+	for (;; i = (i + 1) & idx->mask) {
+		if (!idx->slot[i])
+			return &idx->slot[i];
+		p = idx->env + idx->slot[i] - 1;
+		if (!strncmp(name, p, len) && p[len] == '=')
+			return &idx->slot[i];
+	}
+}
+
+static struct env_index *env_index_build(const char *env)
+{
+	struct env_index *idx;
+	const char *p, *end;
+	uint count = 0;
+	size_t size;
+	uint slots;
 
-		if (len <= res) {
-			buf[len - 1] = '\0';
-			printf("env_buf [%u bytes] too small for value of \"%s\"\n",
-			       len, name);
+	for (p = env; *p; p = end + 1) {
+		for (end = p; *end; end++)
+			if (end - env >= CONFIG_ENV_SIZE)
+				return NULL;
+		count++;
+	}
+	slots = __roundup_pow_of_two(max(count * 2, 16U));
+	size = sizeof(*idx) + slots * sizeof(u32);
+
+	/* Fall back to scanning quietly if the early pool is too small */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	    gd->malloc_ptr + size > gd->malloc_limit)
+		return NULL;
+	idx = calloc(1, size);
+	if (!idx)
+		return NULL;
+	idx->env = env;
+	idx->full_malloc = gd->flags & GD_FLG_FULL_MALLOC_INIT;
+	idx->mask = slots - 1;
+
+	/* As with a linear scan, the first of any duplicates is used */
+	for (p = env; *p; p += strlen(p) + 1) {
+		const char *eq = strchr(p, '=');
+		u32 *slot;
+
+		if (!eq || eq == p)
+			continue;
+		slot = env_index_find(idx, p, eq - p);
+		if (!*slot) {
+			*slot = p - env + 1;
+			idx->count++;
 		}
+	}
+
+	return idx;
+}
 
-		return res;
+static int env_get_from_index(const char *env, const char *name, char *buf,
+			      unsigned len)
+{
+	struct env_index *idx = gd_env_index();
+	const char *value;
+	size_t name_len;
+	u32 *slot;
+
+	if (!name || !*name || strchr(name, '='))
+		return env_get_from_linear(env, name, buf, len);
+
+	if (!idx || idx->env != env) {
+		/* Don't keep trying to index an environment which failed */
+		if (gd_env_index_fail() == env)
+			return env_get_from_linear(env, name, buf, len);
+		env_drop_index();
+		idx = env_index_build(env);
+		if (!idx) {
+			gd_set_env_index_fail(env);
+			return env_get_from_linear(env, name, buf, len);
+		}
+		gd_set_env_index(idx);
 	}
 
-	return -1;
+	name_len = strlen(name);
+	slot = env_index_find(idx, name, name_len);
+	if (!*slot)
+		return -1;
+	value = env + *slot + name_len;
+
+	return env_copy_value(name, value, strlen(value), buf, len);
+}
+#endif
+
+void env_drop_index(void)
+{
+	struct env_index *idx = gd_env_index();
+
+	/* Memory from the pre-relocation pool cannot be freed */
+	if (idx && idx->full_malloc && (gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		free(idx);
+	gd_set_env_index(NULL);
+	gd_set_env_index_fail(NULL);
 }
 
 /*
@@ -304,7 +441,11 @@ int env_get_f(const char *name, char *buf, unsigned len)
 	else
 		env = (const char *)gd->env_addr;
 
+#if IS_ENABLED(CONFIG_ENV_INDEX_F) && CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	return env_get_from_index(env, name, buf, len);
+#else
 	return env_get_from_linear(env, name, buf, len);
+#endif
 }
 
 /**
@@ -391,6 +532,7 @@ void env_set_default(const char *s, int flags)
 		return;
 	}
 
+	env_set_loaded(false);
 	gd->flags |= GD_FLG_ENV_READY;
 	gd->flags |= GD_FLG_ENV_DEFAULT;
 }
@@ -430,6 +572,7 @@ int env_import(const char *buf, int check, int flags)
 
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
 			0, NULL)) {
+		env_set_loaded(true);
 		gd->flags |= GD_FLG_ENV_READY;
 		return 0;
 	}
@@ -552,6 +695,9 @@ void env_relocate(void)
 		bootstage_error(BOOTSTAGE_ID_NET_CHECKSUM);
 		env_set_default("bad CRC", 0);
 #endif
+	} else if (env_loaded && (gd->flags & GD_FLG_ENV_READY)) {
+		/* Already imported, e.g. by board code which needed it early */
+		log_debug("Using environment already imported\n");
 	} else {
 		env_load();
 	}
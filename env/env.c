@@ -321,6 +321,8 @@ int env_init(void)
 	int ret = -ENOENT;
 	int prio;
 
+	/* The drivers may set up a new environment at the same address */
+	env_drop_index();
 	for (prio = 0; (drv = env_driver_lookup(ENVOP_INIT, prio)); prio++) {
 		if (!drv->init || !(ret = drv->init()))
 			env_set_inited(drv->location);
@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Environment stored as an append-only journal
+ *
+ * Saving the environment normally rewrites the whole image, which on flash
+ * means erasing at least one sector even if only a single variable changed.
+ * Here the storage is treated as a log: each save appends a small record
+ * holding just the changed variables, and the whole environment is only
+ * rewritten (to the other of two areas) when the log fills up. See
+ * env_journal.h for the layout.
+ */
+
+#include <common.h>
+#include <env_journal.h>
+#include <log.h>
+#include <malloc.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+#define ERASED_WORD	0xffffffff
+
+/* Space taken by a record holding @len bytes of data */
+static ulong rec_size(ulong len)
+{
+	return ALIGN(sizeof(struct env_journal_rec) + len, 4);
+}
+
+static u32 rec_crc(const struct env_journal_rec *rec, const char *data)
+{
+	return crc32(crc32(0, (uchar *)&rec->len, sizeof(rec->len)),
+		     (uchar *)data, rec->len);
+}
+
+static u32 hdr_crc(const struct env_journal_hdr *hdr)
+{
+	return crc32(0, (uchar *)hdr, offsetof(struct env_journal_hdr, crc));
+}
+
+/*
+ * Compare the names of two entries, each ending at '=' or nul. This gives the
+ * same order as the sort in hexport_r()
+ */
+static int env_key_cmp(const char *a, const char *b)
+{
+	int ca, cb;
+
+	for (;; a++, b++) {
+		ca = *a == '=' ? 0 : (uchar)*a;
+		cb = *b == '=' ? 0 : (uchar)*b;
+		if (ca != cb || !ca)
+			return ca - cb;
+	}
+}
+
+/* Get the number of bytes used by the entries in an environment */
+static ulong env_data_len(const char *data)
+{
+	const char *p;
+
+	for (p = data; p < data + ENV_SIZE && *p; p += strlen(p) + 1)
+		;
+
+	return min_t(ulong, p - data, ENV_SIZE - 1);
+}
+
+/*
+ * Apply an entry to a sorted environment of *@lenp bytes, removing any
+ * existing entry with the same name and then inserting the new one if it sets
+ * a value
+ */
+static int env_apply(char *data, ulong *lenp, const char *entry, ulong elen)
+{
+	const char *eq = strchr(entry, '=');
+	char *p, *end = data + *lenp;
+	ulong plen;
+	int cmp;
+
+	for (p = data; p < end; p += plen) {
+		plen = strlen(p) + 1;
+		cmp = env_key_cmp(p, entry);
+		if (cmp > 0)
+			break;
+		if (!cmp) {
+			memmove(p, p + plen, end - p - plen);
+			end -= plen;
+			plen = 0;
+		}
+	}
+	*lenp = end - data;
+	if (!eq || !eq[1])
+		return 0;
+
+	if (*lenp + elen + 1 >= ENV_SIZE)
+		return -ENOSPC;
+	memmove(p + elen + 1, p, end - p);
+	memcpy(p, entry, elen + 1);
+	*lenp += elen + 1;
+
+	return 0;
+}
+
+/* Apply the entries in a record */
+static int env_apply_rec(char *data, ulong *lenp, const char *buf, ulong len)
+{
+	const char *p, *end = buf + len;
+	ulong elen;
+	int ret;
+
+	for (p = buf; p < end; p += elen + 1) {
+		elen = strnlen(p, end - p);
+		if (p + elen == end)
+			return -EINVAL;
+		if (!elen)
+			continue;
+		ret = env_apply(data, lenp, p, elen);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Replay the records in an area, returning -EINVAL if it has no snapshot */
+static int env_journal_replay(struct env_journal *jnl, const char *buf)
+{
+	char *data = (char *)jnl->env->data;
+	ulong ofs = sizeof(struct env_journal_hdr);
+	const struct env_journal_rec *rec;
+	bool first = true;
+	ulong len = 0;
+
+	memset(data, '\0', ENV_SIZE);
+	jnl->compact = false;
+	while (ofs + sizeof(*rec) <= jnl->size) {
+		rec = (struct env_journal_rec *)(buf + ofs);
+		if (rec->magic == ERASED_WORD && rec->len == ERASED_WORD)
+			break;
+		if (rec->magic != ENV_JOURNAL_REC_MAGIC ||
+		    rec->len > jnl->size - ofs - sizeof(*rec) ||
+		    rec_crc(rec, (char *)(rec + 1)) != rec->crc) {
+			/* Probably an interrupted save */
+			log_debug("Bad record at %lx\n", ofs);
+			if (first)
+				return -EINVAL;
+			jnl->compact = true;
+			break;
+		}
+
+		if (first) {
+			if (rec->len >= ENV_SIZE)
+				return -EINVAL;
+			memcpy(data, rec + 1, rec->len);
+			len = rec->len;
+		} else if (env_apply_rec(data, &len, (char *)(rec + 1),
+					 rec->len)) {
+			log_debug("Cannot apply record at %lx\n", ofs);
+			jnl->compact = true;
+			break;
+		}
+		ofs += rec_size(rec->len);
+		first = false;
+	}
+	if (first)
+		return -EINVAL;
+	memset(data + len, '\0', ENV_SIZE - len);
+	jnl->env->crc = crc32(0, jnl->env->data, ENV_SIZE);
+	jnl->used = ofs;
+
+	return 0;
+}
+
+static int env_journal_alloc(struct env_journal *jnl)
+{
+	if (!jnl->env) {
+		jnl->env = calloc(1, sizeof(env_t));
+		if (!jnl->env)
+			return -ENOMEM;
+		jnl->active = -1;
+		jnl->compact = true;
+	}
+
+	return 0;
+}
+
+int env_journal_load(struct env_journal *jnl)
+{
+	struct env_journal_hdr hdr[2];
+	int order[2], i, area;
+	char *buf;
+	int ret;
+
+	ret = env_journal_alloc(jnl);
+	if (ret)
+		return ret;
+	jnl->active = -1;
+	jnl->compact = true;
+
+	for (i = 0; i < 2; i++) {
+		ret = jnl->read(jnl, i * jnl->size, sizeof(hdr[i]), &hdr[i]);
+		if (ret || hdr[i].magic != ENV_JOURNAL_MAGIC ||
+		    hdr_crc(&hdr[i]) != hdr[i].crc)
+			hdr[i].magic = 0;
+	}
+
+	/* Try the newest area first */
+	order[0] = hdr[1].magic &&
+		(!hdr[0].magic || (s32)(hdr[1].seq - hdr[0].seq) > 0);
+	order[1] = !order[0];
+
+	buf = malloc(jnl->size);
+	if (!buf)
+		return -ENOMEM;
+	ret = -ENOENT;
+	for (i = 0; i < 2; i++) {
+		area = order[i];
+		if (!hdr[area].magic)
+			continue;
+		ret = jnl->read(jnl, area * jnl->size, jnl->size, buf);
+		if (ret)
+			continue;
+		ret = env_journal_replay(jnl, buf);
+		if (!ret) {
+			jnl->active = area;
+			jnl->seq = hdr[area].seq;
+			log_debug("Using area %d seq %x, %lx bytes used\n",
+				  area, jnl->seq, jnl->used);
+			break;
+		}
+		ret = -ENOENT;
+	}
+	free(buf);
+
+	return ret;
+}
+
+/*
+ * Build a record with the entries which differ between two sorted
+ * environments, returning the length of the data, or -ENOSPC if it is larger
+ * than @max
+ */
+static long env_journal_diff(const char *old, const char *new, char *out,
+			     ulong max)
+{
+	ulong len = 0, olen, nlen, klen;
+	int cmp;
+
+	while (*old || *new) {
+		olen = strlen(old) + 1;
+		nlen = strlen(new) + 1;
+		if (!*old)
+			cmp = 1;
+		else if (!*new)
+			cmp = -1;
+		else
+			cmp = env_key_cmp(old, new);
+
+		if (cmp < 0) {
+			/* Deleted: write just the name */
+			klen = strchrnul(old, '=') - old;
+			if (len + klen + 1 > max)
+				return -ENOSPC;
+			memcpy(out + len, old, klen);
+			out[len + klen] = '\0';
+			len += klen + 1;
+		} else if (cmp > 0 || strcmp(old, new)) {
+			if (len + nlen > max)
+				return -ENOSPC;
+			memcpy(out + len, new, nlen);
+			len += nlen;
+		}
+		if (cmp <= 0)
+			old += olen;
+		if (cmp >= 0)
+			new += nlen;
+	}
+
+	return len;
+}
+
+/* Write a record, for which @rec is followed by its data */
+static int env_journal_write_rec(struct env_journal *jnl, ulong offset,
+				 struct env_journal_rec *rec, ulong len)
+{
+	ulong size = rec_size(len);
+
+	rec->magic = ENV_JOURNAL_REC_MAGIC;
+	rec->len = len;
+	rec->crc = rec_crc(rec, (char *)(rec + 1));
+	memset((char *)(rec + 1) + len, '\xff', size - sizeof(*rec) - len);
+
+	return jnl->write(jnl, offset, size, rec);
+}
+
+/* Write the whole environment to the inactive area and switch to it */
+static int env_journal_compact(struct env_journal *jnl,
+			       struct env_journal_rec *rec, const env_t *env_new)
+{
+	struct env_journal_hdr hdr;
+	ulong len = env_data_len((char *)env_new->data);
+	int area = jnl->active == 0 ? 1 : 0;
+	ulong base = area * jnl->size;
+	int ret;
+
+	if (sizeof(hdr) + rec_size(len) > jnl->size)
+		return -ENOSPC;
+
+	log_debug("Compacting to area %d\n", area);
+	jnl->compact = true;
+	ret = jnl->erase(jnl, base, jnl->size);
+	if (ret)
+		return ret;
+	memcpy(rec + 1, env_new->data, len);
+	ret = env_journal_write_rec(jnl, base + sizeof(hdr), rec, len);
+	if (ret)
+		return ret;
+
+	/* Once the header is written, this area takes over */
+	hdr.magic = ENV_JOURNAL_MAGIC;
+	hdr.seq = jnl->seq + 1;
+	hdr.crc = hdr_crc(&hdr);
+	ret = jnl->write(jnl, base, sizeof(hdr), &hdr);
+	if (ret)
+		return ret;
+
+	jnl->active = area;
+	jnl->seq = hdr.seq;
+	jnl->used = sizeof(hdr) + rec_size(len);
+	jnl->compact = false;
+	jnl->compactions++;
+
+	return 0;
+}
+
+int env_journal_save(struct env_journal *jnl, const env_t *env_new)
+{
+	struct env_journal_rec *rec;
+	ulong new_len;
+	long len;
+	int ret;
+
+	ret = env_journal_alloc(jnl);
+	if (ret)
+		return ret;
+
+	/* Room for the record header, the data and padding */
+	rec = malloc(rec_size(ENV_SIZE));
+	if (!rec)
+		return -ENOMEM;
+
+	/* A record larger than the whole environment is not worth appending */
+	new_len = env_data_len((char *)env_new->data);
+	len = env_journal_diff((char *)jnl->env->data, (char *)env_new->data,
+			       (char *)(rec + 1), new_len);
+	if (jnl->active != -1 && !jnl->compact && len == 0) {
+		ret = 0;
+	} else if (jnl->active != -1 && !jnl->compact && len > 0 &&
+		   jnl->used + rec_size(len) <= jnl->size) {
+		log_debug("Appending %lx bytes at %lx\n", len, jnl->used);
+		ret = env_journal_write_rec(jnl,
+					    jnl->active * jnl->size + jnl->used,
+					    rec, len);
+		if (ret) {
+			/* The area may now end with a partial record */
+			jnl->compact = true;
+		} else {
+			jnl->used += rec_size(len);
+			jnl->appends++;
+		}
+	} else {
+		ret = env_journal_compact(jnl, rec, env_new);
+	}
+	free(rec);
+	if (ret)
+		return ret;
+
+	memcpy(jnl->env->data, env_new->data, ENV_SIZE);
+	jnl->env->crc = crc32(0, jnl->env->data, ENV_SIZE);
+
+	return 0;
+}
+
+void env_journal_uninit(struct env_journal *jnl)
+{
+	free(jnl->env);
+	jnl->env = NULL;
+}
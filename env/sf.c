@@ -12,6 +12,7 @@
 #include <dm.h>
 #include <env.h>
 #include <env_internal.h>
+#include <env_journal.h>
 #include <malloc.h>
 #include <spi.h>
 #include <spi_flash.h>
@@ -65,7 +66,116 @@ static int setup_flash_device(struct spi_flash **env_flash)
 	return 0;
 }
 
-#if defined(CONFIG_ENV_OFFSET_REDUND)
+#if defined(CONFIG_ENV_SF_JOURNAL)
+static struct env_journal env_jnl;
+
+static int env_sf_jnl_read(struct env_journal *jnl, ulong offset, ulong size,
+			   void *buf)
+{
+	return spi_flash_read(jnl->priv, CONFIG_ENV_OFFSET + offset, size, buf);
+}
+
+static int env_sf_jnl_write(struct env_journal *jnl, ulong offset, ulong size,
+			    const void *buf)
+{
+	return spi_flash_write(jnl->priv, CONFIG_ENV_OFFSET + offset, size,
+			       buf);
+}
+
+static int env_sf_jnl_erase(struct env_journal *jnl, ulong offset, ulong size)
+{
+	return spi_flash_erase(jnl->priv, CONFIG_ENV_OFFSET + offset, size);
+}
+
+static int setup_journal(struct spi_flash **env_flash)
+{
+	int ret;
+
+	ret = setup_flash_device(env_flash);
+	if (ret)
+		return ret;
+
+	env_jnl.read = env_sf_jnl_read;
+	env_jnl.write = env_sf_jnl_write;
+	env_jnl.erase = env_sf_jnl_erase;
+	env_jnl.priv = *env_flash;
+	env_jnl.size = CONFIG_ENV_JOURNAL_SIZE;
+
+	return 0;
+}
+
+static int env_sf_save(void)
+{
+	struct spi_flash *env_flash;
+	env_t	env_new;
+	int	ret;
+
+	ret = setup_journal(&env_flash);
+	if (ret)
+		return ret;
+
+	ret = env_export(&env_new);
+	if (ret) {
+		ret = -EIO;
+		goto done;
+	}
+
+	puts("Writing to SPI flash journal...");
+	ret = env_journal_save(&env_jnl, &env_new);
+	if (ret)
+		goto done;
+
+	puts("done\n");
+
+done:
+	spi_flash_free(env_flash);
+
+	return ret;
+}
+
+static int env_sf_load(void)
+{
+	struct spi_flash *env_flash;
+	int ret;
+
+	ret = setup_journal(&env_flash);
+	if (ret)
+		return ret;
+
+	ret = env_journal_load(&env_jnl);
+	if (ret) {
+		env_set_default(ret == -ENOENT ? "no environment journal" :
+				"journal read failed", 0);
+		goto done;
+	}
+
+	ret = env_import((char *)env_jnl.env, 0, H_EXTERNAL);
+	if (!ret)
+		gd->env_valid = ENV_VALID;
+
+done:
+	spi_flash_free(env_flash);
+
+	return ret;
+}
+
+static int env_sf_erase(void)
+{
+	struct spi_flash *env_flash;
+	int ret;
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
+			      2 * CONFIG_ENV_JOURNAL_SIZE);
+	env_journal_uninit(&env_jnl);
+	spi_flash_free(env_flash);
+
+	return ret;
+}
+#elif defined(CONFIG_ENV_OFFSET_REDUND)
 static int env_sf_save(void)
 {
 	env_t	env_new;
@@ -294,6 +404,7 @@ out:
 }
 #endif
 
+#ifndef CONFIG_ENV_SF_JOURNAL
 static int env_sf_erase(void)
 {
 	int ret;
@@ -317,6 +428,7 @@ done:
 
 	return ret;
 }
+#endif
 
 __weak void *env_sf_get_env_addr(void)
 {
@@ -431,7 +543,13 @@ out:
 
 static int env_sf_init(void)
 {
-	int ret = env_sf_init_addr();
+	int ret;
+
+	/* The journal cannot be read before relocation */
+	if (IS_ENABLED(CONFIG_ENV_SF_JOURNAL))
+		return -ENOENT;
+
+	ret = env_sf_init_addr();
 	if (ret != -ENOENT)
 		return ret;
 #ifdef CONFIG_ENV_SPI_EARLY
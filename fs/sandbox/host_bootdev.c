@@ -21,7 +21,7 @@ static int host_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 	if (iter->part)
 		return log_msg_ret("max", -ESHUTDOWN);
 
-	bflow->name = strdup(dev->name);
+	bflow->name = bootflow_strdup(bflow, dev->name);
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 
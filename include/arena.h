@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Arena allocator for objects which are freed together
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+struct arena_chunk;
+
+/**
+ * struct arena - an arena from which memory can be allocated
+ *
+ * Memory is taken from chunks allocated with malloc(). Allocating is just a
+ * matter of advancing a pointer in the current chunk, and there is no way to
+ * free an individual allocation. Instead, the whole arena is freed at once, or
+ * rolled back to an earlier mark.
+ *
+ * The arena structure itself lives at the start of the first chunk, so an
+ * empty arena uses a single malloc() call.
+ *
+ * @head: Chunk currently being allocated from
+ * @first: First chunk, which holds this structure
+ * @chunk_size: Size of each chunk, in bytes, excluding its header
+ * @count: Number of allocations made (and not rolled back)
+ * @chunks: Number of chunks currently allocated
+ * @mallocs: Total number of calls to malloc() made by the arena
+ */
+struct arena {
+	struct arena_chunk *head;
+	struct arena_chunk *first;
+	size_t chunk_size;
+	uint count;
+	uint chunks;
+	uint mallocs;
+};
+
+/**
+ * struct arena_mark - a position in an arena
+ *
+ * This is used to roll back an arena to an earlier state, e.g. after an error
+ * part-way through building a data structure
+ *
+ * @chunk: Chunk which was being allocated from
+ * @used: Number of bytes used in that chunk
+ * @count: Number of allocations made
+ */
+struct arena_mark {
+	struct arena_chunk *chunk;
+	size_t used;
+	uint count;
+};
+
+/**
+ * arena_new() - Create a new arena
+ *
+ * @chunk_size: Size of each chunk to allocate, in bytes, or 0 to use a default
+ *	size. Allocations larger than this are given their own chunk
+ * Return: new arena, or NULL if out of memory
+ */
+struct arena *arena_new(size_t chunk_size);
+
+/**
+ * arena_alloc() - Allocate memory from an arena
+ *
+ * The memory is aligned in the same way as memory returned by malloc(). It
+ * remains valid until the arena is reset, freed or rolled back to a mark taken
+ * before this call.
+ *
+ * @arena: Arena to allocate from
+ * @size: Number of bytes to allocate
+ * Return: pointer to the memory, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_zalloc() - Allocate zeroed memory from an arena
+ *
+ * @arena: Arena to allocate from
+ * @size: Number of bytes to allocate
+ * Return: pointer to the memory, or NULL if out of memory
+ */
+void *arena_zalloc(struct arena *arena, size_t size);
+
+/**
+ * arena_memdup() - Copy a block of memory into an arena
+ *
+ * @arena: Arena to allocate from
+ * @src: Data to copy
+ * @len: Number of bytes to copy
+ * Return: pointer to the copy, or NULL if out of memory
+ */
+void *arena_memdup(struct arena *arena, const void *src, size_t len);
+
+/**
+ * arena_strdup() - Copy a string into an arena
+ *
+ * @arena: Arena to allocate from
+ * @s: String to copy, or NULL
+ * Return: pointer to the copy, or NULL if @s is NULL or out of memory
+ */
+char *arena_strdup(struct arena *arena, const char *s);
+
+/**
+ * arena_strndup() - Copy part of a string into an arena
+ *
+ * At most @n characters are copied. The copy is always nul-terminated.
+ *
+ * @arena: Arena to allocate from
+ * @s: String to copy, or NULL
+ * @n: Maximum number of characters to copy
+ * Return: pointer to the copy, or NULL if @s is NULL or out of memory
+ */
+char *arena_strndup(struct arena *arena, const char *s, size_t n);
+
+/**
+ * arena_mark() - Record the current position in an arena
+ *
+ * @arena: Arena to check
+ * @mark: Returns the current position
+ */
+void arena_mark(struct arena *arena, struct arena_mark *mark);
+
+/**
+ * arena_rollback() - Discard allocations made since a mark
+ *
+ * Any chunks allocated since the mark was taken are freed. Marks taken after
+ * @mark are no longer valid.
+ *
+ * @arena: Arena to roll back
+ * @mark: Mark previously returned by arena_mark()
+ */
+void arena_rollback(struct arena *arena, const struct arena_mark *mark);
+
+/**
+ * arena_reset() - Discard all allocations in an arena
+ *
+ * The first chunk is kept so that the arena can be reused without further
+ * calls to malloc()
+ *
+ * @arena: Arena to reset
+ */
+void arena_reset(struct arena *arena);
+
+/**
+ * arena_free() - Free an arena and all memory allocated from it
+ *
+ * @arena: Arena to free, or NULL to do nothing
+ */
+void arena_free(struct arena *arena);
+
+#endif
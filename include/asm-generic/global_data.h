@@ -217,6 +217,13 @@ struct global_data {
 	 * @uclass_root_s.
 	 */
 	struct list_head *uclass_root;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	/**
+	 * @uclass_idx: array of UCLASS_COUNT uclass pointers, indexed by
+	 * uclass ID, or NULL if not set up (e.g. before relocation)
+	 */
+	struct uclass **uclass_idx;
+#endif
 # if CONFIG_IS_ENABLED(OF_PLATDATA_DRIVER_RT)
 	/** @dm_driver_rt: Dynamic info about the driver */
 	struct driver_rt *dm_driver_rt;
@@ -278,6 +285,18 @@ struct global_data {
 	 * @env_buf: buffer for env_get() before reloc
 	 */
 	char env_buf[32];
+#ifdef CONFIG_ENV_INDEX_F
+	/**
+	 * @env_index: index of the variables at @env_addr, used by
+	 * env_get_f() before the environment is imported
+	 */
+	struct env_index *env_index;
+	/**
+	 * @env_index_fail: environment for which the index could not be
+	 * built, so that it is not tried again, or NULL if none
+	 */
+	const char *env_index_fail;
+#endif
 #ifdef CONFIG_TRACE
 	/**
 	 * @trace_buff: trace buffer
@@ -385,6 +404,16 @@ struct global_data {
 	 */
 	struct bootstage_data *new_bootstage;
 #endif
+#ifdef CONFIG_EARLY_ARENA
+	/**
+	 * @early_arena: allocations kept across relocation
+	 */
+	struct early_arena_hdr *early_arena;
+	/**
+	 * @new_early_arena: relocated location of @early_arena
+	 */
+	struct early_arena_hdr *new_early_arena;
+#endif
 #ifdef CONFIG_LOG
 	/**
 	 * @log_drop_count: number of dropped log messages
@@ -522,6 +551,26 @@ static_assert(sizeof(struct global_data) == GD_SIZE);
 #define gd_set_of_root(_root)
 #endif
 
+#ifdef CONFIG_ENV_INDEX_F
+#define gd_env_index()			gd->env_index
+#define gd_set_env_index(idx)		gd->env_index = idx
+#define gd_env_index_fail()		gd->env_index_fail
+#define gd_set_env_index_fail(env)	gd->env_index_fail = env
+#else
+#define gd_env_index()			((struct env_index *)NULL)
+#define gd_set_env_index(idx)
+#define gd_env_index_fail()		((const char *)NULL)
+#define gd_set_env_index_fail(env)
+#endif
+
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+#define gd_uclass_idx()			gd->uclass_idx
+#define gd_set_uclass_idx(idx)		gd->uclass_idx = idx
+#else
+#define gd_uclass_idx()			((struct uclass **)NULL)
+#define gd_set_uclass_idx(idx)
+#endif
+
 #if CONFIG_IS_ENABLED(OF_PLATDATA_DRIVER_RT)
 #define gd_set_dm_driver_rt(dyn)	gd->dm_driver_rt = dyn
 #define gd_dm_driver_rt()		gd->dm_driver_rt
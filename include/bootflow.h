@@ -11,6 +11,7 @@
 #include <dm/ofnode_decl.h>
 #include <linux/list.h>
 
+struct arena;
 struct bootstd_priv;
 struct expo;
 
@@ -89,6 +90,8 @@ enum bootflow_flags_t {
  * @cmdline: OS command line, or NULL if not known (allocated)
  * @x86_setup: Pointer to x86 setup block inside @buf, NULL if not present
  * @bootmeth_priv: Private data for the bootmeth
+ * @arena: Arena holding @name, @subdir, @fname, @os_name and @fdt_fname, or
+ *	NULL if none has been allocated yet. See bootflow_strdup()
  */
 struct bootflow {
 	struct list_head bm_node;
@@ -115,6 +118,7 @@ struct bootflow {
 	char *cmdline;
 	void *x86_setup;
 	void *bootmeth_priv;
+	struct arena *arena;
 };
 
 /**
@@ -345,6 +349,31 @@ int bootflow_next_glob(struct bootflow **bflowp);
  */
 void bootflow_free(struct bootflow *bflow);
 
+/**
+ * bootflow_strdup() - Copy a string into memory owned by a bootflow
+ *
+ * The string fields of a bootflow which are set once while it is being read
+ * are allocated from an arena belonging to the bootflow. This is created on
+ * first use and freed, along with all the strings, by bootflow_free()
+ *
+ * @bflow: Bootflow to own the string
+ * @s: String to copy
+ * Return: copy of the string, or NULL if out of memory
+ */
+char *bootflow_strdup(struct bootflow *bflow, const char *s);
+
+/**
+ * bootflow_strndup() - Copy part of a string into memory owned by a bootflow
+ *
+ * This is like bootflow_strdup() but copies at most @n characters
+ *
+ * @bflow: Bootflow to own the string
+ * @s: String to copy
+ * @n: Maximum number of characters to copy
+ * Return: copy of the string, or NULL if out of memory
+ */
+char *bootflow_strndup(struct bootflow *bflow, const char *s, size_t n);
+
 /**
  * bootflow_boot() - boot a bootflow
  *
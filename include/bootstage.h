@@ -219,6 +219,43 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ALLOC,
 };
 
+/**
+ * enum bootstage_event_type - Types of timing event
+ *
+ * These are recorded with CONFIG_BOOTSTAGE_EVENTS
+ *
+ * @BOOTSTAGE_EVENT_INITCALL: Initcall or event in an init sequence
+ * @BOOTSTAGE_EVENT_PROBE: Device probe, including its parents
+ * @BOOTSTAGE_EVENT_PRE_PROBE: Uclass pre_probe() method
+ * @BOOTSTAGE_EVENT_POST_PROBE: Uclass post_probe() method
+ * @BOOTSTAGE_EVENT_BLK_READ: One or more back-to-back block reads
+ * @BOOTSTAGE_EVENT_SPARSE_WRITE: Write, fill or erase for a sparse image
+ * @BOOTSTAGE_EVENT_TYPE_COUNT: Number of event types
+ */
+enum bootstage_event_type {
+	BOOTSTAGE_EVENT_INITCALL,
+	BOOTSTAGE_EVENT_PROBE,
+	BOOTSTAGE_EVENT_PRE_PROBE,
+	BOOTSTAGE_EVENT_POST_PROBE,
+	BOOTSTAGE_EVENT_BLK_READ,
+	BOOTSTAGE_EVENT_SPARSE_WRITE,
+
+	BOOTSTAGE_EVENT_TYPE_COUNT,
+};
+
+/**
+ * enum bootstage_events_fmt - Output formats for timing events
+ *
+ * @BOOTSTAGE_EVENTS_LIST: Human-readable list
+ * @BOOTSTAGE_EVENTS_CHROME: Chrome trace-event JSON
+ * @BOOTSTAGE_EVENTS_FOLDED: Folded stacks, as used by flamegraph.pl
+ */
+enum bootstage_events_fmt {
+	BOOTSTAGE_EVENTS_LIST,
+	BOOTSTAGE_EVENTS_CHROME,
+	BOOTSTAGE_EVENTS_FOLDED,
+};
+
 /*
  * Return the time since boot in microseconds, This is needed for bootstage
  * and should be defined in CPU- or board-specific code. If undefined then
@@ -456,6 +493,66 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS)
+/**
+ * bootstage_event_start() - Get the start time for a timing event
+ *
+ * Return: current time in microseconds, or 0 if bootstage is not set up yet
+ */
+ulong bootstage_event_start(void);
+
+/**
+ * bootstage_event_end() - Record a timing event
+ *
+ * The event covers the time from @start_us until now. Nothing is recorded if
+ * @start_us is 0.
+ *
+ * Block reads are merged into the previous event if that is a block read from
+ * the same device which finished only shortly before.
+ *
+ * @type: Type of event
+ * @name: Name of the event, e.g. the device name (truncated if too long)
+ * @start_us: Start time, as returned by bootstage_event_start()
+ */
+void bootstage_event_end(enum bootstage_event_type type, const char *name,
+			 ulong start_us);
+
+/**
+ * bootstage_events_clear() - Drop all recorded timing events
+ */
+void bootstage_events_clear(void);
+
+/**
+ * bootstage_events_show() - Write out the recorded timing events
+ *
+ * Events are written to the console, oldest first
+ *
+ * @fmt: Format to use
+ * Return: 0 if OK, -ENOENT if bootstage is not set up, -ENOMEM if out of
+ *	memory
+ */
+int bootstage_events_show(enum bootstage_events_fmt fmt);
+#else
+static inline ulong bootstage_event_start(void)
+{
+	return 0;
+}
+
+static inline void bootstage_event_end(enum bootstage_event_type type,
+				       const char *name, ulong start_us)
+{
+}
+
+static inline void bootstage_events_clear(void)
+{
+}
+
+static inline int bootstage_events_show(enum bootstage_events_fmt fmt)
+{
+	return 0;
+}
+#endif
+
 /* helpers for SPL */
 int _bootstage_stash_default(void);
 int _bootstage_unstash_default(void);
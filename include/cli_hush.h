@@ -7,11 +7,42 @@
 #ifndef _CLI_HUSH_H_
 #define _CLI_HUSH_H_
 
+#include <linux/types.h>
+
 #define FLAG_EXIT_FROM_LOOP 1
 #define FLAG_PARSE_SEMICOLON (1 << 1)	  /* symbol ';' is special for parser */
 #define FLAG_REPARSING       (1 << 2)	  /* >=2nd pass */
 #define FLAG_CONT_ON_NEWLINE (1 << 3)	  /* continue when we see \n */
 
+/**
+ * struct hush_cache_stats - Statistics for the cache of parsed commands
+ *
+ * @hits: Number of strings run from the cache
+ * @misses: Number of strings which had to be parsed
+ * @evictions: Number of entries replaced to make room for another
+ */
+struct hush_cache_stats {
+	ulong hits;
+	ulong misses;
+	ulong evictions;
+};
+
+/**
+ * hush_cache_get_stats() - Get statistics for the cache of parsed commands
+ *
+ * This is only available with CONFIG_HUSH_CACHE
+ *
+ * @stats: Returns the statistics
+ */
+void hush_cache_get_stats(struct hush_cache_stats *stats);
+
+/**
+ * hush_cache_flush() - Drop all cached parse trees which are not in use
+ *
+ * This is only available with CONFIG_HUSH_CACHE
+ */
+void hush_cache_flush(void);
+
 #if CONFIG_IS_ENABLED(HUSH_OLD_PARSER)
 extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *str, int flag);
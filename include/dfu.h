@@ -361,6 +361,30 @@ int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
  */
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 
+/**
+ * dfu_set_write_behind() - enable or disable write-behind for dfu_write()
+ *
+ * With CONFIG_DFU_WRITE_BUFFERS greater than one and write-behind enabled,
+ * dfu_write() queues each full buffer instead of writing it to the medium.
+ * The caller must then keep calling dfu_write_pending() to write them. When
+ * no buffer is free, dfu_write() writes the oldest one itself.
+ *
+ * See function :c:func:`dfu_write_pending`
+ *
+ * @enable:	true to queue full buffers, false to write them immediately
+ */
+void dfu_set_write_behind(bool enable);
+
+/**
+ * dfu_write_pending() - write the oldest buffer queued by dfu_write()
+ *
+ * On error the transaction is cleaned up, so the next dfu_write() fails.
+ *
+ * Return:	0 if nothing was queued or the write succeeded, a negative
+ *		error code otherwise
+ */
+int dfu_write_pending(void);
+
 /**
  * dfu_initiated_callback() - weak callback called on DFU transaction start
  *
@@ -192,6 +192,23 @@ int device_of_to_plat(struct udevice *dev);
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_async() - Start probing a device without waiting for it
+ *
+ * This is used for devices whose driver has the DM_FLAG_PROBE_ASYNC flag. The
+ * device is probed as normal, but if the driver's probe() method returns
+ * -EINPROGRESS the device is marked with DM_FLAG_PROBE_PENDING and the probe
+ * is completed in the background by a cyclic function. A later call to
+ * device_probe() waits for the probe to complete.
+ *
+ * Before relocation, or if CONFIG_DM_ASYNC_PROBE is not enabled, this is the
+ * same as device_probe()
+ *
+ * @dev: Pointer to device to probe
+ * Return: 0 if OK (probe complete or still in progress), -ve on error
+ */
+int device_probe_async(struct udevice *dev);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
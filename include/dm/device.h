@@ -87,6 +87,16 @@ struct driver_info;
 /* Device must be probed after it was bound */
 #define DM_FLAG_PROBE_AFTER_BIND	(1 << 15)
 
+/*
+ * Driver probe is slow and can run in the background. The probe() method may
+ * return -EINPROGRESS to indicate that the hardware is still initialising, in
+ * which case it is called again later until it returns 0 or an error
+ */
+#define DM_FLAG_PROBE_ASYNC		(1 << 16)
+
+/* Device probe has been started but is not yet complete */
+#define DM_FLAG_PROBE_PENDING		(1 << 17)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
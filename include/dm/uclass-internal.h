@@ -337,6 +337,31 @@ int uclass_get_count(void);
  */
 struct uclass *uclass_find(enum uclass_id key);
 
+/**
+ * uclass_index_init() - Set up the index of uclasses by ID
+ *
+ * This is called by dm_init(). After relocation it allocates the index, or
+ * clears it if it already exists. Before relocation it does nothing.
+ *
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int uclass_index_init(void);
+
+/**
+ * uclass_index_invalidate() - Drop a uclass's device indexes
+ *
+ * The indexes of devices by sequence number and name are rebuilt when next
+ * needed. This must be called when a device is added to or removed from the
+ * uclass, or renamed.
+ *
+ * @uc: uclass to update
+ */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void uclass_index_invalidate(struct uclass *uc);
+#else
+static inline void uclass_index_invalidate(struct uclass *uc) {}
+#endif
+
 /**
  * uclass_destroy() - Destroy a uclass
  *
@@ -30,12 +30,24 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @seq_idx: Devices indexed by sequence number, or NULL if not built yet
+ *	(do not access outside driver model)
+ * @seq_idx_size: Number of entries in @seq_idx
+ * @name_idx: Hash table of devices by name, or NULL if not built yet (do not
+ *	access outside driver model)
+ * @name_idx_size: Number of entries in @name_idx (a power of two)
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct udevice **seq_idx;
+	int seq_idx_size;
+	struct udevice **name_idx;
+	int name_idx_size;
+#endif
 };
 
 struct driver;
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Allocations made before relocation which are kept afterwards
+ */
+
+#ifndef __EARLY_ARENA_H
+#define __EARLY_ARENA_H
+
+#include <linux/types.h>
+
+/**
+ * enum early_arena_id - IDs for allocations in the early arena
+ *
+ * Each allocation has an ID so that it can be found again after relocation.
+ *
+ * @EARLY_ARENA_NONE: Not used
+ * @EARLY_ARENA_TEST: Used by tests
+ * @EARLY_ARENA_DRAM: DRAM training results
+ * @EARLY_ARENA_CLK: Clock-tree state
+ * @EARLY_ARENA_DT: Information parsed from the devicetree
+ * @EARLY_ARENA_BOARD: Board-specific information
+ * @EARLY_ARENA_ID_COUNT: Number of IDs
+ */
+enum early_arena_id {
+	EARLY_ARENA_NONE,
+	EARLY_ARENA_TEST,
+	EARLY_ARENA_DRAM,
+	EARLY_ARENA_CLK,
+	EARLY_ARENA_DT,
+	EARLY_ARENA_BOARD,
+
+	EARLY_ARENA_ID_COUNT,
+};
+
+/**
+ * early_arena_init() - Set up the early arena in a given region
+ *
+ * This is called automatically by the first early_arena_alloc() before
+ * relocation, using memory from the pre-relocation malloc() pool. It can also
+ * be called to use a different region.
+ *
+ * @base: Start of region
+ * @size: Size of region in bytes
+ * Return: 0 if OK, -ENOSPC if the region is too small
+ */
+int early_arena_init(void *base, int size);
+
+/**
+ * early_arena_alloc() - Allocate memory which is kept after relocation
+ *
+ * The memory is zeroed. It is copied to its final location at relocation, so
+ * callers must use early_arena_find() to find it afterwards. Pointers to the
+ * memory which are stored in global_data or within the arena itself can be
+ * updated automatically using early_arena_add_ptr().
+ *
+ * Only one allocation is permitted for each ID.
+ *
+ * @id: ID of the allocation (enum early_arena_id)
+ * @size: Number of bytes to allocate
+ * Return: pointer to allocated memory, or NULL if there is no space, the ID
+ *	is already in use or the arena has already been relocated
+ */
+void *early_arena_alloc(enum early_arena_id id, int size);
+
+/**
+ * early_arena_find() - Find an allocation in the early arena
+ *
+ * @id: ID of the allocation (enum early_arena_id)
+ * @sizep: Returns the size of the allocation, if not NULL
+ * Return: pointer to the allocation, or NULL if not found
+ */
+void *early_arena_find(enum early_arena_id id, int *sizep);
+
+/**
+ * early_arena_add_ptr() - Update a pointer when the arena is relocated
+ *
+ * The pointer at @ptrp must be within global_data or within the arena. When
+ * the arena is relocated, if the pointer refers to memory in the arena it is
+ * adjusted to refer to the same memory in the relocated arena.
+ *
+ * @ptrp: Pointer to update
+ * Return: 0 if OK, -EINVAL if @ptrp is not in global_data or the arena,
+ *	-ENOSPC if there is no space to record it, -ENOENT if there is no arena
+ */
+int early_arena_add_ptr(void **ptrp);
+
+/**
+ * early_arena_finish() - Finish allocating from the early arena
+ *
+ * This is called when space is reserved for the arena ahead of relocation.
+ * No further allocations are possible after this.
+ *
+ * Return: size of the arena in bytes, or 0 if there is none
+ */
+int early_arena_finish(void);
+
+/**
+ * early_arena_relocate() - Move the early arena to a new location
+ *
+ * This copies the arena, updates any pointers added with early_arena_add_ptr()
+ * and sets gd->early_arena to the new location. The new arena has no space
+ * for further allocations. Pointers in global_data are updated in the current
+ * global_data, so this must be called before global_data is relocated.
+ *
+ * @new_base: Location to move to; must have early_arena_finish() bytes
+ *	available
+ * Return: 0 if OK, -ENOENT if there is no arena
+ */
+int early_arena_relocate(void *new_base);
+
+#endif
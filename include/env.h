@@ -94,7 +94,8 @@ int env_init(void);
  * env_relocate() - Set up the post-relocation environment
  *
  * This loads the environment into RAM so that it can be modified. This is
- * called after relocation, before the environment is used
+ * called after relocation, before the environment is used. If the environment
+ * has already been imported from storage, it is used as is.
  */
 void env_relocate(void);
 
@@ -127,6 +128,9 @@ char *from_env(const char *envvar);
  * loaded yet (GD_FLG_ENV_READY flag is 0). Some environment locations will
  * support reading the value (slowly) and some will not.
  *
+ * With CONFIG_ENV_INDEX_F the first call builds an index of the variables, so
+ * that later calls do not need to scan the whole environment.
+ *
  * @varname:	Variable to look up
  * Return: actual length of the variable value excluding the terminating
  *	NULL-byte, or -1 if the variable is not found
@@ -204,6 +204,36 @@ extern struct hsearch_data env_htab;
  */
 int env_do_env_set(int flag, int argc, char *const argv[], int env_flag);
 
+/**
+ * struct env_index - Index of the variables in a linear environment
+ *
+ * This is used by env_get_f() to find variables without scanning the whole
+ * environment each time. It is an open-addressed hash table keyed by the
+ * variable name.
+ *
+ * @env: Environment which is indexed
+ * @full_malloc: true if allocated from the full malloc() pool, so that it can
+ *	be freed
+ * @count: Number of variables in the index
+ * @mask: Number of slots minus one (the number of slots is a power of two)
+ * @slot: Offset of each variable from @env plus one, or 0 if empty
+ */
+struct env_index {
+	const char *env;
+	bool full_malloc;
+	uint count;
+	uint mask;
+	u32 slot[];
+};
+
+/**
+ * env_drop_index() - Drop the index used by env_get_f()
+ *
+ * The index is rebuilt on the next call to env_get_f(). This must be called if
+ * the environment at gd->env_addr changes without gd->env_addr changing.
+ */
+void env_drop_index(void);
+
 /**
  * env_ext4_get_intf() - Provide the interface for env in EXT4
  *
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Environment stored as an append-only journal
+ */
+
+#ifndef __ENV_JOURNAL_H
+#define __ENV_JOURNAL_H
+
+#include <env_internal.h>
+#include <linux/types.h>
+
+/*
+ * The journal is held in two areas of equal size. Each area starts with a
+ * struct env_journal_hdr, followed by records. The first record in an area is
+ * a snapshot of the whole environment and each later record holds the
+ * variables changed by one save, with deleted variables given by name alone.
+ * When an area fills up, the other area is erased and a new snapshot is
+ * written there. The header is written last, so the older area remains in use
+ * if that is interrupted.
+ */
+#define ENV_JOURNAL_MAGIC	0x4a4e4555	/* "UENJ" */
+#define ENV_JOURNAL_REC_MAGIC	0x43524e45	/* "ENRC" */
+
+/**
+ * struct env_journal_hdr - Header at the start of each journal area
+ *
+ * @magic: ENV_JOURNAL_MAGIC
+ * @seq: Sequence number, incremented each time an area is compacted
+ * @crc: CRC32 of @magic and @seq
+ */
+struct env_journal_hdr {
+	u32 magic;
+	u32 seq;
+	u32 crc;
+};
+
+/**
+ * struct env_journal_rec - Header for each record in the journal
+ *
+ * This is followed by @len bytes of data: a list of nul-terminated entries of
+ * the form "name=value" (to set a variable) or "name" (to delete it). The
+ * record is padded to a multiple of 4 bytes.
+ *
+ * @magic: ENV_JOURNAL_REC_MAGIC
+ * @len: Length of the data
+ * @crc: CRC32 of @len and the data
+ */
+struct env_journal_rec {
+	u32 magic;
+	u32 len;
+	u32 crc;
+};
+
+/**
+ * struct env_journal - Information about a journal
+ *
+ * The caller sets up the operations, @priv and @size, and zeroes the rest.
+ * Offsets passed to the operations are relative to the start of the journal.
+ *
+ * @read: Read from the journal
+ * @write: Write to the journal. This is only used for areas which have been
+ *	erased since they were last written
+ * @erase: Erase part of the journal. This is only used for whole areas
+ * @priv: Private data for the caller
+ * @size: Size of each of the two areas, in bytes
+ * @env: Environment as it is stored in the journal (allocated on first use)
+ * @active: Area holding the latest state (0 or 1), or -1 if none
+ * @seq: Sequence number of the active area
+ * @used: Number of bytes used in the active area
+ * @compact: true if the next save must compact the journal, e.g. because the
+ *	end of the active area is corrupted
+ * @appends: Number of saves which appended a record
+ * @compactions: Number of saves which compacted the journal
+ */
+struct env_journal {
+	int (*read)(struct env_journal *jnl, ulong offset, ulong size,
+		    void *buf);
+	int (*write)(struct env_journal *jnl, ulong offset, ulong size,
+		     const void *buf);
+	int (*erase)(struct env_journal *jnl, ulong offset, ulong size);
+	void *priv;
+	ulong size;
+
+	env_t *env;
+	int active;
+	u32 seq;
+	ulong used;
+	bool compact;
+	uint appends;
+	uint compactions;
+};
+
+/**
+ * env_journal_load() - Read the environment from a journal
+ *
+ * On success, @jnl->env holds the environment, ready for env_import()
+ *
+ * @jnl: Journal to read
+ * Return: 0 if OK, -ENOENT if the journal holds no valid area, -ENOMEM if out
+ *	of memory, other -ve value on read error
+ */
+int env_journal_load(struct env_journal *jnl);
+
+/**
+ * env_journal_save() - Save the environment to a journal
+ *
+ * Only the variables which differ from @jnl->env are written, as a new record
+ * at the end of the active area. If there is not enough space, the other
+ * area is erased and the whole environment written there.
+ *
+ * @jnl: Journal to write
+ * @env_new: Environment to save, as produced by env_export()
+ * Return: 0 if OK, -ENOSPC if the environment does not fit in an area,
+ *	-ENOMEM if out of memory, other -ve value on write error
+ */
+int env_journal_save(struct env_journal *jnl, const env_t *env_new);
+
+/**
+ * env_journal_uninit() - Free memory used by a journal
+ *
+ * @jnl: Journal to free
+ */
+void env_journal_uninit(struct env_journal *jnl);
+
+#endif
@@ -183,7 +183,8 @@ u32 fastboot_data_remaining(void);
  *
  * Copies image data from fastboot_data to fastboot_buf_addr. Writes to
  * response. fastboot_bytes_received is updated to indicate the number
- * of bytes that have been transferred.
+ * of bytes that have been transferred. No copy is made if fastboot_data
+ * already points to the next free position in fastboot_buf_addr.
  */
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
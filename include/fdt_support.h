@@ -425,6 +425,26 @@ int fdt_setup_simplefb_node(void *fdt, int node, u64 base_address, u32 width,
 
 int fdt_overlay_apply_verbose(void *fdt, void *fdto);
 
+/**
+ * fdt_overlay_apply_batch() - Apply a list of overlays to a device tree
+ *
+ * This applies each overlay in turn, with verbose error reporting. The labels
+ * in the base tree are indexed once, along with those added by each overlay,
+ * so that the __fixups__ of each overlay can be resolved without searching
+ * the base tree again. Later overlays may refer to labels defined by earlier
+ * ones. Note that fdt_overlay_apply() still scans the base tree for its
+ * highest phandle for each overlay.
+ *
+ * As with fdt_overlay_apply(), the overlays are destroyed in the process,
+ * and the base tree is left in an undefined state on error.
+ *
+ * @fdt: Device tree to update
+ * @fdtos: List of overlays to apply, in order
+ * @count: Number of overlays in @fdtos
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+int fdt_overlay_apply_batch(void *fdt, void *const fdtos[], int count);
+
 int fdt_valid(struct fdt_header **blobp);
 
 /**
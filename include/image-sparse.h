@@ -26,6 +26,17 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: erase blocks, after which they read back as repeated
+	 * erase_val. This is used for FILL chunks with that value, covering
+	 * whole multiples of erase_align blocks
+	 */
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+	lbaint_t	erase_align;
+	u32		erase_val;
+
 	void		(*mssg)(const char *str, char *response);
 };
 
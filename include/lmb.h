@@ -51,6 +51,11 @@ struct lmb_property {
  *         lmb_region.region is only a pointer to the correct buffer,
  *         initialized in lmb_init(). This configuration is useful to manage
  *         more reserved memory regions with CONFIG_LMB_RESERVED_REGIONS.
+ *
+ * case 3. CONFIG_LMB_DYNAMIC is defined, as case 2 except that the arrays in
+ *         struct lmb only hold the first regions. When one fills up, a larger
+ *         array is allocated with malloc() and lmb_region.alloced is set, so
+ *         there is no fixed limit. Use lmb_uninit() to free the arrays.
  */
 
 /**
@@ -58,7 +63,9 @@ struct lmb_property {
  *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
- * @region: Array of the region properties
+ * @region: Array of the region properties, sorted by base address
+ * @alloced: true if @region was allocated with malloc(), false if it is the
+ *	array in struct lmb
  */
 struct lmb_region {
 	unsigned long cnt;
@@ -67,6 +74,7 @@ struct lmb_region {
 	struct lmb_property region[CONFIG_LMB_MAX_REGIONS];
 #else
 	struct lmb_property *region;
+	bool alloced;
 #endif
 };
 
@@ -93,6 +101,41 @@ struct lmb {
 };
 
 void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_uninit() - Free memory allocated by an lmb
+ *
+ * With CONFIG_LMB_DYNAMIC the region arrays may have been allocated with
+ * malloc(). This frees them. The lmb must be set up again with lmb_init()
+ * before further use. It is safe to call this on a zeroed struct lmb.
+ *
+ * @lmb:	the logical memory block struct
+ */
+void lmb_uninit(struct lmb *lmb);
+
+/**
+ * lmb_get() - Get the global lmb
+ *
+ * This holds the DRAM banks and the regions reserved by the architecture,
+ * board, devicetree and EFI memory map, as set up by lmb_init_and_reserve().
+ * It is set up on first use and kept until the devicetree changes or
+ * lmb_invalidate() is called, so that commands which need to check whether
+ * memory is free do not have to build a new lmb each time.
+ *
+ * Callers which reserve memory in the global lmb must free it when done.
+ *
+ * Return:	the global lmb
+ */
+struct lmb *lmb_get(void);
+
+/**
+ * lmb_invalidate() - Mark the global lmb as out of date
+ *
+ * This is called when the memory map changes. The global lmb is set up again
+ * on the next call to lmb_get().
+ */
+void lmb_invalidate(void);
+
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
@@ -118,6 +161,21 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr);
 
+/**
+ * lmb_is_free() - test if a range could be reserved
+ *
+ * The function checks that @base to @base + @size - 1 lies within one memory
+ * region and does not overlap any reserved region, i.e. that
+ * lmb_alloc_addr() would succeed. Unlike lmb_alloc_addr(), it does not change
+ * the lmb.
+ *
+ * @lmb:	the logical memory block struct
+ * @base:	start of the range
+ * @size:	size of the range, which must not be 0
+ * Return:	true if the range is free, false otherwise
+ */
+bool lmb_is_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
+
 /**
  * lmb_is_reserved() - test if address is in reserved region
  *
@@ -51,6 +51,11 @@ enum log_level_t {
 	LOGL_LEVEL_MASK = 0xf,
 	/** @LOGL_FORCE_DEBUG: Mask to force output due to LOG_DEBUG */
 	LOGL_FORCE_DEBUG = 0x10,
+	/**
+	 * @LOGL_TRANSIENT: Mask to indicate that the file and function
+	 * strings are only valid until the record has been emitted
+	 */
+	LOGL_TRANSIENT = 0x20,
 
 	/** @LOGL_FIRST: The first, most-important log level */
 	LOGL_FIRST = LOGL_EMERG,
@@ -376,6 +381,11 @@ enum log_rec_flags {
 	LOGRECF_FORCE_DEBUG	= BIT(0),
 	/** @LOGRECF_CONT: Continuation of previous log record */
 	LOGRECF_CONT		= BIT(1),
+	/**
+	 * @LOGRECF_TRANSIENT: @file and @func must be copied if they are
+	 * needed after the record has been emitted
+	 */
+	LOGRECF_TRANSIENT	= BIT(2),
 };
 
 /**
@@ -420,6 +430,7 @@ enum log_device_flags {
  *
  * @name: Name of driver
  * @emit: Method to call to emit a log record via this device
+ * @emit_fmt: Method to call to emit an unformatted log record
  * @flags: Initial value for flags (use LOGDF_ENABLE to enable on start-up)
  */
 struct log_driver {
@@ -432,6 +443,17 @@ struct log_driver {
 	 * for processing. The filter is checked before calling this function.
 	 */
 	int (*emit)(struct log_device *ldev, struct log_rec *rec);
+
+	/**
+	 * @emit_fmt: emit a log record without formatting it (optional)
+	 *
+	 * If provided, this is called instead of @emit, with the format
+	 * string and arguments for the message, so that formatting can be
+	 * put off until later. @rec->msg is set if another device has already
+	 * formatted the message, in which case it should be used instead.
+	 */
+	int (*emit_fmt)(struct log_device *ldev, struct log_rec *rec,
+			const char *fmt, va_list args);
 	unsigned short flags;
 };
 
@@ -672,6 +694,44 @@ static inline int log_init(void)
 }
 #endif
 
+/**
+ * log_ring_show() - Show the records held in the log ring buffer
+ *
+ * Each record is formatted as it would be on the console, using the current
+ * log format (see 'log format').
+ *
+ * Return: number of records shown
+ */
+int log_ring_show(void);
+
+/**
+ * log_ring_flush() - Write all pending records in the ring buffer to the console
+ *
+ * With %CONFIG_LOG_RING_DRAIN this writes out the records which have not yet
+ * been drained. Otherwise it does nothing.
+ *
+ * Return: number of records written
+ */
+int log_ring_flush(void);
+
+/**
+ * log_ring_clear() - Remove all records from the log ring buffer
+ */
+void log_ring_clear(void);
+
+/**
+ * log_ring_export() - Write the records in the ring buffer as text
+ *
+ * The records are formatted as for log_ring_show() and written out
+ * one after the other, followed by a nul terminator. If they do not all fit,
+ * the oldest ones are omitted.
+ *
+ * @buf: Buffer for the text
+ * @size: Size of @buf in bytes
+ * Return: number of bytes written, not including the terminator
+ */
+int log_ring_export(char *buf, int size);
+
 /**
  * log_get_default_format() - get default log format
  *
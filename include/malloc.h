@@ -999,6 +999,62 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * malloc_slab_init() - Set up the region used for small allocations
+ *
+ * This takes CONFIG_SYS_MALLOC_SLAB_SIZE bytes from the top of the malloc()
+ * pool, unless the pool is too small
+ *
+ * @start: Start of malloc() pool
+ * @size: Size of malloc() pool in bytes
+ * Return: number of bytes taken from the top of the pool
+ */
+ulong malloc_slab_init(ulong start, ulong size);
+
+/**
+ * malloc_slab_alloc() - Allocate a small object
+ *
+ * @bytes: Number of bytes to allocate
+ * Return: pointer to the object, or NULL if @bytes is too large or there is
+ *	no space, in which case dlmalloc should be used
+ */
+void *malloc_slab_alloc(size_t bytes);
+
+/**
+ * malloc_slab_owns() - Check if memory was allocated by malloc_slab_alloc()
+ *
+ * @ptr: Pointer to check
+ * Return: true if @ptr is in the region used for small allocations
+ */
+bool malloc_slab_owns(const void *ptr);
+
+/**
+ * malloc_slab_free() - Free a small object
+ *
+ * @ptr: Pointer to free
+ * Return: true if freed, false if @ptr was not allocated by
+ *	malloc_slab_alloc(), in which case dlmalloc should be used
+ */
+bool malloc_slab_free(void *ptr);
+
+/**
+ * malloc_slab_usable_size() - Get the number of bytes available in an object
+ *
+ * @ptr: Pointer to an object allocated by malloc_slab_alloc()
+ * Return: size of the object's size class in bytes
+ */
+size_t malloc_slab_usable_size(const void *ptr);
+
+/**
+ * malloc_slab_mallinfo() - Add information about small allocations
+ *
+ * @info: Information to update
+ */
+void malloc_slab_mallinfo(struct mallinfo *info);
+
+/** malloc_slab_stats() - Show statistics for each size class */
+void malloc_slab_stats(void);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
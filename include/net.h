@@ -20,6 +20,7 @@
 #include <log.h>
 #include <time.h>
 #include <linux/if_ether.h>
+#include <linux/list.h>
 #include <rand.h>
 
 struct bd_info;
@@ -112,6 +113,24 @@ typedef void rxhand_icmp_f(unsigned type, unsigned code, unsigned dport,
  */
 typedef void	thand_f(void);
 
+/**
+ * struct net_timer - a timer run by the net_loop() event loop
+ *
+ * Each protocol can own any number of these, so several timeouts (e.g. a
+ * transfer, an ARP request and a DHCP renewal) can be pending at once. A
+ * timer must be zeroed before first use.
+ *
+ * @node: Entry in the list of pending timers, which is sorted by expiry
+ * @expires: Time at which the timer fires, in get_timer() milliseconds
+ * @func: Function to call when the timer fires. The timer is no longer
+ *	pending at that point, so the function may start it again
+ */
+struct net_timer {
+	struct list_head node;
+	ulong expires;
+	void (*func)(struct net_timer *timer);
+};
+
 enum eth_state_t {
 	ETH_STATE_INIT,
 	ETH_STATE_PASSIVE,
@@ -152,10 +171,14 @@ enum eth_recv_flags {
  *	 packet buffer in the packetp parameter. If not, return an error or 0 to
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
  *	 network stack will not process the empty packet, but free_pkt() will be
- *	 called if supplied
+ *	 called if supplied. The packet may be left in the driver's own (e.g.
+ *	 DMA) buffer rather than copied, in which case the network stack
+ *	 consumes it in place and may modify it
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
- *	     called when no error was returned from recv - optional
+ *	     called when no error was returned from recv. A driver which passes
+ *	     its receive buffers up in place should hand the buffer back to the
+ *	     hardware here - optional
  * stop: Stop the hardware from looking for packets - may be called even if
  *	 state == PASSIVE
  * mcast: Join or leave a multicast group (for TFTP) - optional
@@ -616,6 +639,38 @@ bool arp_is_waiting(void);		/* Waiting for ARP reply? */
 void net_set_icmp_handler(rxhand_icmp_f *f); /* Set ICMP RX handler */
 void net_set_timeout_handler(ulong, thand_f *);/* Set timeout handler */
 
+/**
+ * net_timer_start() - Start a timer, or restart it if already pending
+ *
+ * @timer: Timer to start, with @func set
+ * @ms: Time after which @func is called, in milliseconds
+ */
+void net_timer_start(struct net_timer *timer, ulong ms);
+
+/**
+ * net_timer_stop() - Stop a timer so that it does not fire
+ *
+ * This does nothing if the timer is not pending
+ *
+ * @timer: Timer to stop
+ */
+void net_timer_stop(struct net_timer *timer);
+
+/**
+ * net_timer_pending() - Check whether a timer is waiting to fire
+ *
+ * @timer: Timer to check
+ * Return: true if the timer is started and has not yet fired
+ */
+bool net_timer_pending(struct net_timer *timer);
+
+/**
+ * net_timer_run() - Call the functions of all timers which have expired
+ *
+ * This is called by net_loop(), in order of expiry
+ */
+void net_timer_run(void);
+
 /* Network loop state */
 enum net_loop_state {
 	NETLOOP_CONTINUE,
@@ -69,6 +69,7 @@ struct pxe_label {
  *          interrupted.  If 1, always prompt for a choice regardless of
  *          timeout.
  * labels - a list of labels defined for the menu.
+ * arena - arena holding this menu, its labels and all their strings
  */
 struct pxe_menu {
 	char *title;
@@ -77,6 +78,7 @@ struct pxe_menu {
 	int timeout;
 	int prompt;
 	struct list_head labels;
+	struct arena *arena;
 };
 
 struct pxe_context;
@@ -42,11 +42,26 @@ struct env_entry {
  * functions all work on a single internal hash table.
  */
 
-/* Data type for reentrant functions.  */
+/**
+ * struct hsearch_data - Data type for reentrant functions
+ *
+ * See lib/hashtable.c for how the table is organised.
+ *
+ * @table: Entries, in the order in which they were created
+ * @index: Hash index, holding the position of an entry in @table, or 0
+ * @size: Number of entries which @table can hold before it must be resized
+ * @filled: Number of entries in use
+ * @used: Number of positions in @table used, including deleted entries
+ * @mask: Number of slots in @index, minus 1
+ * @change_ok: See below
+ */
 struct hsearch_data {
 	struct env_entry_node *table;
+	unsigned int *index;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int used;
+	unsigned int mask;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -58,7 +73,10 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/*
+ * Create a new hash table with room for "nel" elements to start with. It
+ * grows as needed when more are added.
+ */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
@@ -68,7 +86,8 @@ void hdestroy_r(struct hsearch_data *htab);
  * Search for entry matching item.key in internal hash table.  If
  * action is `ENV_FIND' return found entry or signal error by returning
  * NULL.  If action is `ENV_ENTER' replace existing data (if any) with
- * item.data.
+ * item.data. Adding an entry may resize the table, so the entry returned
+ * is only valid until another one is added.
  * */
 int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag);
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Arena allocator for objects which are freed together
+ *
+ * Parsers and boot flows build up many small strings and structures which all
+ * have the same lifetime. Allocating each one with malloc() costs a chunk
+ * header and a call into dlmalloc, and freeing them means walking the whole
+ * structure, which is easy to get wrong on error paths. An arena takes larger
+ * chunks from malloc() and hands out pieces of them, then frees everything in
+ * one go.
+ */
+
+#include <arena.h>
+#include <malloc.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+enum {
+	ARENA_ALIGN		= 2 * sizeof(void *),
+	ARENA_DEFAULT_CHUNK	= 0x1000,
+	ARENA_MIN_CHUNK		= 0x100,
+};
+
+/**
+ * struct arena_chunk - a block of memory allocated with malloc()
+ *
+ * The data follows the header, at an offset of ARENA_HDR_SIZE
+ *
+ * @prev: Previously allocated chunk, or NULL if this is the first
+ * @size: Number of bytes available for data
+ * @used: Number of bytes used
+ */
+struct arena_chunk {
+	struct arena_chunk *prev;
+	size_t size;
+	size_t used;
+};
+
+#define ARENA_HDR_SIZE	ALIGN(sizeof(struct arena_chunk), ARENA_ALIGN)
+
+/* Space used in the first chunk by the arena itself */
+#define ARENA_SELF_SIZE	ALIGN(sizeof(struct arena), ARENA_ALIGN)
+
+static char *chunk_data(struct arena_chunk *chunk)
+{
+	return (char *)chunk + ARENA_HDR_SIZE;
+}
+
+static struct arena_chunk *chunk_new(size_t size)
+{
+	struct arena_chunk *chunk;
+
+	chunk = malloc(ARENA_HDR_SIZE + size);
+	if (!chunk)
+		return NULL;
+	chunk->prev = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+struct arena *arena_new(size_t chunk_size)
+{
+	struct arena_chunk *chunk;
+	struct arena *arena;
+
+	if (!chunk_size)
+		chunk_size = ARENA_DEFAULT_CHUNK;
+	chunk_size = max_t(size_t, chunk_size, ARENA_MIN_CHUNK);
+	chunk = chunk_new(chunk_size);
+	if (!chunk)
+		return NULL;
+
+	arena = (struct arena *)chunk_data(chunk);
+	memset(arena, '\0', sizeof(*arena));
+	chunk->used = ARENA_SELF_SIZE;
+	arena->head = chunk;
+	arena->first = chunk;
+	arena->chunk_size = chunk_size;
+	arena->chunks = 1;
+	arena->mallocs = 1;
+
+	return arena;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk = arena->head;
+	void *ptr;
+
+	size = ALIGN(size, ARENA_ALIGN);
+	if (size > chunk->size - chunk->used) {
+		chunk = chunk_new(max(size, arena->chunk_size));
+		if (!chunk)
+			return NULL;
+		chunk->prev = arena->head;
+		arena->head = chunk;
+		arena->chunks++;
+		arena->mallocs++;
+	}
+	ptr = chunk_data(chunk) + chunk->used;
+	chunk->used += size;
+	arena->count++;
+
+	return ptr;
+}
+
+void *arena_zalloc(struct arena *arena, size_t size)
+{
+	void *ptr;
+
+	ptr = arena_alloc(arena, size);
+	if (ptr)
+		memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+void *arena_memdup(struct arena *arena, const void *src, size_t len)
+{
+	void *ptr;
+
+	ptr = arena_alloc(arena, len);
+	if (ptr)
+		memcpy(ptr, src, len);
+
+	return ptr;
+}
+
+char *arena_strdup(struct arena *arena, const char *s)
+{
+	if (!s)
+		return NULL;
+
+	return arena_memdup(arena, s, strlen(s) + 1);
+}
+
+char *arena_strndup(struct arena *arena, const char *s, size_t n)
+{
+	size_t len;
+	char *ptr;
+
+	if (!s)
+		return NULL;
+	len = strnlen(s, n);
+	ptr = arena_alloc(arena, len + 1);
+	if (ptr) {
+		memcpy(ptr, s, len);
+		ptr[len] = '\0';
+	}
+
+	return ptr;
+}
+
+void arena_mark(struct arena *arena, struct arena_mark *mark)
+{
+	mark->chunk = arena->head;
+	mark->used = arena->head->used;
+	mark->count = arena->count;
+}
+
+void arena_rollback(struct arena *arena, const struct arena_mark *mark)
+{
+	struct arena_chunk *chunk;
+
+	while (arena->head != mark->chunk) {
+		chunk = arena->head;
+		arena->head = chunk->prev;
+		arena->chunks--;
+		free(chunk);
+	}
+	arena->head->used = mark->used;
+	arena->count = mark->count;
+}
+
+void arena_reset(struct arena *arena)
+{
+	struct arena_mark mark = {
+		.chunk	= arena->first,
+		.used	= ARENA_SELF_SIZE,
+		.count	= 0,
+	};
+
+	arena_rollback(arena, &mark);
+}
+
+void arena_free(struct arena *arena)
+{
+	if (!arena)
+		return;
+	arena_reset(arena);
+	free(arena->first);
+}
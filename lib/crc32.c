@@ -15,6 +15,9 @@
 #endif
 #include <compiler.h>
 #include <u-boot/crc.h>
+#ifdef CONFIG_ARM64_CRC32
+#include <asm/crc32.h>
+#endif
 
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
 #include <watchdog.h>
@@ -183,10 +186,7 @@ const uint32_t * ZEXPORT get_crc_table()
 uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
 #ifdef CONFIG_ARM64_CRC32
-    crc = cpu_to_le32(crc);
-    while (len--)
-        crc = __builtin_aarch64_crc32b(crc, *buf++);
-    return le32_to_cpu(crc);
+    return crc32_le_arm64(crc, buf, len);
 #else
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -11,10 +11,24 @@
  */
 
 #include <compiler.h>
+#ifdef CONFIG_ARM64_CRC32
+#include <asm/crc32.h>
+#endif
+
+/* Bit-reflected CRC32C polynomial */
+#define CRC32C_POLY_LE	0x82f63b78
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+#ifdef CONFIG_ARM64_CRC32
+	/*
+	 * The table entry for 0x80 is the polynomial, so the CRC32C
+	 * instructions can be used if the table is for CRC32C
+	 */
+	if (crc32c_table[0x80] == CRC32C_POLY_LE)
+		return crc32c_le_arm64(crc, (const u8 *)data, length);
+#endif
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
@@ -9,6 +9,7 @@
 
 #include <efi_loader.h>
 #include <init.h>
+#include <lmb.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -364,6 +365,10 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	/* And make sure memory is listed in descending order */
 	efi_mem_sort();
 
+	/* The global lmb must be rebuilt to pick up the change */
+	if (IS_ENABLED(CONFIG_LMB))
+		lmb_invalidate();
+
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
 		if (evt->group &&
@@ -34,16 +34,12 @@
 # include <linux/ctype.h>
 #endif
 
-#define USED_FREE 0
-#define USED_DELETED -1
-
 #include <env_callback.h>
 #include <env_flags.h>
 #include <search.h>
 #include <slre.h>
 
 /*
- * [Aho,Sethi,Ullman] Compilers: Principles, Techniques and Tools, 1986
  * [Knuth]	      The Art of Computer Programming, part 3 (6.4)
  */
 
@@ -51,46 +47,172 @@
  * The reentrant version has no static variables to maintain the state.
  * Instead the interface of all functions is extended to take an argument
  * which describes the current status.
+ *
+ * Entries are held in htab->table in the order in which they were created,
+ * so that walking the table only visits entries which are, or were, in use.
+ * Positions start at 1, leaving 0 to mean 'not found'. Deleting an entry
+ * leaves a hole (with a NULL key) which is squeezed out when the table is
+ * next resized.
+ *
+ * Lookups go through htab->index, a power-of-two array of slots each holding
+ * the position of an entry, or 0 if empty. This uses linear probing and is
+ * kept at most half full, so a lookup normally needs one or two probes of a
+ * small array. Deleting an entry moves later slots back rather than leaving
+ * a tombstone, so probe sequences do not get longer as entries come and go.
  */
 
 struct env_entry_node {
-	int used;
+	unsigned int hash;
 	struct env_entry entry;
 };
 
+/* Smallest table created, to avoid resizing for the first few entries */
+#define HTAB_MIN_SIZE	8
 
 static void _hdelete(const char *key, struct hsearch_data *htab,
 		     struct env_entry *ep, int idx);
 
+static unsigned int hhash(const char *key)
+{
+	unsigned int hval = 5381;
+
+	while (*key)
+		hval = hval * 33 + (unsigned char)*key++;
+
+	return hval;
+}
+
+/* Get the number of index slots to use for a table of @size entries */
+static unsigned int hindex_slots(unsigned int size)
+{
+	unsigned int slots = 16;
+
+	while (slots < size * 2)
+		slots <<= 1;
+
+	return slots;
+}
+
+/* Add the entry at position @idx to the index */
+static void hindex_add(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int slot = htab->table[idx].hash & htab->mask;
+
+	while (htab->index[slot])
+		slot = (slot + 1) & htab->mask;
+	htab->index[slot] = idx;
+}
+
+/* Remove the entry at position @idx from the index */
+static void hindex_remove(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int mask = htab->mask;
+	unsigned int slot, next, home;
+
+	for (slot = htab->table[idx].hash & mask; htab->index[slot] != idx;
+	     slot = (slot + 1) & mask)
+		;
+
+	/* Move back any later entries which could not be found otherwise */
+	for (next = (slot + 1) & mask; htab->index[next];
+	     next = (next + 1) & mask) {
+		home = htab->table[htab->index[next]].hash & mask;
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			htab->index[slot] = htab->index[next];
+			slot = next;
+		}
+	}
+	htab->index[slot] = 0;
+}
+
+/* Find the position of an entry, or return 0 if it is not present */
+static unsigned int hfind(struct hsearch_data *htab, const char *key,
+			  unsigned int hval)
+{
+	unsigned int slot, idx;
+
+	if (!htab->index)
+		return 0;
+
+	for (slot = hval & htab->mask; (idx = htab->index[slot]);
+	     slot = (slot + 1) & htab->mask) {
+		if (htab->table[idx].hash == hval &&
+		    !strcmp(key, htab->table[idx].entry.key))
+			return idx;
+	}
+
+	return 0;
+}
+
 /*
- * hcreate()
+ * Get the position of the entry with the given (stored) key, which was at
+ * @idx. It may have moved if a callback added variables, so causing a resize.
  */
+static unsigned int hrefind(struct hsearch_data *htab, unsigned int idx,
+			    const char *key)
+{
+	if (idx <= htab->used && htab->table[idx].entry.key == key)
+		return idx;
+
+	return hfind(htab, key, hhash(key));
+}
 
 /*
- * For the used double hash method the table size has to be a prime. To
- * correct the user given table size we need a prime test.  This trivial
- * algorithm is adequate because
- * a)  the code is (most probably) called a few times per program run and
- * b)  the number is small because the table must fit in the core
- * */
-static int isprime(unsigned int number)
+ * Make room for a new entry. Holes left by deleted entries are squeezed out
+ * and the table doubles in size, unless that frees up at least a quarter of
+ * it. The index is rebuilt from the stored hash values, so no keys need to be
+ * hashed or compared. Entries are renumbered, so earlier positions and entry
+ * pointers are no longer valid.
+ */
+static int hresize(struct hsearch_data *htab)
 {
-	/* no even number will be passed */
-	unsigned int div = 3;
+	struct env_entry_node *table = htab->table;
+	unsigned int size = htab->size;
+	unsigned int *index;
+	unsigned int i, used;
+
+	if (!size)
+		size = HTAB_MIN_SIZE;
+	else if (htab->used - htab->filled < size / 4)
+		size *= 2;
+	index = calloc(hindex_slots(size), sizeof(*index));
+	if (!index)
+		return -ENOMEM;
+	if (size != htab->size) {
+		table = realloc(table, (size + 1) * sizeof(*table));
+		if (!table) {
+			free(index);
+			return -ENOMEM;
+		}
+	}
+	debug("hresize: size %u, %u/%u used -> size %u\n", htab->size,
+	      htab->filled, htab->used, size);
 
-	while (div * div < number && number % div != 0)
-		div += 2;
+	for (i = 1, used = 0; i <= htab->used; i++) {
+		if (table[i].entry.key)
+			table[++used] = table[i];
+	}
+	free(htab->index);
+	htab->table = table;
+	htab->index = index;
+	htab->size = size;
+	htab->used = used;
+	htab->mask = hindex_slots(size) - 1;
+	for (i = 1; i <= used; i++)
+		hindex_add(htab, i);
 
-	return number % div != 0;
+	return 0;
 }
 
+/*
+ * hcreate()
+ */
+
 /*
  * Before using the hash table we must allocate memory for it.
- * Test for an existing table are done. We allocate one element
- * more as the found prime number says. This is done for more effective
- * indexing as explained in the comment for the hsearch function.
- * The contents of the table is zeroed, especially the field used
- * becomes zero.
+ * Test for an existing table are done. The table is sized for "nel"
+ * entries to start with and grows when it fills up. We allocate one
+ * element more, since position zero is not used.
  */
 
 int hcreate_r(size_t nel, struct hsearch_data *htab)
@@ -107,18 +229,22 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 		return 0;
 	}
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
+	if (nel < HTAB_MIN_SIZE)
+		nel = HTAB_MIN_SIZE;
 
 	htab->size = nel;
 	htab->filled = 0;
+	htab->used = 0;
+	htab->mask = hindex_slots(nel) - 1;
 
 	/* allocate memory and zero out */
-	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
-						sizeof(struct env_entry_node));
-	if (htab->table == NULL) {
+	htab->table = calloc(htab->size + 1, sizeof(struct env_entry_node));
+	htab->index = calloc(htab->mask + 1, sizeof(*htab->index));
+	if (!htab->table || !htab->index) {
+		free(htab->table);
+		free(htab->index);
+		htab->table = NULL;
+		htab->index = NULL;
 		__set_errno(ENOMEM);
 		return 0;
 	}
@@ -148,18 +274,23 @@ void hdestroy_r(struct hsearch_data *htab)
 	}
 
 	/* free used memory */
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
+	for (i = 1; i <= htab->used; ++i) {
+		struct env_entry *ep = &htab->table[i].entry;
 
+		if (ep->key) {
 			free((void *)ep->key);
 			free(ep->data);
 		}
 	}
 	free(htab->table);
+	free(htab->index);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->index = NULL;
+	htab->size = 0;
+	htab->filled = 0;
+	htab->used = 0;
 }
 
 /*
@@ -167,19 +298,9 @@ void hdestroy_r(struct hsearch_data *htab)
  */
 
 /*
- * This is the search function. It uses double hashing with open addressing.
- * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
- *
- * We use an trick to speed up the lookup. The table is created by hcreate
- * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * This is the search function. The key is hashed (using the djb2 method)
+ * and looked up in the index, with the stored hash of each candidate used
+ * as a fast first comparison, to avoid unnecessary calls to strcmp().
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -193,10 +314,11 @@ void hdestroy_r(struct hsearch_data *htab)
  * - The standard implementation does not provide a way to update an
  *   existing entry.  This version will create a new entry or update an
  *   existing one when both "action == ENV_ENTER" and "item.data != NULL".
- * - Instead of returning 1 on success, we return the index into the
- *   internal hash table, which is also guaranteed to be positive.
- *   This allows us direct access to the found hash table slot for
+ * - Instead of returning 1 on success, we return the position of an
+ *   existing entry in the internal table, which is also guaranteed to be
+ *   positive. This allows us direct access to the found entry, for
  *   example for functions like hdelete().
+ * - The table is never full: it grows as entries are added.
  */
 
 int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
@@ -205,8 +327,8 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
-		if (htab->table[idx].used <= 0)
+	for (idx = last_idx + 1; idx <= htab->used; ++idx) {
+		if (!htab->table[idx].entry.key)
 			continue;
 		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
 			*retval = &htab->table[idx].entry;
@@ -231,201 +353,149 @@ do_callback(const struct env_entry *e, const char *name, const char *value,
 }
 
 /*
- * Compare an existing entry with the desired key, and overwrite if the action
- * is ENV_ENTER.  This is simply a helper function for hsearch_r().
+ * Overwrite the value of the existing entry at @idx.  This is simply a
+ * helper function for hsearch_r().
  */
-static inline int _compare_and_overwrite_entry(struct env_entry item,
-		enum env_action action, struct env_entry **retval,
-		struct hsearch_data *htab, int flag, unsigned int hval,
-		unsigned int idx)
+static int _overwrite_entry(struct env_entry item, struct env_entry **retval,
+			    struct hsearch_data *htab, int flag,
+			    unsigned int idx)
 {
-	if (htab->table[idx].used == hval
-	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-		/* Overwrite existing value? */
-		if (action == ENV_ENTER && item.data) {
-			/* check for permission */
-			if (htab->change_ok != NULL && htab->change_ok(
-			    &htab->table[idx].entry, item.data,
-			    env_op_overwrite, flag)) {
-				debug("change_ok() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EPERM);
-				*retval = NULL;
-				return 0;
-			}
+	const char *key = htab->table[idx].entry.key;
 
-			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
-					item.data, env_op_overwrite, flag)) {
-				debug("callback() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EINVAL);
-				*retval = NULL;
-				return 0;
-			}
+	/* check for permission */
+	if (htab->change_ok != NULL && htab->change_ok(
+	    &htab->table[idx].entry, item.data, env_op_overwrite, flag)) {
+		debug("change_ok() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		__set_errno(EPERM);
+		*retval = NULL;
+		return 0;
+	}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
-				__set_errno(ENOMEM);
-				*retval = NULL;
-				return 0;
-			}
-		}
-		/* return found entry */
-		*retval = &htab->table[idx].entry;
-		return idx;
+	/* If there is a callback, call it */
+	if (do_callback(&htab->table[idx].entry, item.key, item.data,
+			env_op_overwrite, flag)) {
+		debug("callback() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		__set_errno(EINVAL);
+		*retval = NULL;
+		return 0;
+	}
+
+	idx = hrefind(htab, idx, key);
+	if (!idx) {
+		__set_errno(ESRCH);
+		*retval = NULL;
+		return 0;
 	}
-	/* keep searching */
-	return -1;
+
+	free(htab->table[idx].entry.data);
+	htab->table[idx].entry.data = strdup(item.data);
+	if (!htab->table[idx].entry.data) {
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
+
+	/* return found entry */
+	*retval = &htab->table[idx].entry;
+	return idx;
 }
 
 int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
+	unsigned int hval = hhash(item.key);
+	struct env_entry_node *node;
+	const char *key;
 	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
-
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
-
-	/* The first index tried. */
-	idx = hval;
 
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
-
-		if (htab->table[idx].used == USED_DELETED)
-			first_deleted = idx;
-
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
-		if (ret != -1)
-			return ret;
+	idx = hfind(htab, item.key, hval);
+	if (idx) {
+		/* Overwrite existing value? */
+		if (action == ENV_ENTER && item.data)
+			return _overwrite_entry(item, retval, htab, flag, idx);
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			if (htab->table[idx].used == USED_DELETED
-			    && !first_deleted)
-				first_deleted = idx;
-
-			/* If entry is found use it. */
-			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
-			if (ret != -1)
-				return ret;
-		}
-		while (htab->table[idx].used != USED_FREE);
+		/* return found entry */
+		*retval = &htab->table[idx].entry;
+		return idx;
 	}
 
-	/* An empty bucket has been found. */
-	if (action == ENV_ENTER) {
-		/*
-		 * If table is full and another entry should be
-		 * entered return with error.
-		 */
-		if (htab->filled == htab->size) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
-		}
-
-		/*
-		 * Create new entry;
-		 * create copies of item.key and item.data
-		 */
-		if (first_deleted)
-			idx = first_deleted;
-
-		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
-		if (!htab->table[idx].entry.key ||
-		    !htab->table[idx].entry.data) {
-			__set_errno(ENOMEM);
-			*retval = NULL;
-			return 0;
-		}
+	if (action != ENV_ENTER) {
+		__set_errno(ESRCH);
+		*retval = NULL;
+		return 0;
+	}
 
-		++htab->filled;
+	/* Grow the table (or squeeze out deleted entries) if it is full */
+	if (htab->used == htab->size && hresize(htab)) {
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
 
-		/* This is a new entry, so look up a possible callback */
-		env_callback_init(&htab->table[idx].entry);
-		/* Also look for flags */
-		env_flags_init(&htab->table[idx].entry);
+	/*
+	 * Create new entry;
+	 * create copies of item.key and item.data
+	 */
+	idx = htab->used + 1;
+	node = &htab->table[idx];
+	memset(node, '\0', sizeof(*node));
+	node->hash = hval;
+	node->entry.key = strdup(item.key);
+	node->entry.data = strdup(item.data);
+	if (!node->entry.key || !node->entry.data) {
+		free((void *)node->entry.key);
+		free(node->entry.data);
+		node->entry.key = NULL;
+		__set_errno(ENOMEM);
+		*retval = NULL;
+		return 0;
+	}
 
-		/* check for permission */
-		if (htab->change_ok != NULL && htab->change_ok(
-		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
-			debug("change_ok() rejected setting variable "
-				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
-			__set_errno(EPERM);
-			*retval = NULL;
-			return 0;
-		}
+	htab->used = idx;
+	hindex_add(htab, idx);
+	++htab->filled;
+
+	/* This is a new entry, so look up a possible callback */
+	env_callback_init(&node->entry);
+	/* Also look for flags */
+	env_flags_init(&node->entry);
+
+	/* check for permission */
+	key = node->entry.key;
+	if (htab->change_ok != NULL && htab->change_ok(
+	    &node->entry, item.data, env_op_create, flag)) {
+		debug("change_ok() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		_hdelete(item.key, htab, &node->entry, idx);
+		__set_errno(EPERM);
+		*retval = NULL;
+		return 0;
+	}
 
-		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
-			debug("callback() rejected setting variable "
-				"%s, skipping it!\n", item.key);
+	/* If there is a callback, call it */
+	if (do_callback(&node->entry, item.key, item.data,
+			env_op_create, flag)) {
+		debug("callback() rejected setting variable "
+			"%s, skipping it!\n", item.key);
+		idx = hrefind(htab, idx, key);
+		if (idx)
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
-			__set_errno(EINVAL);
-			*retval = NULL;
-			return 0;
-		}
-
-		/* return new entry */
-		*retval = &htab->table[idx].entry;
-		return 1;
+		__set_errno(EINVAL);
+		*retval = NULL;
+		return 0;
 	}
 
-	__set_errno(ESRCH);
-	*retval = NULL;
-	return 0;
+	/* return new entry */
+	idx = hrefind(htab, idx, key);
+	if (!idx) {
+		__set_errno(ESRCH);
+		*retval = NULL;
+		return 0;
+	}
+	*retval = &htab->table[idx].entry;
+	return 1;
 }
 
 
@@ -444,17 +514,24 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
+	hindex_remove(htab, idx);
 	free((void *)ep->key);
 	free(ep->data);
+	ep->key = NULL;
+	ep->data = NULL;
 	ep->flags = 0;
-	htab->table[idx].used = USED_DELETED;
 
 	--htab->filled;
+
+	/* Give back any holes at the end of the table straight away */
+	while (htab->used && !htab->table[htab->used].entry.key)
+		--htab->used;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 {
 	struct env_entry e, *ep;
+	const char *name;
 	int idx;
 
 	debug("hdelete: DELETE key \"%s\"\n", key);
@@ -477,6 +554,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
+	name = ep->key;
 	if (do_callback(&htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
@@ -485,7 +563,12 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 		return -EINVAL;
 	}
 
-	_hdelete(key, htab, ep, idx);
+	idx = hrefind(htab, idx, name);
+	if (!idx) {
+		__set_errno(ESRCH);
+		return -ENOENT;
+	}
+	_hdelete(key, htab, &htab->table[idx].entry, idx);
 
 	return 0;
 }
@@ -508,7 +591,8 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
  * for later re-import.
  *
  * The entries in the result list will be sorted by ascending key
- * values.
+ * values. They are collected by walking the table in creation order,
+ * which visits only entries in use, so no empty slots are scanned.
  *
  * If the separator character is different from NUL, then any
  * separator characters and backslash characters in the values will
@@ -603,7 +687,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char *const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry *list[htab->filled + 1];
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -621,9 +705,9 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	 * search used entries,
 	 * save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	for (i = 1, n = 0, totlen = 0; i <= htab->used; ++i) {
 
-		if (htab->table[i].used > 0) {
+		if (htab->table[i].entry.key) {
 			struct env_entry *ep = &htab->table[i].entry;
 			int found = match_entry(ep, flag, argc, argv);
 
@@ -844,7 +928,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. Since the
+	 * table grows as needed, this only sets its initial size.
 	 */
 
 	if (!htab->table) {
@@ -989,14 +1074,15 @@ end:
 /*
  * Walk all of the entries in the hash, calling the callback for each one.
  * this allows some generic operation to be performed on each element.
+ * Entries are visited in the order in which they were created.
  */
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
 	int i;
 	int retval;
 
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
+	for (i = 1; i <= htab->used; ++i) {
+		if (htab->table[i].entry.key) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
 				return retval;
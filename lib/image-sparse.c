@@ -36,12 +36,14 @@
 
 #include <config.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <image-sparse.h>
 #include <div64.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
 #include <sparse_format.h>
+#include <time.h>
 #include <asm/cache.h>
 
 #include <linux/math64.h>
@@ -49,83 +51,251 @@
 
 static void default_log(const char *ignored, char *response) {}
 
-static lbaint_t write_sparse_chunk_raw(struct sparse_storage *info,
-				       lbaint_t blk, lbaint_t blkcnt,
-				       void *data,
-				       char *response)
+/**
+ * struct sparse_write - state for writing a sparse image
+ *
+ * Consecutive raw chunks are gathered in @raw_buf, so that they go to the
+ * device in large writes rather than one or more writes per chunk.
+ *
+ * @info: Storage being written
+ * @response: Pointer to fastboot response buffer
+ * @raw_buf: Aligned buffer for raw data, or NULL if not allocated
+ * @raw_max: Size of @raw_buf in blocks
+ * @raw_blk: First block of the data held in @raw_buf
+ * @raw_cnt: Number of blocks held in @raw_buf
+ * @fill_buf: Buffer of fill values, or NULL if not allocated
+ * @fill_val: Value which @fill_buf currently holds
+ * @fill_num_blks: Size of @fill_buf in blocks
+ */
+struct sparse_write {
+	struct sparse_storage *info;
+	char *response;
+	void *raw_buf;
+	lbaint_t raw_max;
+	lbaint_t raw_blk;
+	lbaint_t raw_cnt;
+	uint32_t *fill_buf;
+	uint32_t fill_val;
+	lbaint_t fill_num_blks;
+};
+
+static lbaint_t write_fail(struct sparse_write *sw, lbaint_t blk,
+			   lbaint_t n, lbaint_t write_blks)
+{
+	if (IS_ERR_VALUE(write_blks)) {
+		printf("%s: Write failed, block #" LBAFU " [" LBAFU "] (%lld)\n",
+		       __func__, blk, n, (long long)write_blks);
+		sw->info->mssg("flash write failure", sw->response);
+		return write_blks;
+	}
+
+	/* write_blks < n */
+	printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
+	       __func__, blk, n);
+	sw->info->mssg("flash write failure(incomplete)", sw->response);
+	return -1;
+}
+
+/*
+ * Write out the raw data gathered so far, returning the number of blocks
+ * written, which may be more than were gathered (e.g. NAND bad-blocks)
+ */
+static lbaint_t write_sparse_flush(struct sparse_write *sw)
 {
-	lbaint_t n = blkcnt, write_blks, blks = 0;
-	lbaint_t aligned_buf_blks = FASTBOOT_MAX_BLK_WRITE;
-	uint32_t *aligned_buf = NULL;
+	struct sparse_storage *info = sw->info;
+	lbaint_t n = sw->raw_cnt, write_blks;
+	ulong start_us;
+
+	if (!n)
+		return 0;
+
+	start_us = bootstage_event_start();
+	write_blks = info->write(info, sw->raw_blk, n, sw->raw_buf);
+	bootstage_event_end(BOOTSTAGE_EVENT_SPARSE_WRITE, "raw", start_us);
+	sw->raw_cnt = 0;
+	if (IS_ERR_VALUE(write_blks) || write_blks < n)
+		return write_fail(sw, sw->raw_blk, n, write_blks);
+
+	return write_blks;
+}
+
+/*
+ * Add a raw chunk to the data gathered so far, writing it out whenever the
+ * buffer is full. *@blkp is updated to the block following the chunk
+ */
+static int write_sparse_chunk_raw(struct sparse_write *sw, lbaint_t *blkp,
+				  lbaint_t blkcnt, void *data)
+{
+	struct sparse_storage *info = sw->info;
+	lbaint_t n, blks;
 
 	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF)) {
-		write_blks = info->write(info, blk, n, data);
-		if (write_blks < n)
-			goto write_fail;
+		n = info->write(info, *blkp, blkcnt, data);
+		if (IS_ERR_VALUE(n) || n < blkcnt) {
+			write_fail(sw, *blkp, blkcnt, n);
+			return -EIO;
+		}
+		*blkp += n;
 
-		return write_blks;
+		return 0;
 	}
 
-	aligned_buf = memalign(ARCH_DMA_MINALIGN, info->blksz * aligned_buf_blks);
-	if (!aligned_buf) {
-		info->mssg("Malloc failed for: CHUNK_TYPE_RAW", response);
-		return -ENOMEM;
+	if (!sw->raw_buf) {
+		sw->raw_max = FASTBOOT_MAX_BLK_WRITE;
+		sw->raw_buf = memalign(ARCH_DMA_MINALIGN,
+				       info->blksz * sw->raw_max);
+		if (!sw->raw_buf) {
+			info->mssg("Malloc failed for: CHUNK_TYPE_RAW",
+				   sw->response);
+			return -ENOMEM;
+		}
 	}
 
 	while (blkcnt > 0) {
-		n = min(aligned_buf_blks, blkcnt);
-		memcpy(aligned_buf, data, n * info->blksz);
-
-		/* write_blks might be > n due to NAND bad-blocks */
-		write_blks = info->write(info, blk + blks, n, aligned_buf);
-		if (write_blks < n) {
-			free(aligned_buf);
-			goto write_fail;
+		if (sw->raw_cnt == sw->raw_max) {
+			/* write_blks might be > n due to NAND bad-blocks */
+			blks = write_sparse_flush(sw);
+			if (IS_ERR_VALUE(blks))
+				return -EIO;
+			*blkp += blks - sw->raw_max;
 		}
-
-		blks += write_blks;
+		if (!sw->raw_cnt)
+			sw->raw_blk = *blkp;
+		n = min(sw->raw_max - sw->raw_cnt, blkcnt);
+		memcpy(sw->raw_buf + sw->raw_cnt * info->blksz, data,
+		       n * info->blksz);
+		sw->raw_cnt += n;
+		*blkp += n;
 		data += n * info->blksz;
 		blkcnt -= n;
 	}
 
-	free(aligned_buf);
-	return blks;
+	return 0;
+}
 
-write_fail:
-	if (IS_ERR_VALUE(write_blks)) {
-		printf("%s: Write failed, block #" LBAFU " [" LBAFU "] (%lld)\n",
-		       __func__, blk + blks, n, (long long)write_blks);
-		info->mssg("flash write failure", response);
-		return write_blks;
+/* Write the data gathered so far, updating *@blkp for any extra blocks */
+static int write_sparse_sync(struct sparse_write *sw, lbaint_t *blkp)
+{
+	lbaint_t cnt = sw->raw_cnt, blks;
+
+	blks = write_sparse_flush(sw);
+	if (IS_ERR_VALUE(blks))
+		return -EIO;
+	*blkp += blks - cnt;
+
+	return 0;
+}
+
+/* Fill blocks by writing out a buffer of fill values */
+static int write_sparse_fill_blocks(struct sparse_write *sw, lbaint_t *blkp,
+				    lbaint_t blkcnt)
+{
+	struct sparse_storage *info = sw->info;
+	lbaint_t blks, j;
+	ulong start_us;
+
+	while (blkcnt > 0) {
+		j = min(blkcnt, sw->fill_num_blks);
+		start_us = bootstage_event_start();
+		blks = info->write(info, *blkp, j, sw->fill_buf);
+		bootstage_event_end(BOOTSTAGE_EVENT_SPARSE_WRITE, "fill",
+				    start_us);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (IS_ERR_VALUE(blks) || blks < j) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Write failed, block #", *blkp, j);
+			info->mssg("flash write failure", sw->response);
+			return -EIO;
+		}
+		*blkp += blks;
+		blkcnt -= j;
 	}
 
-	/* write_blks < n */
-	printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
-	       __func__, blk + blks, n);
-	info->mssg("flash write failure(incomplete)", response);
-	return -1;
+	return 0;
 }
 
-int write_sparse_image(struct sparse_storage *info,
-		       const char *part_name, void *data, char *response)
+/*
+ * Handle a FILL chunk. If the storage can erase to the fill value, that is
+ * used for the part of the chunk which is aligned to the erase size, so only
+ * the ends are written
+ */
+static int write_sparse_chunk_fill(struct sparse_write *sw, lbaint_t *blkp,
+				   lbaint_t blkcnt, uint32_t fill_val)
+{
+	struct sparse_storage *info = sw->info;
+	lbaint_t head = 0, mid = 0, blks;
+	ulong start_us;
+	u32 align, rem;
+	int i, ret;
+
+	if (info->erase && fill_val == info->erase_val) {
+		align = max_t(lbaint_t, info->erase_align, 1);
+		div_u64_rem(*blkp, align, &rem);
+		head = rem ? min_t(lbaint_t, align - rem, blkcnt) : 0;
+		div_u64_rem(blkcnt - head, align, &rem);
+		mid = blkcnt - head - rem;
+	}
+
+	if (mid != blkcnt) {
+		if (!sw->fill_buf) {
+			sw->fill_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE /
+					    info->blksz;
+			sw->fill_buf = memalign(ARCH_DMA_MINALIGN,
+						ROUNDUP(info->blksz *
+							sw->fill_num_blks,
+							ARCH_DMA_MINALIGN));
+			if (!sw->fill_buf) {
+				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
+					   sw->response);
+				return -ENOMEM;
+			}
+			sw->fill_val = ~fill_val;
+		}
+		if (sw->fill_val != fill_val) {
+			for (i = 0; i < (info->blksz * sw->fill_num_blks /
+					 sizeof(fill_val)); i++)
+				sw->fill_buf[i] = fill_val;
+			sw->fill_val = fill_val;
+		}
+	}
+	if (!mid)
+		return write_sparse_fill_blocks(sw, blkp, blkcnt);
+
+	ret = write_sparse_fill_blocks(sw, blkp, head);
+	if (ret)
+		return ret;
+
+	debug("Erasing " LBAFU " blocks at " LBAFU "\n", mid, *blkp);
+	start_us = bootstage_event_start();
+	blks = info->erase(info, *blkp, mid);
+	bootstage_event_end(BOOTSTAGE_EVENT_SPARSE_WRITE, "erase", start_us);
+	if (IS_ERR_VALUE(blks) || blks < mid) {
+		printf("%s: Erase failed, block #" LBAFU " [" LBAFU "]\n",
+		       __func__, *blkp, mid);
+		info->mssg("flash erase failure", sw->response);
+		return -EIO;
+	}
+	*blkp += blks;
+
+	return write_sparse_fill_blocks(sw, blkp, blkcnt - head - mid);
+}
+
+static int write_sparse_chunks(struct sparse_write *sw, const char *part_name,
+			       void *data)
 {
+	struct sparse_storage *info = sw->info;
+	char *response = sw->response;
 	lbaint_t blk;
 	lbaint_t blkcnt;
-	lbaint_t blks;
 	uint64_t bytes_written = 0;
 	unsigned int chunk;
 	unsigned int offset;
 	uint64_t chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	ulong start;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -139,9 +309,6 @@ int write_sparse_image(struct sparse_storage *info,
 		data += (sparse_header->file_hdr_sz - sizeof(sparse_header_t));
 	}
 
-	if (!info->mssg)
-		info->mssg = default_log;
-
 	debug("=== Sparse Image Header ===\n");
 	debug("magic: 0x%x\n", sparse_header->magic);
 	debug("major_version: 0x%x\n", sparse_header->major_version);
@@ -165,6 +332,7 @@ int write_sparse_image(struct sparse_storage *info,
 	}
 
 	puts("Flashing Sparse Image\n");
+	start = get_timer(0);
 
 	/* Start processing chunks */
 	blk = info->start;
@@ -191,6 +359,13 @@ int write_sparse_image(struct sparse_storage *info,
 
 		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
 		blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+
+		/* Only a raw chunk can follow on from the data gathered */
+		if (chunk_header->chunk_type != CHUNK_TYPE_RAW &&
+		    chunk_header->chunk_type != CHUNK_TYPE_CRC32 &&
+		    write_sparse_sync(sw, &blk))
+			return -1;
+
 		switch (chunk_header->chunk_type) {
 		case CHUNK_TYPE_RAW:
 			if (chunk_header->total_sz !=
@@ -209,12 +384,9 @@ int write_sparse_image(struct sparse_storage *info,
 				return -1;
 			}
 
-			blks = write_sparse_chunk_raw(info, blk, blkcnt,
-						      data, response);
-			if (IS_ERR_VALUE(blks))
+			if (write_sparse_chunk_raw(sw, &blk, blkcnt, data))
 				return -1;
 
-			blk += blks;
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -227,59 +399,24 @@ int write_sparse_image(struct sparse_storage *info,
 				return -1;
 			}
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
-
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
 				info->mssg("Request would exceed partition size!",
 					   response);
-				free(fill_buf);
 				return -1;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
-			}
+			if (write_sparse_chunk_fill(sw, &blk, blkcnt, fill_val))
+				return -1;
+
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -305,10 +442,13 @@ int write_sparse_image(struct sparse_storage *info,
 			return -1;
 		}
 	}
+	if (write_sparse_sync(sw, &blk))
+		return -1;
 
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
+	printf("........ wrote %llu bytes to '%s' in %lu ms\n", bytes_written,
+	       part_name, get_timer(start));
 
 	if (total_blocks != sparse_header->total_blks) {
 		info->mssg("sparse image write failure", response);
@@ -317,3 +457,22 @@ int write_sparse_image(struct sparse_storage *info,
 
 	return 0;
 }
+
+int write_sparse_image(struct sparse_storage *info,
+		       const char *part_name, void *data, char *response)
+{
+	struct sparse_write sw = {
+		.info = info,
+		.response = response,
+	};
+	int ret;
+
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	ret = write_sparse_chunks(&sw, part_name, data);
+	free(sw.raw_buf);
+	free(sw.fill_buf);
+
+	return ret;
+}
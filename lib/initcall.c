@@ -3,6 +3,7 @@
  * Copyright (c) 2013 The Chromium OS Authors.
  */
 
+#include <bootstage.h>
 #include <efi.h>
 #include <initcall.h>
 #include <log.h>
@@ -42,6 +43,26 @@ static int initcall_is_event(init_fnc_t func)
 	return 0;
 }
 
+/**
+ * initcall_add_event() - Record the time taken by an initcall
+ *
+ * @func: Function pointer which was called
+ * @type: Event number, if this is an event, else 0
+ * @reloc_ofs: Relocation offset, so the pre-relocation address is recorded
+ * @start_us: Time the initcall started
+ */
+static void initcall_add_event(init_fnc_t func, enum event_t type,
+			       ulong reloc_ofs, ulong start_us)
+{
+	char name[20];
+
+	if (CONFIG_IS_ENABLED(EVENT) && type)
+		strlcpy(name, event_type_name(type), sizeof(name));
+	else
+		snprintf(name, sizeof(name), "%lx", (ulong)func - reloc_ofs);
+	bootstage_event_end(BOOTSTAGE_EVENT_INITCALL, name, start_us);
+}
+
 /*
  * To enable debugging. add #define DEBUG at the top of the including file.
  *
@@ -53,6 +74,7 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 	const init_fnc_t *ptr;
 	enum event_t type;
 	init_fnc_t func;
+	ulong start_us;
 	int ret = 0;
 
 	for (ptr = init_sequence; func = *ptr, !ret && func; ptr++) {
@@ -70,7 +92,10 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 			debug("initcall: %p\n", (char *)func - reloc_ofs);
 		}
 
+		start_us = bootstage_event_start();
 		ret = type ? event_notify_null(type) : func();
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_EVENTS))
+			initcall_add_event(func, type, reloc_ofs, start_us);
 	}
 
 	if (ret) {
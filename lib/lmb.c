@@ -7,6 +7,7 @@
  */
 
 #include <efi_loader.h>
+#include <errno.h>
 #include <image.h>
 #include <mapmem.h>
 #include <lmb.h>
@@ -20,6 +21,15 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define LMB_ALLOC_ANYWHERE	0
 
+/* Global lmb, see lmb_get() */
+static struct lmb lmb_global;
+static bool lmb_global_valid;
+static const void *lmb_global_fdt;
+static ulong lmb_global_sp;
+
+/* Stack pointer passed to the last call to arch_lmb_reserve_generic() */
+static ulong lmb_reserved_sp;
+
 static void lmb_dump_region(struct lmb_region *rgn, char *name)
 {
 	unsigned long long base, size, end;
@@ -73,35 +83,56 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/*
+ * Find the first region which ends at or above @addr. Regions are sorted and
+ * do not overlap, so this is the only region which can contain @addr, and the
+ * first which can overlap a range starting at @addr.
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t addr)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	unsigned long lo = 0, hi = rgn->cnt;
+
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		struct lmb_property *r = &rgn->region[mid];
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+		if (r->base + r->size - 1 < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
 static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	unsigned long i;
-
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-		rgn->region[i].flags = rgn->region[i + 1].flags;
-	}
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(rgn->region[0]));
 	rgn->cnt--;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/* Make room for another region, if the array can grow */
+static int lmb_region_grow(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC)
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	region = malloc(max * sizeof(*region));
+	if (!region)
+		return -ENOMEM;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->alloced)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+	rgn->alloced = true;
+
+	return 0;
+#else
+	return -ENOSPC;
+#endif
 }
 
 void lmb_init(struct lmb *lmb)
@@ -114,6 +145,22 @@ void lmb_init(struct lmb *lmb)
 	lmb->reserved.max = CONFIG_LMB_RESERVED_REGIONS;
 	lmb->memory.region = lmb->memory_regions;
 	lmb->reserved.region = lmb->reserved_regions;
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
+#endif
+	lmb->memory.cnt = 0;
+	lmb->reserved.cnt = 0;
+}
+
+void lmb_uninit(struct lmb *lmb)
+{
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC)
+	if (lmb->memory.alloced)
+		free(lmb->memory.region);
+	if (lmb->reserved.alloced)
+		free(lmb->reserved.region);
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
 #endif
 	lmb->memory.cnt = 0;
 	lmb->reserved.cnt = 0;
@@ -130,6 +177,7 @@ void arch_lmb_reserve_generic(struct lmb *lmb, ulong sp, ulong end, ulong align)
 	 * that memory.
 	 */
 	debug("## Current stack ends at 0x%08lx ", sp);
+	lmb_reserved_sp = sp;
 
 	/* adjust sp by 4K to be safe */
 	sp -= align;
@@ -230,83 +278,56 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 static long lmb_add_region_flags_nonoverlap(struct lmb_region *rgn, phys_addr_t base,
 				 phys_size_t size, enum lmb_flags flags)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-		rgn->cnt = 1;
-		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		phys_size_t rgnflags = rgn->region[i].flags;
+	struct lmb_property *prev = NULL, *next = NULL;
+	unsigned long i;
 
-		if (rgnbase == base && rgnsize == size) {
-			if (flags == rgnflags)
+	/* The new region goes before region i and after region i - 1 */
+	i = lmb_search(rgn, base);
+	if (i < rgn->cnt) {
+		next = &rgn->region[i];
+		if (next->base == base && next->size == size) {
+			if (flags == next->flags)
 				/* Already have this region, so we're done */
 				return -2;
 			else
 				return -1; /* regions with new flags */
 		}
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
-			return -2;
-		}
+		if (lmb_addrs_overlap(base, size, next->base, next->size))
+			return -2; /* regions overlap */
+		if (lmb_addrs_adjacent(base, size, next->base, next->size) <= 0 ||
+		    flags != next->flags)
+			next = NULL;
+	}
+	if (i > 0) {
+		prev = &rgn->region[i - 1];
+		if (lmb_addrs_adjacent(base, size, prev->base, prev->size) >= 0 ||
+		    flags != prev->flags)
+			prev = NULL;
 	}
 
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		if (rgn->region[i].flags == rgn->region[i + 1].flags) {
-			lmb_coalesce_regions(rgn, i, i + 1);
-			coalesced++;
-		}
+	/* First try and coalesce this LMB with its neighbours. */
+	if (prev && next) {
+		prev->size += size + next->size;
+		lmb_remove_region(rgn, i);
+		return 2;
+	} else if (prev) {
+		prev->size += size;
+		return 1;
+	} else if (next) {
+		next->base = base;
+		next->size += size;
+		return 1;
 	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= rgn->max)
+	if (rgn->cnt >= rgn->max && lmb_region_grow(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-			rgn->region[i + 1].flags = rgn->region[i].flags;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			rgn->region[i + 1].flags = flags;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(rgn->region[0]));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->region[i].flags = flags;
 	rgn->cnt++;
 
 	return 0;
@@ -315,16 +336,13 @@ static long lmb_add_region_flags_nonoverlap(struct lmb_region *rgn, phys_addr_t
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
+	unsigned long i = lmb_search(rgn, base);
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
@@ -384,19 +402,15 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	phys_addr_t end = base + size - 1;
 	int i;
 
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
-
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_search(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -515,47 +529,58 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
  * Try to allocate a specific address range: must be in defined memory but not
  * reserved
  */
-phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+/* Check that a range lies within a single memory region */
+static bool lmb_in_memory(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
 	long rgn;
 
 	/* Check if the requested address is in one of the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, base, size);
-	if (rgn >= 0) {
-		/*
-		 * Check if the requested end address is in the same memory
-		 * region we found.
-		 */
-		if (lmb_addrs_overlap(lmb->memory.region[rgn].base,
-				      lmb->memory.region[rgn].size,
-				      base + size - 1, 1)) {
-			/* ok, reserve the memory */
-			if (lmb_reserve_nonoverlap(lmb, base, size) >= 0)
-				return base;
-		}
-	}
+	if (rgn < 0)
+		return false;
+
+	/*
+	 * Check if the requested end address is in the same memory region we
+	 * found.
+	 */
+	return lmb_addrs_overlap(lmb->memory.region[rgn].base,
+				 lmb->memory.region[rgn].size,
+				 base + size - 1, 1);
+}
+
+phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	/* ok, reserve the memory */
+	if (lmb_in_memory(lmb, base, size) &&
+	    lmb_reserve_nonoverlap(lmb, base, size) >= 0)
+		return base;
+
 	return 0;
 }
 
+bool lmb_is_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	return lmb_in_memory(lmb, base, size) &&
+	       lmb_overlaps_region(&lmb->reserved, base, size) < 0;
+}
+
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
+		i = lmb_search(&lmb->reserved, addr);
+		if (i < lmb->reserved.cnt) {
 			if (addr < lmb->reserved.region[i].base) {
 				/* first reserved range > requested address */
 				return lmb->reserved.region[i].base - addr;
 			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -566,14 +591,11 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved_flags(struct lmb *lmb, phys_addr_t addr, int flags)
 {
-	int i;
+	unsigned long i = lmb_search(&lmb->reserved, addr);
+
+	if (i < lmb->reserved.cnt && addr >= lmb->reserved.region[i].base)
+		return (lmb->reserved.region[i].flags & flags) == flags;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return (lmb->reserved.region[i].flags & flags) == flags;
-	}
 	return 0;
 }
 
@@ -582,6 +604,32 @@ int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 	return lmb_is_reserved_flags(lmb, addr, LMB_NONE);
 }
 
+struct lmb *lmb_get(void)
+{
+	/*
+	 * U-Boot's stack is reserved from a little below the stack pointer at
+	 * the time, so rebuild if the stack has since grown beyond that
+	 */
+	if (lmb_global_valid && lmb_global_fdt == gd->fdt_blob &&
+	    (!lmb_global_sp ||
+	     (ulong)__builtin_frame_address(0) >= lmb_global_sp))
+		return &lmb_global;
+
+	lmb_uninit(&lmb_global);
+	lmb_reserved_sp = 0;
+	lmb_init_and_reserve(&lmb_global, gd->bd, (void *)gd->fdt_blob);
+	lmb_global_sp = lmb_reserved_sp;
+	lmb_global_fdt = gd->fdt_blob;
+	lmb_global_valid = true;
+
+	return &lmb_global;
+}
+
+void lmb_invalidate(void)
+{
+	lmb_global_valid = false;
+}
+
 __weak void board_lmb_reserve(struct lmb *lmb)
 {
 	/* please define platform specific board_lmb_reserve() */
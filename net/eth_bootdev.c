@@ -41,7 +41,7 @@ static int eth_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 	 */
 
 	snprintf(name, sizeof(name), "%s.%d", dev->name, iter->part);
-	bflow->name = strdup(name);
+	bflow->name = bootflow_strdup(bflow, name);
 	if (!bflow->name)
 		return log_msg_ret("name", -ENOMEM);
 
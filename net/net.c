@@ -198,16 +198,19 @@ static rxhand_f *arp_packet_handler;
 /* Current ICMP rx handler */
 static rxhand_icmp_f *packet_icmp_handler;
 #endif
+/* Pending timers, soonest first */
+static LIST_HEAD(net_timers);
 /* Current timeout handler */
 static thand_f *time_handler;
-/* Time base value */
-static ulong	time_start;
-/* Current timeout value */
+/* Timer which calls the timeout handler */
+static struct net_timer time_handler_timer;
+/* Current timeout value in milliseconds */
 static ulong	time_delta;
 /* THE transmit packet */
 uchar *net_tx_packet;
 
 static int net_check_prereq(enum proto_t protocol);
+static void net_restart_timeout(void);
 
 static int net_try_count;
 
@@ -383,9 +386,13 @@ static int net_init_loop(void)
 
 static void net_clear_handlers(void)
 {
+	struct net_timer *timer, *next;
+
 	net_set_udp_handler(NULL);
 	net_set_arp_handler(NULL);
 	net_set_timeout_handler(0, NULL);
+	list_for_each_entry_safe(timer, next, &net_timers, node)
+		list_del_init(&timer->node);
 }
 
 static void net_cleanup_loop(void)
@@ -431,6 +438,8 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	ulong now, last_poll;
+	bool busy, poll;
 
 #if defined(CONFIG_CMD_PING)
 	if (protocol != PING)
@@ -630,24 +639,39 @@ restart:
 	/*
 	 *	Main packet reception loop.  Loop receiving packets until
 	 *	someone sets `net_state' to a state that terminates.
+	 *
+	 *	eth_rx() handles a batch of packets each time. While it keeps
+	 *	filling the whole batch, the console, cyclic functions and
+	 *	timers are only looked at once per millisecond, so that most of
+	 *	the time goes to receiving.
 	 */
+	busy = false;
+	last_poll = get_timer(0);
 	for (;;) {
-		schedule();
-		if (arp_timeout_check() > 0)
-			time_start = get_timer(0);
-
-		if (IS_ENABLED(CONFIG_IPV6)) {
-			if (use_ip6 && (ndisc_timeout_check() > 0))
-				time_start = get_timer(0);
+		now = get_timer(0);
+		poll = !busy || now != last_poll;
+		if (poll) {
+			last_poll = now;
+			schedule();
+			if (arp_timeout_check() > 0)
+				net_restart_timeout();
+
+			if (IS_ENABLED(CONFIG_IPV6)) {
+				if (use_ip6 && (ndisc_timeout_check() > 0))
+					net_restart_timeout();
+			}
 		}
 
 		/*
 		 *	Check the ethernet for a new packet.  The ethernet
 		 *	receive routine will process it.
-		 *	Most drivers return the most recent packet size, but not
-		 *	errors that may have happened.
+		 *	This returns a positive value if the batch was full,
+		 *	meaning that more packets are likely waiting.
 		 */
-		eth_rx();
+		busy = eth_rx() > 0;
+
+		if (!poll)
+			goto check_state;
 
 		/*
 		 *	Abort if ctrl-c was pressed.
@@ -670,34 +694,11 @@ restart:
 		}
 
 		/*
-		 *	Check for a timeout, and run the timeout handler
-		 *	if we have one.
+		 *	Run any timers which have expired, including the timeout
+		 *	handler if we have one.
 		 */
-		if (time_handler &&
-		    ((get_timer(0) - time_start) > time_delta)) {
-			thand_f *x;
-
-#if defined(CONFIG_MII) || defined(CONFIG_CMD_MII)
-#if	defined(CONFIG_SYS_FAULT_ECHO_LINK_DOWN)	&& \
-	defined(CONFIG_LED_STATUS)			&& \
-	defined(CONFIG_LED_STATUS_RED)
-			/*
-			 * Echo the inverted link state to the fault LED.
-			 */
-			if (miiphy_link(eth_get_dev()->name,
-					CONFIG_SYS_FAULT_MII_ADDR))
-				status_led_set(CONFIG_LED_STATUS_RED,
-					       CONFIG_LED_STATUS_OFF);
-			else
-				status_led_set(CONFIG_LED_STATUS_RED,
-					       CONFIG_LED_STATUS_ON);
-#endif /* CONFIG_SYS_FAULT_ECHO_LINK_DOWN, ... */
-#endif /* CONFIG_MII, ... */
-			debug_cond(DEBUG_INT_STATE, "--- net_loop timeout\n");
-			x = time_handler;
-			time_handler = (thand_f *)0;
-			(*x)();
-		} else if (IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY))
+		net_timer_run();
+		if (IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY))
 			if (time_handler && protocol == RS)
 				if (!ip6_is_unspecified_addr(&net_gateway6) &&
 				    net_prefix_length != 0) {
@@ -705,6 +706,7 @@ restart:
 					net_set_timeout_handler(0, NULL);
 				}
 
+check_state:
 		if (net_state == NETLOOP_FAIL)
 			ret = net_start_again();
 
@@ -870,18 +872,90 @@ void net_set_icmp_handler(rxhand_icmp_f *f)
 }
 #endif
 
+static void net_timeout_expired(struct net_timer *timer)
+{
+	thand_f *x;
+
+#if defined(CONFIG_MII) || defined(CONFIG_CMD_MII)
+#if	defined(CONFIG_SYS_FAULT_ECHO_LINK_DOWN)	&& \
+	defined(CONFIG_LED_STATUS)			&& \
+	defined(CONFIG_LED_STATUS_RED)
+	/*
+	 * Echo the inverted link state to the fault LED.
+	 */
+	if (miiphy_link(eth_get_dev()->name, CONFIG_SYS_FAULT_MII_ADDR))
+		status_led_set(CONFIG_LED_STATUS_RED, CONFIG_LED_STATUS_OFF);
+	else
+		status_led_set(CONFIG_LED_STATUS_RED, CONFIG_LED_STATUS_ON);
+#endif /* CONFIG_SYS_FAULT_ECHO_LINK_DOWN, ... */
+#endif /* CONFIG_MII, ... */
+	debug_cond(DEBUG_INT_STATE, "--- net_loop timeout\n");
+	x = time_handler;
+	time_handler = (thand_f *)0;
+	(*x)();
+}
+
 void net_set_timeout_handler(ulong iv, thand_f *f)
 {
 	if (iv == 0) {
 		debug_cond(DEBUG_INT_STATE,
 			   "--- net_loop timeout handler cancelled\n");
 		time_handler = (thand_f *)0;
+		net_timer_stop(&time_handler_timer);
 	} else {
 		debug_cond(DEBUG_INT_STATE,
 			   "--- net_loop timeout handler set (%p)\n", f);
 		time_handler = f;
-		time_start = get_timer(0);
-		time_delta = iv * CONFIG_SYS_HZ / 1000;
+		time_delta = iv;
+		time_handler_timer.func = net_timeout_expired;
+		net_timer_start(&time_handler_timer, time_delta);
+	}
+}
+
+/* Put off the timeout handler, since something is still happening */
+static void net_restart_timeout(void)
+{
+	if (time_handler)
+		net_timer_start(&time_handler_timer, time_delta);
+}
+
+bool net_timer_pending(struct net_timer *timer)
+{
+	return timer->node.next && !list_empty(&timer->node);
+}
+
+void net_timer_stop(struct net_timer *timer)
+{
+	if (net_timer_pending(timer))
+		list_del_init(&timer->node);
+}
+
+void net_timer_start(struct net_timer *timer, ulong ms)
+{
+	struct net_timer *pos;
+
+	net_timer_stop(timer);
+	timer->expires = get_timer(0) + ms;
+
+	/* Keep the list sorted, after any timers expiring at the same time */
+	list_for_each_entry(pos, &net_timers, node) {
+		if ((long)(pos->expires - timer->expires) > 0)
+			break;
+	}
+	list_add_tail(&timer->node, &pos->node);
+}
+
+void net_timer_run(void)
+{
+	struct net_timer *timer;
+	ulong now = get_timer(0);
+
+	while (!list_empty(&net_timers)) {
+		timer = list_first_entry(&net_timers, struct net_timer, node);
+		if ((long)(now - timer->expires) <= 0)
+			break;
+		list_del_init(&timer->node);
+		timer->func(timer);
 	}
 }
 
@@ -979,14 +1053,18 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 
 #ifdef CONFIG_IP_DEFRAG
 /*
- * This function collects fragments in a single packet, according
- * to the algorithm in RFC815. It returns NULL or the pointer to
- * a complete packet, in static storage
+ * This function collects fragments in a packet, according to the algorithm
+ * in RFC815. Up to CONFIG_NET_DEFRAG_SLOTS packets are collected at once,
+ * each identified by its source address and IP id. It returns NULL or the
+ * pointer to a complete packet, in static storage
  */
 #define IP_PKTSIZE (CONFIG_NET_MAXDEFRAG)
 
 #define IP_MAXUDP (IP_PKTSIZE - IP_HDR_SIZE)
 
+/* After this long (in ms), a packet with the same IP id is a new one */
+#define IP_DEFRAG_TIMEOUT	5000
+
 /*
  * this is the packet being assembled, either data or frag control.
  * Fragments go by 8 bytes, so this union must be 8 bytes long
@@ -999,12 +1077,69 @@ struct hole {
 	u16 unused;
 };
 
+/**
+ * struct defrag_slot - a packet being reassembled
+ *
+ * @buf: Packet, starting with the IP header of the first fragment received
+ * @first_hole: Index of the first hole in the payload, in 8-byte blocks
+ * @total_len: Length of the payload, 0xffff if not yet known, 0 if the slot
+ *	is unused
+ * @start: Time when the first fragment was received
+ */
+struct defrag_slot {
+	uchar buf[IP_PKTSIZE] __aligned(PKTALIGN);
+	u16 first_hole;
+	u16 total_len;
+	ulong start;
+};
+
+static struct defrag_slot defrag_slots[CONFIG_NET_DEFRAG_SLOTS];
+
+/*
+ * Find the slot for the packet which a fragment belongs to. If there is none,
+ * start a new packet in an unused slot, or else in the one which has waited
+ * longest, throwing away what it held.
+ */
+static struct defrag_slot *net_defrag_slot(struct ip_udp_hdr *ip)
+{
+	struct defrag_slot *slot, *victim = NULL;
+	struct ip_udp_hdr *localip;
+	struct hole *payload;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(defrag_slots); i++) {
+		slot = &defrag_slots[i];
+		localip = (struct ip_udp_hdr *)slot->buf;
+		if (slot->total_len && localip->ip_id == ip->ip_id &&
+		    !memcmp(&localip->ip_src, &ip->ip_src,
+			    sizeof(ip->ip_src)) &&
+		    get_timer(slot->start) < IP_DEFRAG_TIMEOUT)
+			return slot;
+		if (!victim || (victim->total_len && (!slot->total_len ||
+		    (long)(slot->start - victim->start) < 0)))
+			victim = slot;
+	}
+
+	/* new (or different) packet, reset structs */
+	slot = victim;
+	payload = (struct hole *)(slot->buf + IP_HDR_SIZE);
+	slot->total_len = 0xffff;
+	payload[0].last_byte = ~0;
+	payload[0].next_hole = 0;
+	payload[0].prev_hole = 0;
+	slot->first_hole = 0;
+	slot->start = get_timer(0);
+	/* any IP header will work, copy the first we received */
+	memcpy(slot->buf, ip, IP_HDR_SIZE);
+
+	return slot;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
+	struct defrag_slot *slot;
 	struct hole *payload, *thisfrag, *h, *newh;
-	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
+	struct ip_udp_hdr *localip;
 	uchar *indata = (uchar *)ip;
 	int offset8, start, len, done = 0;
 	u16 ip_off = ntohs(ip->ip_off);
@@ -1016,10 +1151,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (ntohs(ip->ip_len) <= IP_HDR_SIZE)
 		return NULL;
 
-	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
 	offset8 =  (ip_off & IP_OFFS);
-	thisfrag = payload + offset8;
 	start = offset8 * 8;
 	len = ntohs(ip->ip_len) - IP_HDR_SIZE;
 
@@ -1030,16 +1162,12 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (start + len > IP_MAXUDP) /* fragment extends too far */
 		return NULL;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
-		payload[0].last_byte = ~0;
-		payload[0].next_hole = 0;
-		payload[0].prev_hole = 0;
-		first_hole = 0;
-		/* any IP header will work, copy the first we received */
-		memcpy(localip, ip, IP_HDR_SIZE);
-	}
+	slot = net_defrag_slot(ip);
+	localip = (struct ip_udp_hdr *)slot->buf;
+
+	/* payload starts after IP header, this fragment is in there */
+	payload = (struct hole *)(slot->buf + IP_HDR_SIZE);
+	thisfrag = payload + offset8;
 
 	/*
 	 * What follows is the reassembly algorithm. We use the payload
@@ -1048,7 +1176,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + slot->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
@@ -1065,7 +1193,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		slot->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -1086,7 +1214,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 			done = 1;
 		} else if (!h->prev_hole) {
 			/* first hole */
-			first_hole = h->next_hole;
+			slot->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -1111,7 +1239,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		if (h->prev_hole)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			slot->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -1129,8 +1257,10 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	*lenp = total_len + IP_HDR_SIZE;
+	*lenp = slot->total_len + IP_HDR_SIZE;
 	localip->ip_len = htons(*lenp);
+	/* The slot is free again, but keeps the packet until it is reused */
+	slot->total_len = 0;
 	return localip;
 }
 
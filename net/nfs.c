@@ -46,6 +46,7 @@
 #include <time.h>
 
 #define HASHES_PER_LINE 65	/* Number of "loading" hashes per line	*/
+#define HASH_BYTES	((NFS_READ_SIZE / 2) * 10) /* Bytes per hash */
 #define NFS_RETRY_COUNT 30
 
 #define NFS_RPC_ERR	1
@@ -53,10 +54,33 @@
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static const ulong nfs_timeout = CONFIG_NFS_TIMEOUT;
 
+/**
+ * struct nfs_read_slot - an outstanding READ request
+ *
+ * @timer: Timer to resend the request if no reply arrives
+ * @xid: RPC id of the request, which is kept when resending
+ * @offset: Offset in the file of the data requested
+ * @len: Number of bytes requested
+ * @tries: Number of times the request has been resent
+ * @busy: true if waiting for a reply
+ */
+struct nfs_read_slot {
+	struct net_timer timer;
+	ulong xid;
+	ulong offset;
+	uint len;
+	int tries;
+	bool busy;
+};
+
+static struct nfs_read_slot nfs_read_slots[CONFIG_NFS_READ_WINDOW];
+static ulong nfs_read_next;	/* Offset of the next block to request */
+static ulong nfs_read_bytes;	/* Number of bytes received */
+static ulong nfs_read_hashes;	/* Number of progress hashes printed */
+static bool nfs_read_eof;	/* true once the end of file is reached */
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static unsigned int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -181,15 +205,14 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static void rpc_send(unsigned long id, int rpc_prog, int rpc_proc,
+		     uint32_t *data, int datalen)
 {
 	struct rpc_t rpc_pkt;
-	unsigned long id;
 	uint32_t *p;
 	int pktlen;
 	int sport;
 
-	id = ++rpc_id;
 	rpc_pkt.u.call.id = htonl(id);
 	rpc_pkt.u.call.type = htonl(MSG_CALL);
 	rpc_pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
@@ -256,6 +279,11 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 			    nfs_our_port, pktlen);
 }
 
+static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+{
+	rpc_send(++rpc_id, rpc_prog, rpc_proc, data, datalen);
+}
+
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
@@ -395,7 +423,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(struct nfs_read_slot *slot)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -407,22 +435,99 @@ static void nfs_read_req(int offset, int readlen)
 	if (choosen_nfs_version != NFS_V3) {
 		memcpy(p, filefh, NFS_FHSIZE);
 		p += (NFS_FHSIZE / 4);
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(slot->offset);
+		*p++ = htonl(slot->len);
 		*p++ = 0;
 	} else { /* NFS_V3 */
 		*p++ = htonl(filefh3_length);
 		memcpy(p, filefh, filefh3_length);
 		p += (filefh3_length / 4);
-		*p++ = htonl(0); /* offset is 64-bit long, so fill with 0 */
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl((u64)slot->offset >> 32); /* offset is 64-bit */
+		*p++ = htonl(slot->offset);
+		*p++ = htonl(slot->len);
 		*p++ = 0;
 	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	/* A resent request keeps its id, so that any reply will do */
+	rpc_send(slot->xid, PROG_NFS, NFS_READ, data, len);
+}
+
+static void nfs_read_send(struct nfs_read_slot *slot)
+{
+	nfs_read_req(slot);
+	net_timer_start(&slot->timer, nfs_timeout + nfs_timeout * slot->tries);
+}
+
+static void nfs_read_stop(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		net_timer_stop(&nfs_read_slots[i].timer);
+		nfs_read_slots[i].busy = false;
+	}
+}
+
+static void nfs_read_timeout(struct net_timer *timer)
+{
+	struct nfs_read_slot *slot;
+
+	slot = container_of(timer, struct nfs_read_slot, timer);
+	if (++slot->tries > NFS_RETRY_COUNT) {
+		puts("\nRetry count exceeded; starting again\n");
+		nfs_read_stop();
+		net_start_again();
+	} else {
+		puts("T ");
+		nfs_read_send(slot);
+	}
+}
+
+/*
+ * Send READ requests until CONFIG_NFS_READ_WINDOW are outstanding or the end
+ * of the file is reached. Returns true if any are outstanding.
+ */
+static bool nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+	bool busy = false;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		slot = &nfs_read_slots[i];
+		if (!slot->busy && !nfs_read_eof) {
+			slot->xid = ++rpc_id;
+			slot->offset = nfs_read_next;
+			slot->len = CONFIG_NFS_READ_SIZE;
+			slot->tries = 0;
+			slot->busy = true;
+			nfs_read_next += slot->len;
+			nfs_read_send(slot);
+		}
+		busy |= slot->busy;
+	}
+
+	return busy;
+}
+
+static void nfs_read_start(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		memset(&nfs_read_slots[i], '\0', sizeof(nfs_read_slots[i]));
+		nfs_read_slots[i].timer.func = nfs_read_timeout;
+	}
+	nfs_read_next = 0;
+	nfs_read_bytes = 0;
+	nfs_read_hashes = 0;
+	nfs_read_eof = false;
+
+	/* Each request has its own timer instead */
+	net_set_timeout_handler(0, NULL);
+	nfs_read_fill();
 }
 
 /**************************************************************************
@@ -455,7 +560,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_fill();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -704,20 +809,43 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
+static struct nfs_read_slot *nfs_read_find(ulong xid)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		if (nfs_read_slots[i].busy && nfs_read_slots[i].xid == xid)
+			return &nfs_read_slots[i];
+	}
+
+	return NULL;
+}
+
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
+	struct nfs_read_slot *slot;
 	struct rpc_t rpc_pkt;
-	int rlen;
-	uchar *data_ptr;
+	uint hdr_len, data_ofs;
+	int rlen, eof = 0;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/*
+	 * Only the header and attributes are copied; the data is stored
+	 * straight from the packet
+	 */
+	hdr_len = offsetof(struct rpc_t, u.reply.data[NFS_MAX_ATTRS]);
+	if (len < offsetof(struct rpc_t, u.reply.data[1]))
+		return -NFS_RPC_DROP;
+	memset(&rpc_pkt, '\0', hdr_len);
+	memcpy(&rpc_pkt.u.data[0], pkt, min(len, hdr_len));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	/* Replies may arrive in any order */
+	slot = nfs_read_find(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
 		return -NFS_RPC_DROP;
+	slot->busy = false;
+	net_timer_stop(&slot->timer);
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -730,34 +858,49 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (choosen_nfs_version != NFS_V3) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data_ofs = offsetof(struct rpc_t, u.reply.data[19]);
 	} else {  /* NFS_V3 */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
 		/* Skip unused values :
 			EOF:		32 bits value,
 			data_size:	32 bits value,
 		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		data_ofs = offsetof(struct rpc_t,
+				    u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
-			return -9999;
+	if (rlen < 0 || rlen > slot->len || data_ofs + rlen > len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	if (store_block(pkt + data_ofs, slot->offset, rlen))
+		return -9999;
+
+	nfs_read_bytes += rlen;
+	for (; nfs_read_hashes <= nfs_read_bytes / HASH_BYTES;
+	     nfs_read_hashes++) {
+		if (nfs_read_hashes && !(nfs_read_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+	}
+
+	if (!rlen || eof) {
+		nfs_read_eof = true;
+	} else if (rlen < slot->len) {
+		/* Short read, so ask for the rest */
+		slot->xid = ++rpc_id;
+		slot->offset += rlen;
+		slot->len -= rlen;
+		slot->tries = 0;
+		slot->busy = true;
+		nfs_read_send(slot);
+	}
 
 	return rlen;
 }
@@ -787,7 +930,8 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 	debug("%s\n", __func__);
 
-	if (len > sizeof(struct rpc_t))
+	/* Only READ replies are allowed to be larger than the buffer */
+	if (len > sizeof(struct rpc_t) && nfs_state != STATE_READ_REQ)
 		return;
 
 	if (dest != nfs_our_port)
@@ -858,9 +1002,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -886,16 +1028,16 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		rlen = nfs_read_reply(pkt, len);
 		if (rlen == -NFS_RPC_DROP)
 			break;
+		if (rlen >= 0 && nfs_read_fill())
+			break;
+		nfs_read_stop();
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
-		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
+		if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
+			if (rlen >= 0)
 				nfs_download_state = NETLOOP_SUCCESS;
 			if (rlen < 0)
 				debug("NFS READ error (%d)\n", rlen);
@@ -36,10 +36,9 @@
 #define NFSERR_INVAL    22
 
 /*
- * Block size used for NFS read accesses.  A RPC reply packet (including  all
- * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
- * case, most NFS servers are optimized for a power of 2.
+ * Size of the data in an RPC message buffer. Each RPC reply packet (including
+ * all headers) must fit within this, apart from READ replies, which are
+ * handled in place and may carry up to CONFIG_NFS_READ_SIZE bytes.
  */
 #define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
 #define NFS_MAX_ATTRS	26
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the early arena
+ */
+
+#include <common.h>
+#include <early_arena.h>
+#include <asm/global_data.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define TEST_ARENA_SIZE	0x200
+
+struct early_arena_test {
+	int val;
+	int *ptr;
+	int *outside;
+};
+
+static int do_test_early_arena(struct unit_test_state *uts, char *old_buf,
+			       char *new_buf)
+{
+	struct early_arena_test *data;
+	int outside = 3;
+	int *val;
+	int size;
+
+	ut_assertok(early_arena_init(old_buf, TEST_ARENA_SIZE));
+	ut_assertnull(early_arena_find(EARLY_ARENA_TEST, NULL));
+
+	data = early_arena_alloc(EARLY_ARENA_TEST, sizeof(*data));
+	ut_assertnonnull(data);
+	ut_assert((char *)data > old_buf);
+	ut_assert((char *)data < old_buf + TEST_ARENA_SIZE);
+	ut_assertnull(early_arena_alloc(EARLY_ARENA_TEST, sizeof(*data)));
+	ut_assertnull(early_arena_alloc(EARLY_ARENA_BOARD, TEST_ARENA_SIZE));
+
+	val = early_arena_alloc(EARLY_ARENA_BOARD, sizeof(*val));
+	ut_assertnonnull(val);
+	*val = 2;
+	data->val = 1;
+	data->ptr = val;
+	data->outside = &outside;
+	ut_assertok(early_arena_add_ptr((void **)&data->ptr));
+	ut_assertok(early_arena_add_ptr((void **)&data->outside));
+	ut_asserteq(-EINVAL, early_arena_add_ptr((void **)&val));
+
+	ut_asserteq_ptr(data, early_arena_find(EARLY_ARENA_TEST, &size));
+	ut_asserteq(sizeof(*data), size);
+
+	size = early_arena_finish();
+	ut_assert(size > 0 && size <= TEST_ARENA_SIZE);
+	ut_assertnull(early_arena_alloc(EARLY_ARENA_DRAM, 4));
+	ut_assertok(early_arena_relocate(new_buf));
+
+	/* the data should be in the new arena, with the pointer updated */
+	data = early_arena_find(EARLY_ARENA_TEST, NULL);
+	ut_assert((char *)data > new_buf && (char *)data < new_buf + size);
+	ut_asserteq(1, data->val);
+	ut_asserteq_ptr(early_arena_find(EARLY_ARENA_BOARD, NULL), data->ptr);
+	ut_asserteq(2, *data->ptr);
+	ut_asserteq_ptr(&outside, data->outside);
+
+	return 0;
+}
+
+/* Test allocating from the early arena and relocating it */
+static int common_test_early_arena(struct unit_test_state *uts)
+{
+	ulong old_buf[TEST_ARENA_SIZE / sizeof(ulong)];
+	ulong new_buf[TEST_ARENA_SIZE / sizeof(ulong)];
+	struct early_arena_hdr *saved = gd->early_arena;
+	int ret;
+
+	ret = do_test_early_arena(uts, (char *)old_buf, (char *)new_buf);
+	gd->early_arena = saved;
+
+	return ret;
+}
+COMMON_TEST(common_test_early_arena, 0);
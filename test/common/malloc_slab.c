@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the small-allocation front-end to malloc()
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Number of objects to allocate when testing many allocations */
+#define SLAB_TEST_COUNT		1000
+
+/* Test allocation, reallocation and freeing of small objects */
+static int common_test_malloc_slab(struct unit_test_state *uts)
+{
+	ulong start = ut_check_free();
+	char *ptr, *big, *aligned;
+	int i;
+
+	ptr = malloc(24);
+	ut_assertnonnull(ptr);
+	ut_assert(malloc_slab_owns(ptr));
+	ut_asserteq(32, malloc_usable_size(ptr));
+	ut_asserteq(0, (ulong)ptr & 15);
+
+	big = malloc(600);
+	ut_assertnonnull(big);
+	ut_assert(!malloc_slab_owns(big));
+	free(big);
+
+	/* Growing within the size class leaves the object where it is */
+	for (i = 0; i < 24; i++)
+		ptr[i] = i;
+	ut_asserteq_ptr(ptr, realloc(ptr, 32));
+
+	/* Growing beyond it moves the object, first to a larger class */
+	ptr = realloc(ptr, 100);
+	ut_assertnonnull(ptr);
+	ut_assert(malloc_slab_owns(ptr));
+	ut_asserteq(128, malloc_usable_size(ptr));
+	for (i = 0; i < 24; i++)
+		ut_asserteq(i, ptr[i]);
+
+	/* ...and then out of the slab region */
+	ptr = realloc(ptr, 1000);
+	ut_assertnonnull(ptr);
+	ut_assert(!malloc_slab_owns(ptr));
+	for (i = 0; i < 24; i++)
+		ut_asserteq(i, ptr[i]);
+	free(ptr);
+
+	/* calloc() must clear a recycled object */
+	ptr = malloc(30);
+	ut_assertnonnull(ptr);
+	memset(ptr, '\xff', 30);
+	free(ptr);
+	ptr = calloc(3, 10);
+	ut_assertnonnull(ptr);
+	ut_assert(malloc_slab_owns(ptr));
+	for (i = 0; i < 30; i++)
+		ut_asserteq(0, ptr[i]);
+	free(ptr);
+
+	aligned = memalign(64, 32);
+	ut_assertnonnull(aligned);
+	ut_asserteq(0, (ulong)aligned & 63);
+	free(aligned);
+
+	/* In test mode, requests go to dlmalloc so that they are counted */
+	malloc_enable_testing(10);
+	ptr = malloc(16);
+	ut_assertnonnull(ptr);
+	ut_assert(!malloc_slab_owns(ptr));
+	free(ptr);
+	malloc_disable_testing();
+
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_slab, 0);
+
+/* Test that many objects are distinct and that freeing them releases pages */
+static int common_test_malloc_slab_many(struct unit_test_state *uts)
+{
+	ulong start = ut_check_free();
+	int *ptrs[SLAB_TEST_COUNT];
+	int i;
+
+	for (i = 0; i < SLAB_TEST_COUNT; i++) {
+		ptrs[i] = malloc(40);
+		ut_assertnonnull(ptrs[i]);
+		ut_assert(malloc_slab_owns(ptrs[i]));
+		ptrs[i][0] = i;
+		ptrs[i][9] = ~i;
+	}
+	for (i = 0; i < SLAB_TEST_COUNT; i++) {
+		ut_asserteq(i, ptrs[i][0]);
+		ut_asserteq(~i, ptrs[i][9]);
+	}
+
+	/* Free half, then reallocate them, then free everything */
+	for (i = 0; i < SLAB_TEST_COUNT; i += 2)
+		free(ptrs[i]);
+	for (i = 0; i < SLAB_TEST_COUNT; i += 2) {
+		ptrs[i] = malloc(33);
+		ut_assertnonnull(ptrs[i]);
+		ptrs[i][0] = i;
+	}
+	for (i = 0; i < SLAB_TEST_COUNT; i++)
+		ut_asserteq(i, ptrs[i][0]);
+	for (i = SLAB_TEST_COUNT - 1; i >= 0; i--)
+		free(ptrs[i]);
+
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_slab_many, 0);
+
+static ulong slab_bench(void **ptrs)
+{
+	ulong start = timer_get_us();
+	int i, j;
+
+	for (j = 0; j < 20; j++) {
+		for (i = 0; i < SLAB_TEST_COUNT; i++)
+			ptrs[i] = malloc(16 + (i % 16) * 24);
+		for (i = 0; i < SLAB_TEST_COUNT; i++)
+			free(ptrs[i]);
+	}
+
+	return timer_get_us() - start;
+}
+
+/* Compare the time taken for small allocations with and without the slab */
+static int common_test_malloc_slab_bench(struct unit_test_state *uts)
+{
+	void *ptrs[SLAB_TEST_COUNT];
+	ulong slab_us, dl_us;
+
+	slab_us = slab_bench(ptrs);
+
+	/* Test mode sends all requests to dlmalloc */
+	malloc_enable_testing(INT_MAX);
+	dl_us = slab_bench(ptrs);
+	malloc_disable_testing();
+
+	printf("%d small allocations: slab %lu us, dlmalloc %lu us\n",
+	       20 * SLAB_TEST_COUNT, slab_us, dl_us);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_slab_bench, 0);
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for asynchronous device probing
+ */
+
+#include <common.h>
+#include <cyclic.h>
+#include <dm.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Number of calls to the probe() method needed to complete the probe */
+#define ASYNC_PROBE_STEPS	3
+
+static int async_probe_count;
+
+static int testasync_probe(struct udevice *dev)
+{
+	if (++async_probe_count < ASYNC_PROBE_STEPS)
+		return -EINPROGRESS;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(testasync_drv) = {
+	.name	= "testasync_drv",
+	.id	= UCLASS_NOP,
+	.probe	= testasync_probe,
+	.flags	= DM_FLAG_PROBE_ASYNC,
+};
+
+/* Test that a pending probe is completed when the device is needed */
+static int dm_test_async_probe_wait(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(testasync_drv),
+				"async", NULL, ofnode_null(), &dev));
+	async_probe_count = 0;
+
+	ut_assertok(device_probe_async(dev));
+	ut_asserteq(1, async_probe_count);
+	ut_assert(dev_get_flags(dev) & DM_FLAG_PROBE_PENDING);
+
+	/* Starting it again should do nothing */
+	ut_assertok(device_probe_async(dev));
+	ut_asserteq(1, async_probe_count);
+
+	ut_assertok(device_probe(dev));
+	ut_asserteq(ASYNC_PROBE_STEPS, async_probe_count);
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev));
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_async_probe_wait, 0);
+
+/* Test that a pending probe is completed in the background */
+static int dm_test_async_probe_cyclic(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	int i;
+
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(testasync_drv),
+				"async", NULL, ofnode_null(), &dev));
+	async_probe_count = 0;
+
+	ut_assertok(device_probe_async(dev));
+	ut_assert(dev_get_flags(dev) & DM_FLAG_PROBE_PENDING);
+
+	for (i = 0; i < 10 && async_probe_count < ASYNC_PROBE_STEPS; i++) {
+		timer_test_add_offset(1);
+		schedule();
+	}
+	ut_asserteq(ASYNC_PROBE_STEPS, async_probe_count);
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev));
+
+	/* Nothing more to do */
+	ut_assertok(device_probe(dev));
+	ut_asserteq(ASYNC_PROBE_STEPS, async_probe_count);
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_async_probe_cyclic, 0);
+
+/* Test that removing a pending device waits for its probe to finish */
+static int dm_test_async_probe_remove(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(device_bind(dm_root(), DM_DRIVER_GET(testasync_drv),
+				"async", NULL, ofnode_null(), &dev));
+	async_probe_count = 0;
+
+	ut_assertok(device_probe_async(dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_asserteq(ASYNC_PROBE_STEPS, async_probe_count);
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_PROBE_PENDING));
+	ut_assert(!device_active(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_async_probe_remove, 0);
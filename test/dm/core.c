@@ -1263,6 +1263,59 @@ static int dm_test_uclass_find_device(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_find_device, UT_TESTF_SCAN_FDT);
 
+/* Test that the uclass and device indexes are kept up to date */
+static int dm_test_uclass_index(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	struct uclass *uc;
+
+	if (!CONFIG_IS_ENABLED(DM_UCLASS_INDEX))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get(UCLASS_I2C, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_I2C));
+
+	/* Look up each device twice, so the second hits the index */
+	uclass_foreach_dev(dev, uc) {
+		ut_assertok(uclass_find_device_by_seq(UCLASS_I2C, dev_seq(dev),
+						      &found));
+		ut_asserteq_ptr(dev, found);
+		ut_assertok(uclass_find_device_by_seq(UCLASS_I2C, dev_seq(dev),
+						      &found));
+		ut_asserteq_ptr(dev, found);
+		ut_assertok(uclass_find_device_by_name(UCLASS_I2C, dev->name,
+						       &found));
+		ut_asserteq_ptr(dev, found);
+		ut_assertok(uclass_find_device_by_name(UCLASS_I2C, dev->name,
+						       &found));
+		ut_asserteq_ptr(dev, found);
+	}
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_I2C, 1000,
+						       &found));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_I2C, -2, &found));
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_I2C, "fred",
+							&found));
+
+	/* Renaming a device must update the name index */
+	ut_assertok(uclass_first_device_err(UCLASS_I2C, &dev));
+	ut_assertok(device_set_name(dev, "fred"));
+	ut_assertok(uclass_find_device_by_name(UCLASS_I2C, "fred", &found));
+	ut_asserteq_ptr(dev, found);
+
+	/* Unbinding a device must remove it from the indexes */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_I2C, "fred",
+							&found));
+
+	/* Destroying the uclass must remove it from the index */
+	ut_assertok(uclass_destroy(uc));
+	ut_assertnull(uclass_find(UCLASS_I2C));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_index, UT_TESTF_SCAN_FDT);
+
 /* Test getting information about tags attached to devices */
 static int dm_test_dev_get_attach(struct unit_test_state *uts)
 {
@@ -703,3 +703,151 @@ static int dm_test_process_ra(struct unit_test_state *uts)
 DM_TEST(dm_test_process_ra, 0);
 
 #endif
+
+static struct net_timer test_timers[3];
+static char test_timer_order[8];
+
+static void test_timer_func(struct net_timer *timer)
+{
+	int len = strlen(test_timer_order);
+
+	test_timer_order[len] = 'a' + (timer - test_timers);
+	test_timer_order[len + 1] = '\0';
+}
+
+/* Test that net timers fire in order of expiry and can be stopped */
+static int dm_test_net_timer(struct unit_test_state *uts)
+{
+	int i;
+
+	memset(test_timers, '\0', sizeof(test_timers));
+	test_timer_order[0] = '\0';
+	for (i = 0; i < ARRAY_SIZE(test_timers); i++)
+		test_timers[i].func = test_timer_func;
+
+	net_timer_start(&test_timers[0], 20);
+	net_timer_start(&test_timers[1], 10);
+	net_timer_start(&test_timers[2], 30);
+	ut_assert(net_timer_pending(&test_timers[2]));
+	net_timer_stop(&test_timers[2]);
+	ut_assert(!net_timer_pending(&test_timers[2]));
+
+	/* Nothing has expired yet */
+	net_timer_run();
+	ut_asserteq_str("", test_timer_order);
+
+	timer_test_add_offset(15);
+	net_timer_run();
+	ut_asserteq_str("b", test_timer_order);
+	ut_assert(!net_timer_pending(&test_timers[1]));
+
+	/* Restarting a pending timer moves it */
+	net_timer_start(&test_timers[1], 1);
+	net_timer_start(&test_timers[0], 10);
+	timer_test_add_offset(5);
+	net_timer_run();
+	ut_asserteq_str("bb", test_timer_order);
+	ut_assert(net_timer_pending(&test_timers[0]));
+
+	timer_test_add_offset(10);
+	net_timer_run();
+	ut_asserteq_str("bba", test_timer_order);
+	ut_assert(!net_timer_pending(&test_timers[0]));
+
+	return 0;
+}
+DM_TEST(dm_test_net_timer, 0);
+
+#if IS_ENABLED(CONFIG_IP_DEFRAG)
+#define DEFRAG_TEST_LEN		2000	/* UDP payload of each datagram */
+#define DEFRAG_TEST_FRAG	1000	/* IP payload of each fragment */
+
+static int defrag_test_count;
+static uchar defrag_test_data[2][DEFRAG_TEST_LEN];
+
+static void defrag_test_handler(uchar *pkt, unsigned int dport,
+				struct in_addr sip, unsigned int sport,
+				unsigned int len)
+{
+	if (len == DEFRAG_TEST_LEN && sport == 1234 && dport < 2)
+		memcpy(defrag_test_data[dport], pkt, len);
+	defrag_test_count++;
+}
+
+/* Receive fragment @frag of a UDP datagram sent to port @port */
+static void defrag_test_recv(int port, int frag)
+{
+	uchar pkt[ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + DEFRAG_TEST_LEN];
+	struct ethernet_hdr *eth = (struct ethernet_hdr *)pkt;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+	uchar *data = (uchar *)ip + IP_HDR_SIZE;
+	int i, start, len;
+
+	memcpy(eth->et_dest, net_ethaddr, ARP_HLEN);
+	memset(eth->et_src, '\x22', ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	/* Build the whole datagram and then cut out the fragment */
+	memset(ip, '\0', IP_UDP_HDR_SIZE);
+	ip->udp_src = htons(1234);
+	ip->udp_dst = htons(port);
+	ip->udp_len = htons(UDP_HDR_SIZE + DEFRAG_TEST_LEN);
+	for (i = 0; i < DEFRAG_TEST_LEN; i++)
+		data[UDP_HDR_SIZE + i] = i * (port + 1);
+	start = frag * DEFRAG_TEST_FRAG;
+	len = min_t(int, DEFRAG_TEST_FRAG,
+		    UDP_HDR_SIZE + DEFRAG_TEST_LEN - start);
+	memmove(data, data + start, len);
+
+	ip->ip_hl_v = 0x45;
+	ip->ip_len = htons(IP_HDR_SIZE + len);
+	ip->ip_id = htons(0x100 + port);
+	ip->ip_off = htons(start / 8 | (start + len <
+		UDP_HDR_SIZE + DEFRAG_TEST_LEN ? IP_FLAGS_MFRAG : 0));
+	ip->ip_ttl = 64;
+	ip->ip_p = IPPROTO_UDP;
+	net_write_ip(&ip->ip_src, string_to_ip("1.1.2.4"));
+	net_write_ip(&ip->ip_dst, net_ip);
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + IP_HDR_SIZE + len);
+}
+
+/* Test reassembling two datagrams whose fragments arrive interleaved */
+static int dm_test_net_defrag(struct unit_test_state *uts)
+{
+	struct in_addr old_ip = net_ip;
+	uchar expect[DEFRAG_TEST_LEN];
+	int i;
+
+	if (CONFIG_NET_DEFRAG_SLOTS < 2)
+		return -EAGAIN;
+
+	net_ip = string_to_ip("1.1.2.2");
+	net_set_udp_handler(defrag_test_handler);
+	defrag_test_count = 0;
+	memset(defrag_test_data, '\0', sizeof(defrag_test_data));
+
+	defrag_test_recv(0, 0);
+	defrag_test_recv(1, 2);
+	defrag_test_recv(1, 0);
+	defrag_test_recv(0, 2);
+	ut_asserteq(0, defrag_test_count);
+	defrag_test_recv(0, 1);
+	ut_asserteq(1, defrag_test_count);
+	defrag_test_recv(1, 1);
+	ut_asserteq(2, defrag_test_count);
+	net_set_udp_handler(NULL);
+	net_ip = old_ip;
+
+	for (i = 0; i < DEFRAG_TEST_LEN; i++)
+		expect[i] = i;
+	ut_asserteq_mem(expect, defrag_test_data[0], DEFRAG_TEST_LEN);
+	for (i = 0; i < DEFRAG_TEST_LEN; i++)
+		expect[i] = i * 2;
+	ut_asserteq_mem(expect, defrag_test_data[1], DEFRAG_TEST_LEN);
+
+	return 0;
+}
+DM_TEST(dm_test_net_defrag, 0);
+#endif
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test for loading a file over NFS, using an NFSv3 responder attached to the
+ * sandbox Ethernet driver
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include "../../net/nfs.h"
+
+#define NFS_TEST_MOUNT_PORT	635
+#define NFS_TEST_NFS_PORT	2049
+#define NFS_TEST_ADDR		0x1000000
+
+/* The file ends part-way through a block */
+#define NFS_TEST_SIZE		(5 * CONFIG_NFS_READ_SIZE + 100)
+
+/* Offset of the block whose first READ request is lost */
+#define NFS_TEST_DROP_OFS	(2 * CONFIG_NFS_READ_SIZE)
+
+static u8 nfs_test_file[NFS_TEST_SIZE];
+
+/**
+ * struct nfs_test_priv - state of the NFS responder
+ *
+ * @held_xid: RPC id of the first READ request, whose reply is held back until
+ *	the next READ request arrives, or 0 if none
+ * @swapped: true if the replies to the first two READ requests were swapped
+ * @drop_xid: RPC id of the READ request which was lost, or 0 if none
+ * @resent: true if the lost READ request was resent with the same RPC id
+ */
+struct nfs_test_priv {
+	u32 held_xid;
+	bool swapped;
+	u32 drop_xid;
+	bool resent;
+};
+
+/*
+ * sb_nfs_send_reply()
+ *
+ * Inject a reply to the RPC call in @packet, with @count words of data after
+ * the RPC header
+ *
+ * returns 0 if injected, -ENOSPC if the receive buffers are full
+ */
+static int sb_nfs_send_reply(struct udevice *dev, void *packet, u32 xid,
+			     const u32 *data, int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	u32 hdr[6];
+	int len;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return -ENOSPC;
+
+	hdr[0] = xid;
+	hdr[1] = htonl(MSG_REPLY);
+	hdr[2] = 0;	/* accepted */
+	hdr[3] = 0;	/* AUTH_NONE verifier */
+	hdr[4] = 0;
+	hdr[5] = 0;	/* success */
+	len = sizeof(hdr) + count * sizeof(u32);
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv, packet, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE);
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	net_copy_ip(&ipr->ip_dst, &ip->ip_src);
+	net_copy_ip(&ipr->ip_src, &ip->ip_dst);
+	ipr->ip_len = htons(IP_UDP_HDR_SIZE + len);
+	ipr->ip_off = 0;
+	ipr->ip_sum = 0;
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+	ipr->udp_src = ip->udp_dst;
+	ipr->udp_dst = ip->udp_src;
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE, hdr, sizeof(hdr));
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE + sizeof(hdr), data,
+	       count * sizeof(u32));
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Reply to a READ request for @count bytes at @offset */
+static int sb_nfs_read_reply(struct udevice *dev, void *packet, u32 xid,
+			     ulong offset, uint count)
+{
+	u32 data[5 + CONFIG_NFS_READ_SIZE / sizeof(u32)];
+
+	if (offset >= NFS_TEST_SIZE)
+		count = 0;
+	count = min_t(uint, count, NFS_TEST_SIZE - offset);
+	count = min_t(uint, count, CONFIG_NFS_READ_SIZE);
+	data[0] = 0;		/* NFS3_OK */
+	data[1] = 0;		/* no attributes */
+	data[2] = htonl(count);
+	data[3] = htonl(offset + count == NFS_TEST_SIZE);
+	data[4] = htonl(count);
+	memcpy(&data[5], nfs_test_file + offset, count);
+
+	return sb_nfs_send_reply(dev, packet, xid, data,
+				 5 + DIV_ROUND_UP(count, sizeof(u32)));
+}
+
+static int sb_nfs_handler(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct nfs_test_priv *test_priv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u32 call[64], data[16];
+	u32 *args, xid, prog, proc;
+	ulong offset;
+	uint count;
+	int ret;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	/* Copy the call so that it is aligned */
+	memset(call, '\0', sizeof(call));
+	memcpy(call, (void *)ip + IP_UDP_HDR_SIZE,
+	       min_t(uint, len - ETHER_HDR_SIZE - IP_UDP_HDR_SIZE,
+		     sizeof(call)));
+	xid = call[0];
+
+	/* Skip the credential and the verifier */
+	args = &call[6];
+	args += 2 + DIV_ROUND_UP(ntohl(args[1]), 4);
+	args += 2 + DIV_ROUND_UP(ntohl(args[1]), 4);
+
+	prog = ntohl(call[3]);
+	proc = ntohl(call[5]);
+	if (prog == PROG_PORTMAP && proc == PORTMAP_GETPORT) {
+		data[0] = htonl(ntohl(args[0]) == PROG_MOUNT ?
+				NFS_TEST_MOUNT_PORT : NFS_TEST_NFS_PORT);
+		return sb_nfs_send_reply(dev, packet, xid, data, 1);
+	} else if (prog == PROG_MOUNT && proc == MOUNT_ADDENTRY) {
+		/* Status and an empty directory handle */
+		count = 1 + NFS_FHSIZE / sizeof(u32);
+		memset(data, '\0', count * sizeof(u32));
+		return sb_nfs_send_reply(dev, packet, xid, data, count);
+	} else if (prog == PROG_MOUNT && proc == MOUNT_UMOUNTALL) {
+		return sb_nfs_send_reply(dev, packet, xid, data, 0);
+	} else if (prog == PROG_NFS && proc == NFS3PROC_LOOKUP) {
+		data[0] = 0;
+		data[1] = htonl(8);	/* file handle */
+		data[2] = htonl(0x12345678);
+		data[3] = htonl(0x9abcdef0);
+		return sb_nfs_send_reply(dev, packet, xid, data, 4);
+	} else if (prog != PROG_NFS || proc != NFS_READ) {
+		return 0;
+	}
+
+	/* The arguments of the READ are the file handle, offset and count */
+	args += 1 + DIV_ROUND_UP(ntohl(args[0]), 4);
+	offset = ntohl(args[1]);
+	count = ntohl(args[2]);
+
+	/* Hold back the first reply so that the replies arrive out of order */
+	if (!offset && !test_priv->held_xid) {
+		test_priv->held_xid = xid;
+		return 0;
+	}
+	if (offset == NFS_TEST_DROP_OFS) {
+		if (!test_priv->drop_xid) {
+			/* Lose this one and skip ahead to its timeout */
+			test_priv->drop_xid = xid;
+			sandbox_eth_skip_timeout();
+			return 0;
+		}
+		if (xid == test_priv->drop_xid)
+			test_priv->resent = true;
+	}
+
+	ret = sb_nfs_read_reply(dev, packet, xid, offset, count);
+	if (!ret && test_priv->held_xid && !test_priv->swapped) {
+		ret = sb_nfs_read_reply(dev, packet, test_priv->held_xid, 0,
+					count);
+		test_priv->swapped = !ret;
+	}
+	if (ret) {
+		/* Treat a full queue like a lost packet */
+		sandbox_eth_skip_timeout();
+	}
+
+	return 0;
+}
+
+/* Test loading a file, with replies out of order and a lost request */
+static int dm_test_nfs(struct unit_test_state *uts)
+{
+	struct nfs_test_priv test_priv;
+	void *buf;
+	int i;
+
+	memset(&test_priv, '\0', sizeof(test_priv));
+	for (i = 0; i < NFS_TEST_SIZE; i++)
+		nfs_test_file[i] = i ^ (i >> 8);
+
+	sandbox_eth_set_tx_handler(0, sb_nfs_handler);
+	sandbox_eth_set_priv(0, &test_priv);
+	env_set("ethact", "eth@10002000");
+	ut_assertok(run_commandf("nfs %x 1.1.2.1:/export/test.bin",
+				 NFS_TEST_ADDR));
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(NFS_TEST_SIZE, env_get_hex("filesize", 0));
+	buf = map_sysmem(NFS_TEST_ADDR, NFS_TEST_SIZE);
+	ut_asserteq_mem(nfs_test_file, buf, NFS_TEST_SIZE);
+	unmap_sysmem(buf);
+
+	ut_assert(test_priv.swapped);
+	ut_assert(test_priv.resent);
+
+	return 0;
+}
+DM_TEST(dm_test_nfs, UT_TESTF_SCAN_FDT);
@@ -7,8 +7,10 @@
 #include <common.h>
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
 #include <search.h>
 #include <stdio.h>
+#include <time.h>
 #include <test/env.h>
 #include <test/ut.h>
 
@@ -124,3 +126,140 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+static int htab_walk_count;
+
+/* Check that entries are visited in the order in which they were created */
+static int htab_check_order(struct env_entry *entry)
+{
+	char key[20];
+
+	sprintf(key, "%d", htab_walk_count++);
+
+	return strcmp(key, entry->key) ? -EINVAL : 0;
+}
+
+/* Add many more entries than the table was created for */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	ulong start = ut_check_free();
+	struct hsearch_data htab;
+	char *res = NULL;
+	char key[20];
+	ssize_t len;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 16));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 16));
+	ut_asserteq(SIZE * 16, htab.filled);
+	ut_asserteq(SIZE * 16, htab.size);
+
+	htab_walk_count = 0;
+	ut_assertok(hwalk_r(&htab, htab_check_order));
+	ut_asserteq(SIZE * 16, htab_walk_count);
+
+	/* Export is still sorted: "0", "1", "10", "100", "101" ... */
+	len = hexport_r(&htab, '\n', 0, &res, 0, 0, NULL);
+	ut_assert(len > 0);
+	ut_asserteq_mem("0=0\n1=1\n10=10\n100=100\n101=101\n", res, 30);
+	free(res);
+
+	/* Delete the odd entries and check that the rest are intact */
+	for (i = 1; i < SIZE * 16; i += 2) {
+		sprintf(key, "%d", i);
+		ut_assertok(hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(SIZE * 8, htab.filled);
+	for (i = 0; i < SIZE * 16; i++) {
+		struct env_entry item, *ritem;
+
+		sprintf(key, "%d", i);
+		item.key = key;
+		ut_asserteq(i & 1 ? 0 : 1, !!hsearch_r(item, ENV_FIND, &ritem,
+						       &htab, 0));
+	}
+
+	hdestroy_r(&htab);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Check that deleted entries are squeezed out rather than growing */
+static int env_test_htab_compact(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+	char key[20];
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+	ut_assertok(htab_fill(uts, &htab, SIZE));
+
+	/* Deleting from the start leaves holes */
+	for (i = 0; i < SIZE / 2; i++) {
+		sprintf(key, "%d", i);
+		ut_assertok(hdelete_r(key, &htab, 0));
+	}
+	ut_asserteq(SIZE / 2, htab.filled);
+	ut_asserteq(SIZE, htab.used);
+
+	/* The next new entry reuses them */
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = "new";
+	item.data = "value";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(SIZE, htab.size);
+	ut_asserteq(SIZE / 2 + 1, htab.used);
+
+	/* The remaining entries are intact and still in order */
+	for (i = SIZE / 2; i < SIZE; i++) {
+		sprintf(key, "%d", i);
+		item.key = key;
+		ut_asserteq(i - SIZE / 2 + 1,
+			    hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+		ut_asserteq_str(key, ritem->data);
+	}
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_htab_compact, 0);
+
+#define BENCH_SIZE	2000
+
+/* Measure the time taken to fill a table and look up each entry */
+static int env_test_htab_bench(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	ulong fill_us, find_us;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(CONFIG_ENV_MIN_ENTRIES, &htab));
+
+	fill_us = timer_get_us();
+	ut_assertok(htab_fill(uts, &htab, BENCH_SIZE));
+	fill_us = timer_get_us() - fill_us;
+
+	find_us = timer_get_us();
+	for (i = 0; i < 10; i++)
+		ut_assertok(htab_check_fill(uts, &htab, BENCH_SIZE));
+	find_us = timer_get_us() - find_us;
+
+	printf("%d entries: fill %lu us, %d lookups %lu us\n", BENCH_SIZE,
+	       fill_us, 10 * BENCH_SIZE, find_us);
+	ut_asserteq(BENCH_SIZE, htab.filled);
+
+	hdestroy_r(&htab);
+
+	return 0;
+}
+ENV_TEST(env_test_htab_bench, 0);
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the index used by env_get_f()
+ */
+
+#include <common.h>
+#include <console.h>
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static const char test_env[] =
+	"baudrate=115200\0"
+	"serial#=1234\0"
+	"ethaddr=00:11:22:33:44:55\0"
+	"eth=1\0"
+	"baudrate=9600\0"
+	"noequals\0"
+	"long=0123456789012345678901234567890123456789\0";
+
+/* Test looking up variables with the index */
+static int env_test_index(struct unit_test_state *uts)
+{
+	ulong old_addr = gd->env_addr;
+	ulong old_valid = gd->env_valid;
+	ulong start = ut_check_free();
+	struct env_index *idx;
+	char buf[32];
+
+	env_drop_index();
+	gd->env_addr = (ulong)test_env;
+	gd->env_valid = ENV_VALID;
+
+	/* As with a linear scan, the first of any duplicates is used */
+	ut_asserteq(6, env_get_f("baudrate", buf, sizeof(buf)));
+	ut_asserteq_str("115200", buf);
+	idx = gd_env_index();
+	ut_assertnonnull(idx);
+	ut_asserteq_ptr(test_env, idx->env);
+	ut_asserteq(5, idx->count);
+
+	ut_asserteq(1, env_get_f("eth", buf, sizeof(buf)));
+	ut_asserteq_str("1", buf);
+	ut_asserteq(17, env_get_f("ethaddr", buf, sizeof(buf)));
+	ut_asserteq_str("00:11:22:33:44:55", buf);
+	ut_asserteq(4, env_get_f("serial#", buf, sizeof(buf)));
+	ut_asserteq_str("1234", buf);
+
+	ut_asserteq(-1, env_get_f("ethaddr1", buf, sizeof(buf)));
+	ut_asserteq(-1, env_get_f("eth1", buf, sizeof(buf)));
+	ut_asserteq(-1, env_get_f("noequals", buf, sizeof(buf)));
+	ut_asserteq(-1, env_get_f("", buf, sizeof(buf)));
+	ut_asserteq(-1, env_get_f(NULL, buf, sizeof(buf)));
+
+	/* A value which does not fit is truncated */
+	console_record_reset_enable();
+	ut_asserteq(40, env_get_f("long", buf, sizeof(buf)));
+	ut_asserteq(sizeof(buf) - 1, strlen(buf));
+	ut_assert_nextline("env_buf [32 bytes] too small for value of \"long\"");
+	ut_assert_console_end();
+
+	/* The index is rebuilt when the environment moves */
+	gd->env_addr = old_addr;
+	gd->env_valid = old_valid;
+	env_get_f("baudrate", buf, sizeof(buf));
+	idx = gd_env_index();
+	ut_assertnonnull(idx);
+	ut_assert(idx->env != test_env);
+
+	env_drop_index();
+	ut_assertnull(gd_env_index());
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+ENV_TEST(env_test_index, UT_TESTF_CONSOLE_REC);
+
+/* Test that an environment which cannot be indexed is only tried once */
+static int env_test_index_fail(struct unit_test_state *uts)
+{
+	ulong old_addr = gd->env_addr;
+	ulong old_valid = gd->env_valid;
+	char buf[32];
+	char *env;
+
+	/* A variable which runs past the end cannot be indexed */
+	env = calloc(1, CONFIG_ENV_SIZE + 2);
+	ut_assertnonnull(env);
+	memset(env, 'a', CONFIG_ENV_SIZE);
+
+	env_drop_index();
+	gd->env_addr = (ulong)env;
+	gd->env_valid = ENV_VALID;
+	ut_asserteq(-1, env_get_f("baudrate", buf, sizeof(buf)));
+	ut_assertnull(gd_env_index());
+	ut_asserteq_ptr(env, gd_env_index_fail());
+
+	/* An environment which can be indexed is still tried */
+	gd->env_addr = (ulong)test_env;
+	ut_asserteq(6, env_get_f("baudrate", buf, sizeof(buf)));
+	ut_assertnonnull(gd_env_index());
+
+	env_drop_index();
+	ut_assertnull(gd_env_index_fail());
+	gd->env_addr = old_addr;
+	gd->env_valid = old_valid;
+	free(env);
+
+	return 0;
+}
+ENV_TEST(env_test_index_fail, 0);
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the environment journal
+ */
+
+#include <common.h>
+#include <env_journal.h>
+#include <malloc.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+/* Size of each journal area, small enough to fill up quickly */
+#define AREA_SIZE	0x400
+
+/* Emulated NOR flash holding both areas */
+static u8 test_flash[2 * AREA_SIZE];
+
+static int flash_read(struct env_journal *jnl, ulong offset, ulong size,
+		      void *buf)
+{
+	memcpy(buf, test_flash + offset, size);
+
+	return 0;
+}
+
+/* Like NOR flash, writing can only clear bits */
+static int flash_write(struct env_journal *jnl, ulong offset, ulong size,
+		       const void *buf)
+{
+	const u8 *src = buf;
+	ulong i;
+
+	for (i = 0; i < size; i++) {
+		if ((test_flash[offset + i] & src[i]) != src[i])
+			return -EIO;
+		test_flash[offset + i] &= src[i];
+	}
+
+	return 0;
+}
+
+static int flash_erase(struct env_journal *jnl, ulong offset, ulong size)
+{
+	memset(test_flash + offset, '\xff', size);
+
+	return 0;
+}
+
+static void setup_journal(struct env_journal *jnl)
+{
+	memset(jnl, '\0', sizeof(*jnl));
+	jnl->read = flash_read;
+	jnl->write = flash_write;
+	jnl->erase = flash_erase;
+	jnl->size = AREA_SIZE;
+}
+
+/* Set up an environment from a list of nul-terminated entries */
+static void set_env(env_t *env, const char *list, int size)
+{
+	memset(env, '\0', sizeof(*env));
+	memcpy(env->data, list, size);
+}
+
+/* Check that reading the journal gives the expected environment */
+static int check_load(struct unit_test_state *uts, const env_t *env,
+		      bool compact)
+{
+	struct env_journal jnl;
+
+	setup_journal(&jnl);
+	ut_assertok(env_journal_load(&jnl));
+	ut_asserteq_mem(env->data, jnl.env->data, ENV_SIZE);
+	ut_asserteq(compact, jnl.compact);
+	env_journal_uninit(&jnl);
+
+	return 0;
+}
+
+#define SET_ENV(env, list)	set_env(env, list, sizeof(list))
+
+/* Test saving and loading, with appended records */
+static int env_test_journal(struct unit_test_state *uts)
+{
+	ulong start = ut_check_free();
+	struct env_journal jnl;
+	env_t *env;
+	ulong used;
+
+	env = malloc(sizeof(*env));
+	ut_assertnonnull(env);
+	memset(test_flash, '\xff', sizeof(test_flash));
+	setup_journal(&jnl);
+	ut_asserteq(-ENOENT, env_journal_load(&jnl));
+
+	/* The first save writes the whole environment */
+	SET_ENV(env, "arch=sandbox\0baudrate=115200\0bootcount=0\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(1, jnl.compactions);
+	ut_asserteq(0, jnl.appends);
+	ut_assertok(check_load(uts, env, false));
+
+	/* Changing a variable appends just that variable */
+	used = jnl.used;
+	SET_ENV(env, "arch=sandbox\0baudrate=115200\0bootcount=1\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(1, jnl.appends);
+	ut_asserteq(used + sizeof(struct env_journal_rec) +
+		    sizeof("bootcount=1"), jnl.used);
+	ut_assertok(check_load(uts, env, false));
+
+	/* Add one variable and delete another */
+	SET_ENV(env, "arch=sandbox\0bootcount=1\0fdtfile=test.dtb\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(2, jnl.appends);
+	ut_assertok(check_load(uts, env, false));
+
+	/* Saving again with no changes writes nothing */
+	used = jnl.used;
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(2, jnl.appends);
+	ut_asserteq(used, jnl.used);
+	ut_asserteq(1, jnl.compactions);
+
+	env_journal_uninit(&jnl);
+	free(env);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+ENV_TEST(env_test_journal, 0);
+
+/* Test compaction when the journal fills up or is corrupted */
+static int env_test_journal_compact(struct unit_test_state *uts)
+{
+	ulong start = ut_check_free();
+	struct env_journal jnl;
+	char list[40];
+	env_t *env;
+	int i, len;
+
+	env = malloc(sizeof(*env));
+	ut_assertnonnull(env);
+	memset(test_flash, '\xff', sizeof(test_flash));
+	setup_journal(&jnl);
+	SET_ENV(env, "arch=sandbox\0bootcount=0\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(0, jnl.active);
+
+	/* Count boots until the first area fills up */
+	for (i = 1; jnl.compactions == 1; i++) {
+		ut_assert(i < AREA_SIZE / 16);
+		len = snprintf(list, sizeof(list), "arch=sandbox%cbootcount=%d",
+			       0, i);
+		set_env(env, list, len + 1);
+		ut_assertok(env_journal_save(&jnl, env));
+	}
+	ut_asserteq(2, jnl.compactions);
+	ut_asserteq(1, jnl.active);
+	ut_assertok(check_load(uts, env, false));
+
+	/* Simulate a save which was interrupted part-way through */
+	SET_ENV(env, "arch=sandbox\0bootcount=999\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	test_flash[AREA_SIZE + jnl.used - 4] = 0;
+	set_env(env, list, len + 1);
+	ut_assertok(check_load(uts, env, true));
+
+	/* The next save must compact, since the area ends with garbage */
+	env_journal_uninit(&jnl);
+	setup_journal(&jnl);
+	ut_assertok(env_journal_load(&jnl));
+	SET_ENV(env, "arch=sandbox\0bootcount=1000\0");
+	ut_assertok(env_journal_save(&jnl, env));
+	ut_asserteq(1, jnl.compactions);
+	ut_asserteq(0, jnl.active);
+	ut_assertok(check_load(uts, env, false));
+
+	/* If the header of the new area is lost, the old one is used */
+	test_flash[0] = 0;
+	set_env(env, list, len + 1);
+	ut_assertok(check_load(uts, env, true));
+
+	env_journal_uninit(&jnl);
+	free(env);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+ENV_TEST(env_test_journal_compact, 0);
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tests for the cache of parsed commands in the hush old parser
+ */
+
+#include <cli_hush.h>
+#include <command.h>
+#include <env.h>
+#include <time.h>
+#include <test/hush.h>
+#include <test/ut.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Check that cached commands give the same results as parsed ones */
+static int hush_test_cache(struct unit_test_state *uts)
+{
+	struct hush_cache_stats before, after;
+	int i;
+
+	if (!(gd->flags & GD_FLG_HUSH_OLD_PARSER))
+		return -EAGAIN;
+
+	hush_cache_flush();
+	ut_assertok(env_set("cache_cmd",
+			    "for cache_i in a b; do echo $cache_i$cache_v; done"));
+	console_record_reset_enable();
+	hush_cache_get_stats(&before);
+	for (i = 0; i < 3; i++) {
+		/* A changed variable must be seen, even with a cached tree */
+		ut_assertok(env_set_ulong("cache_v", i));
+		ut_assertok(run_command("run cache_cmd", 0));
+		ut_assert_nextline("a%d", i);
+		ut_assert_nextline("b%d", i);
+	}
+	ut_assert_console_end();
+	hush_cache_get_stats(&after);
+	ut_assert(after.hits >= before.hits + 4);
+
+	/* Return codes are the same when run from the cache */
+	ut_asserteq(1, run_command("false || false", 0));
+	ut_asserteq(1, run_command("false || false", 0));
+	ut_assertok(run_command("false || true", 0));
+
+	ut_assertok(env_set("cache_cmd", NULL));
+	ut_assertok(env_set("cache_v", NULL));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache, 0);
+
+#define BENCH_COUNT	200
+
+static ulong hush_bench(void)
+{
+	ulong start = timer_get_us();
+	int i;
+
+	for (i = 0; i < BENCH_COUNT; i++) {
+		run_command("run cache_bench", 0);
+		hush_cache_flush();
+	}
+
+	return timer_get_us() - start;
+}
+
+/* Compare the time taken to run a script with and without the cache */
+static int hush_test_cache_bench(struct unit_test_state *uts)
+{
+	ulong cached_us, parsed_us, start;
+	int i;
+
+	if (!(gd->flags & GD_FLG_HUSH_OLD_PARSER))
+		return -EAGAIN;
+
+	ut_assertok(env_set("cache_bench",
+			    "for cache_i in 1 2 3 4; do "
+			    "if test $cache_i -gt 2 && test -n \"$cache_i\"; "
+			    "then setexpr cache_j $cache_i + 1; fi; done"));
+
+	/* Every run must parse the script */
+	parsed_us = hush_bench();
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_COUNT; i++)
+		run_command("run cache_bench", 0);
+	cached_us = timer_get_us() - start;
+
+	printf("%d runs: parsed %lu us, cached %lu us\n", BENCH_COUNT,
+	       parsed_us, cached_us);
+
+	ut_assertok(env_set("cache_bench", NULL));
+	ut_assertok(env_set("cache_j", NULL));
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_bench, 0);
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Number of strings to allocate when comparing against malloc() */
+#define ARENA_TEST_COUNT	200
+
+/* Test basic allocation and freeing */
+static int lib_test_arena_alloc(struct unit_test_state *uts)
+{
+	struct arena *arena;
+	char *s, *t, *big;
+	ulong start;
+	int *vals;
+	int i;
+
+	start = ut_check_free();
+	arena = arena_new(0x200);
+	ut_assertnonnull(arena);
+	ut_asserteq(1, arena->chunks);
+
+	s = arena_strdup(arena, "hello");
+	ut_asserteq_str("hello", s);
+	t = arena_strndup(arena, "goodbye", 4);
+	ut_asserteq_str("good", t);
+	ut_asserteq_str("hello", s);
+	ut_assertnull(arena_strdup(arena, NULL));
+
+	/* Allocations are aligned like malloc() */
+	ut_asserteq(0, (ulong)t & (2 * sizeof(void *) - 1));
+
+	vals = arena_zalloc(arena, 10 * sizeof(int));
+	ut_assertnonnull(vals);
+	for (i = 0; i < 10; i++)
+		ut_asserteq(0, vals[i]);
+	ut_asserteq(3, arena->count);
+	ut_asserteq(1, arena->chunks);
+
+	/* A large allocation gets a chunk of its own */
+	big = arena_alloc(arena, 0x1000);
+	ut_assertnonnull(big);
+	memset(big, '\xff', 0x1000);
+	ut_asserteq(2, arena->chunks);
+	ut_asserteq_str("hello", s);
+
+	arena_free(arena);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_alloc, 0);
+
+/* Test rolling back to a mark and resetting */
+static int lib_test_arena_rollback(struct unit_test_state *uts)
+{
+	struct arena_mark mark;
+	struct arena *arena;
+	char *s, *t, *first;
+	ulong start;
+	int i;
+
+	start = ut_check_free();
+	arena = arena_new(0x100);
+	ut_assertnonnull(arena);
+
+	s = arena_strdup(arena, "keep");
+	arena_mark(arena, &mark);
+
+	/* Fill a few chunks, then discard them */
+	first = arena_strdup(arena, "discard");
+	for (i = 0; i < 100; i++)
+		ut_assertnonnull(arena_strdup(arena, "discard this string"));
+	ut_asserteq(102, arena->count);
+	ut_assert(arena->chunks > 1);
+
+	arena_rollback(arena, &mark);
+	ut_asserteq(1, arena->count);
+	ut_asserteq(1, arena->chunks);
+	ut_asserteq_str("keep", s);
+
+	/* The next allocation reuses the space */
+	t = arena_strdup(arena, "next");
+	ut_asserteq_ptr(first, t);
+	ut_asserteq_str("keep", s);
+
+	arena_reset(arena);
+	ut_asserteq(0, arena->count);
+	ut_asserteq(1, arena->chunks);
+	ut_asserteq_ptr(s, arena_strdup(arena, "again"));
+
+	arena_free(arena);
+	arena_free(NULL);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_rollback, 0);
+
+/* Test that an arena needs far fewer calls to malloc() than separate strings */
+static int lib_test_arena_count(struct unit_test_state *uts)
+{
+	struct arena *arena;
+	ulong start;
+	int i;
+
+	start = ut_check_free();
+	arena = arena_new(0);
+	ut_assertnonnull(arena);
+	for (i = 0; i < ARENA_TEST_COUNT; i++)
+		ut_assertnonnull(arena_strdup(arena, "console=ttyS0,115200"));
+	ut_asserteq(ARENA_TEST_COUNT, arena->count);
+	ut_assert(arena->mallocs < ARENA_TEST_COUNT / 10);
+
+	/* Memory runs out part-way through, without leaking */
+	arena_reset(arena);
+	malloc_enable_testing(0);
+	for (i = 0; arena_strdup(arena, "console=ttyS0,115200"); i++)
+		;
+	malloc_disable_testing();
+	ut_assert(i > 0);
+	ut_asserteq(1, arena->chunks);
+
+	arena_free(arena);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_count, 0);
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for writing Android sparse images
+ */
+
+#include <common.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define BLKSZ		512
+#define DEV_BLKS	64
+#define PART_START	4
+
+/**
+ * struct sparse_test_dev - emulated block device
+ *
+ * @data: Contents of the device
+ * @writes: Number of calls to write()
+ * @erases: Number of calls to erase()
+ * @erase_blk: First block of the last erase
+ * @erase_cnt: Number of blocks in the last erase
+ */
+struct sparse_test_dev {
+	u8 data[DEV_BLKS * BLKSZ];
+	int writes;
+	int erases;
+	lbaint_t erase_blk;
+	lbaint_t erase_cnt;
+};
+
+static lbaint_t test_write(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt, const void *buffer)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	memcpy(dev->data + blk * BLKSZ, buffer, blkcnt * BLKSZ);
+	dev->writes++;
+
+	return blkcnt;
+}
+
+static lbaint_t test_reserve(struct sparse_storage *info, lbaint_t blk,
+			     lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static lbaint_t test_erase(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	memset(dev->data + blk * BLKSZ, '\0', blkcnt * BLKSZ);
+	dev->erases++;
+	dev->erase_blk = blk;
+	dev->erase_cnt = blkcnt;
+
+	return blkcnt;
+}
+
+/* Add a chunk to an image, returning a pointer to where its data goes */
+static void *add_chunk(void **ptrp, uint type, uint blks, uint data_sz)
+{
+	chunk_header_t *chunk = *ptrp;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blks;
+	chunk->total_sz = sizeof(*chunk) + data_sz;
+	*ptrp += chunk->total_sz;
+
+	return chunk + 1;
+}
+
+/* Check that a range of blocks is filled with a 32-bit value */
+static int check_fill(struct unit_test_state *uts, struct sparse_test_dev *dev,
+		      lbaint_t blk, lbaint_t blkcnt, u32 val)
+{
+	u32 *ptr = (u32 *)(dev->data + blk * BLKSZ);
+	int i;
+
+	for (i = 0; i < blkcnt * BLKSZ / sizeof(u32); i++)
+		ut_asserteq(val, ptr[i]);
+
+	return 0;
+}
+
+/* Test coalescing of raw chunks and erasing for FILL chunks */
+static int lib_test_image_sparse(struct unit_test_state *uts)
+{
+	struct sparse_storage info = {};
+	struct sparse_test_dev *dev;
+	sparse_header_t *hdr;
+	u8 *raw1, *raw2, *raw3;
+	ulong start;
+	void *img, *ptr;
+	char response[65];
+
+	start = ut_check_free();
+	dev = malloc(sizeof(*dev));
+	ut_assertnonnull(dev);
+	memset(dev, '\0', sizeof(*dev));
+	memset(dev->data, '\xaa', sizeof(dev->data));
+	img = malloc(0x4000);
+	ut_assertnonnull(img);
+
+	hdr = img;
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(chunk_header_t);
+	hdr->blk_sz = BLKSZ;
+	hdr->total_blks = 31;
+	hdr->total_chunks = 6;
+
+	/* Blocks 4-5 and 6-8 are raw, then 9-28 are zero */
+	ptr = hdr + 1;
+	raw1 = add_chunk(&ptr, CHUNK_TYPE_RAW, 2, 2 * BLKSZ);
+	memset(raw1, '\x11', 2 * BLKSZ);
+	raw2 = add_chunk(&ptr, CHUNK_TYPE_RAW, 3, 3 * BLKSZ);
+	memset(raw2, '\x22', 3 * BLKSZ);
+	*(u32 *)add_chunk(&ptr, CHUNK_TYPE_FILL, 20, sizeof(u32)) = 0;
+
+	/* Blocks 29-30 are skipped, 31-33 are filled and 34 is raw */
+	add_chunk(&ptr, CHUNK_TYPE_DONT_CARE, 2, 0);
+	*(u32 *)add_chunk(&ptr, CHUNK_TYPE_FILL, 3, sizeof(u32)) = 0x12345678;
+	raw3 = add_chunk(&ptr, CHUNK_TYPE_RAW, 1, BLKSZ);
+	memset(raw3, '\x33', BLKSZ);
+	ut_assert(is_sparse_image(img));
+
+	info.blksz = BLKSZ;
+	info.start = PART_START;
+	info.size = DEV_BLKS - PART_START;
+	info.priv = dev;
+	info.write = test_write;
+	info.reserve = test_reserve;
+	info.erase = test_erase;
+	info.erase_align = 8;
+	info.erase_val = 0;
+	ut_assertok(write_sparse_image(&info, "test", img, response));
+
+	ut_asserteq_mem(raw1, dev->data + 4 * BLKSZ, 2 * BLKSZ);
+	ut_asserteq_mem(raw2, dev->data + 6 * BLKSZ, 3 * BLKSZ);
+	ut_assertok(check_fill(uts, dev, 9, 20, 0));
+	ut_assertok(check_fill(uts, dev, 29, 2, 0xaaaaaaaa));
+	ut_assertok(check_fill(uts, dev, 31, 3, 0x12345678));
+	ut_asserteq_mem(raw3, dev->data + 34 * BLKSZ, BLKSZ);
+	ut_assertok(check_fill(uts, dev, 35, DEV_BLKS - 35, 0xaaaaaaaa));
+
+	/* Only the aligned middle of the zero fill is erased */
+	ut_asserteq(1, dev->erases);
+	ut_asserteq(16, dev->erase_blk);
+	ut_asserteq(8, dev->erase_cnt);
+
+	/* The first two raw chunks go in one write, as do each fill's ends */
+	if (!CONFIG_IS_ENABLED(SYS_DCACHE_OFF))
+		ut_asserteq(5, dev->writes);
+
+	/* Without erase, every block is written */
+	memset(dev->data, '\xaa', sizeof(dev->data));
+	dev->erases = 0;
+	info.erase = NULL;
+	ut_assertok(write_sparse_image(&info, "test", img, response));
+	ut_assertok(check_fill(uts, dev, 9, 20, 0));
+	ut_asserteq(0, dev->erases);
+
+	/* A chunk running past the end of the partition is rejected */
+	info.size = 20;
+	ut_asserteq(-1, write_sparse_image(&info, "test", img, response));
+
+	free(img);
+	free(dev);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_image_sparse, 0);
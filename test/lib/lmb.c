@@ -738,6 +738,95 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 LIB_TEST(lib_test_lmb_max_regions, 0);
 #endif
 
+#ifdef CONFIG_LMB_DYNAMIC
+/* Check that the region arrays grow when they fill up */
+static int lib_test_lmb_grow(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const phys_size_t blk_size = 0x10000;
+	const int count = 4 * CONFIG_LMB_RESERVED_REGIONS;
+	struct lmb lmb;
+	ulong start;
+	int i;
+
+	start = ut_check_free();
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, ram, ram_size));
+
+	/* Reserve every other block, from the top down */
+	for (i = count - 1; i >= 0; i--)
+		ut_asserteq(0, lmb_reserve(&lmb, ram + 2 * i * blk_size,
+					   blk_size));
+	ut_asserteq(count, lmb.reserved.cnt);
+	ut_assert(lmb.reserved.max >= count);
+	ut_assert(lmb.reserved.alloced);
+
+	for (i = 0; i < count; i++) {
+		phys_addr_t base = ram + 2 * i * blk_size;
+
+		ut_asserteq(base, lmb.reserved.region[i].base);
+		ut_asserteq(1, lmb_is_reserved(&lmb, base + blk_size / 2));
+		ut_asserteq(0, lmb_is_reserved(&lmb, base + blk_size));
+		if (i < count - 1)
+			ut_asserteq(blk_size,
+				    lmb_get_free_size(&lmb, base + blk_size));
+	}
+
+	/* Filling the gaps coalesces everything into one region */
+	for (i = 0; i < count - 1; i++)
+		ut_assert(lmb_reserve(&lmb, ram + (2 * i + 1) * blk_size,
+				      blk_size) > 0);
+	ASSERT_LMB(&lmb, ram, ram_size, 1, ram, (2 * count - 1) * blk_size,
+		   0, 0, 0, 0);
+
+	ut_assertok(lmb_free(&lmb, ram + blk_size, blk_size));
+	ASSERT_LMB(&lmb, ram, ram_size, 2, ram, blk_size,
+		   ram + 2 * blk_size, (2 * count - 3) * blk_size, 0, 0);
+
+	lmb_uninit(&lmb);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_grow, 0);
+#endif
+
+/* Check that the global lmb is kept until it is invalidated */
+static int lib_test_lmb_global(struct unit_test_state *uts)
+{
+	struct lmb *lmb;
+	phys_addr_t addr;
+	ulong cnt;
+
+	lmb = lmb_get();
+	ut_assert(lmb->memory.cnt > 0);
+
+	/* Changes are kept until freed */
+	addr = lmb_alloc(lmb, 0x1000, 0x1000);
+	ut_assert(addr);
+	ut_asserteq_ptr(lmb, lmb_get());
+	ut_asserteq(1, lmb_is_reserved(lmb_get(), addr));
+	ut_assertok(lmb_free(lmb, addr, 0x1000));
+	ut_asserteq(0, lmb_is_reserved(lmb_get(), addr));
+
+	/* Checking whether a range is free does not reserve it */
+	cnt = lmb->reserved.cnt;
+	ut_assert(lmb_is_free(lmb, addr, 0x1000));
+	ut_asserteq(cnt, lmb->reserved.cnt);
+
+	/* ...or until the global lmb is invalidated */
+	ut_asserteq(addr, lmb_alloc(lmb, 0x1000, 0x1000));
+	ut_assert(!lmb_is_free(lmb, addr, 0x1000));
+	ut_assert(!lmb_is_free(lmb, addr + 0x800, 0x1000));
+	lmb_invalidate();
+	lmb = lmb_get();
+	ut_asserteq(0, lmb_is_reserved(lmb, addr));
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_global, 0);
+
 static int lib_test_lmb_flags(struct unit_test_state *uts)
 {
 	const phys_addr_t ram = 0x40000000;
@@ -225,3 +225,225 @@ static int lib_memdup(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_memdup, 0);
+
+/*
+ * Non-zero bytes used to fill buffers for the scanning functions. These are
+ * chosen to catch mistakes in word-at-a-time implementations, which look for
+ * zero bytes using arithmetic on the whole word.
+ */
+static const u8 scan_chars[] = { 0x01, 0x80, 0xff, 0x7f, 'a' };
+
+/* Byte not in scan_chars[], used as the character to search for */
+#define SCAN_CHR	'x'
+
+/**
+ * init_scan() - initialize buffer for the scanning functions
+ *
+ * The buffer is filled with bytes from scan_chars[] and does not contain
+ * SCAN_CHR or any zero bytes.
+ *
+ * @buf:	buffer
+ */
+static void init_scan(u8 buf[])
+{
+	int i;
+
+	for (i = 0; i < BUFLEN; ++i)
+		buf[i] = scan_chars[i % ARRAY_SIZE(scan_chars)];
+}
+
+/* Get the sign of a comparison result */
+static int sign(int val)
+{
+	return (val > 0) - (val < 0);
+}
+
+/** lib_strlen() - unit test for strlen() and strnlen() */
+static int lib_strlen(struct unit_test_state *uts)
+{
+	u8 buf[BUFLEN];
+	int offset, len;
+	char *str;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP; ++len) {
+			init_scan(buf);
+			if (offset)
+				buf[offset - 1] = '\0';
+			buf[offset + len] = '\0';
+			str = (char *)buf + offset;
+			ut_asserteq(len, strlen(str));
+			ut_asserteq(0, strnlen(str, 0));
+			ut_asserteq(len, strnlen(str, len));
+			ut_asserteq(len, strnlen(str, len + 1));
+			ut_asserteq(len, strnlen(str, SIZE_MAX));
+			if (len)
+				ut_asserteq(len - 1, strnlen(str, len - 1));
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_strlen, 0);
+
+/** lib_strchr() - unit test for strchr() */
+static int lib_strchr(struct unit_test_state *uts)
+{
+	u8 buf[BUFLEN];
+	int offset, len, pos;
+	char *str;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP - 1; ++len) {
+			init_scan(buf);
+			str = (char *)buf + offset;
+			str[len] = '\0';
+
+			/* Matches before the start or after the end are ignored */
+			if (offset)
+				buf[offset - 1] = SCAN_CHR;
+			buf[offset + len + 1] = SCAN_CHR;
+			ut_assertnull(strchr(str, SCAN_CHR));
+			ut_asserteq_ptr(str + len, strchr(str, '\0'));
+
+			for (pos = 0; pos < len; pos++) {
+				str[pos] = SCAN_CHR;
+				ut_asserteq_ptr(str + pos, strchr(str, SCAN_CHR));
+				ut_asserteq_ptr(str + pos,
+						strchr(str, SCAN_CHR | 0x100));
+				str[pos] = scan_chars[0];
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_strchr, 0);
+
+/** lib_memchr() - unit test for memchr() */
+static int lib_memchr(struct unit_test_state *uts)
+{
+	u8 buf[BUFLEN];
+	int offset, len, pos;
+	u8 *ptr;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP; ++len) {
+			init_scan(buf);
+			ptr = buf + offset;
+
+			/* Zero bytes do not terminate the search */
+			if (len)
+				ptr[len / 2] = '\0';
+
+			/* Matches before the start or after the end are ignored */
+			if (offset)
+				buf[offset - 1] = SCAN_CHR;
+			ptr[len] = SCAN_CHR;
+			ut_assertnull(memchr(ptr, SCAN_CHR, len));
+			ut_asserteq_ptr(ptr + len, memchr(ptr, SCAN_CHR, len + 1));
+
+			for (pos = 0; pos < len; pos++) {
+				u8 old = ptr[pos];
+
+				ptr[pos] = SCAN_CHR;
+				ut_asserteq_ptr(ptr + pos, memchr(ptr, SCAN_CHR, len));
+				ut_asserteq_ptr(ptr + pos,
+						memchr(ptr, SCAN_CHR, SIZE_MAX));
+				ptr[pos] = old;
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_memchr, 0);
+
+/** lib_strcmp() - unit test for strcmp() */
+static int lib_strcmp(struct unit_test_state *uts)
+{
+	u8 buf1[BUFLEN], buf2[BUFLEN];
+	int offset1, offset2, len, pos;
+	char *str1, *str2;
+
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			for (len = 0; len < BUFLEN - SWEEP - 1; ++len) {
+				init_scan(buf1);
+				init_scan(buf2);
+				str1 = (char *)buf1 + offset1;
+				str2 = (char *)buf2 + offset2;
+				memcpy(str2, str1, len);
+				str1[len] = '\0';
+				str2[len] = '\0';
+
+				/* Bytes after the terminator are ignored */
+				str2[len + 1] = scan_chars[1];
+				ut_asserteq(0, strcmp(str1, str2));
+
+				for (pos = 0; pos < len; pos++) {
+					u8 old = str2[pos];
+
+					str2[pos] = old - 1;
+					ut_asserteq(1, sign(strcmp(str1, str2)));
+					ut_asserteq(-1, sign(strcmp(str2, str1)));
+
+					/* A shorter string is less than a longer one */
+					str2[pos] = '\0';
+					ut_asserteq(1, sign(strcmp(str1, str2)));
+					ut_asserteq(-1, sign(strcmp(str2, str1)));
+					str2[pos] = old;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_strcmp, 0);
+
+/** lib_memcmp() - unit test for memcmp() */
+static int lib_memcmp(struct unit_test_state *uts)
+{
+	u8 buf1[BUFLEN], buf2[BUFLEN];
+	int offset1, offset2, len, pos;
+	u8 *ptr1, *ptr2;
+
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			for (len = 0; len < BUFLEN - SWEEP; ++len) {
+				init_scan(buf1);
+				init_scan(buf2);
+				ptr1 = buf1 + offset1;
+				ptr2 = buf2 + offset2;
+				memcpy(ptr2, ptr1, len);
+
+				/* Zero bytes do not stop the comparison */
+				if (len) {
+					ptr1[len / 2] = '\0';
+					ptr2[len / 2] = '\0';
+				}
+
+				/* Bytes after the end are ignored */
+				ptr2[len] = ptr1[len] + 1;
+				ut_asserteq(0, memcmp(ptr1, ptr2, len));
+
+				for (pos = 0; pos < len; pos++) {
+					u8 old = ptr2[pos];
+
+					int expect = old ? 1 : -1;
+
+					ptr2[pos] = old - 1;
+					ut_asserteq(expect,
+						    sign(memcmp(ptr1, ptr2, len)));
+					ut_asserteq(-expect,
+						    sign(memcmp(ptr2, ptr1, len)));
+					ptr2[pos] = old;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_memcmp, 0);
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for crc32 and crc32c, checking the (possibly accelerated)
+ * implementations against a simple table-driven one
+ */
+
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC32_POLY_LE	0xedb88320
+#define CRC32C_POLY_LE	0x82f63b78
+
+/* Enough to cover several rounds of three-lane interleaving */
+#define TEST_BUF_SIZE	(10 * 1024)
+
+static u32 crc_table_ref(u32 crc, const u8 *buf, int len, const u32 *table)
+{
+	while (len--)
+		crc = table[(u8)(crc ^ *buf++)] ^ (crc >> 8);
+
+	return crc;
+}
+
+static int lib_crc32(struct unit_test_state *uts)
+{
+	static const int lens[] = {
+		0, 1, 3, 4, 7, 8, 9, 63, 64, 1000, 3 * 1024 - 1, 3 * 1024,
+		3 * 1024 + 1, 6 * 1024 + 13, TEST_BUF_SIZE - 8,
+	};
+	u32 crc32_table[256], crc32c_table[256];
+	u8 *buf;
+	int i, align;
+
+	ut_asserteq(0xcbf43926, crc32(0, (const u8 *)"123456789", 9));
+
+	crc32c_init(crc32_table, CRC32_POLY_LE);
+	crc32c_init(crc32c_table, CRC32C_POLY_LE);
+	ut_asserteq(0xe3069283, ~crc32c_cal(~0, "123456789", 9,
+					    crc32c_table));
+
+	buf = malloc(TEST_BUF_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < TEST_BUF_SIZE; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	for (align = 0; align < 8; align++) {
+		for (i = 0; i < ARRAY_SIZE(lens); i++) {
+			const u8 *p = buf + align;
+			int len = lens[i];
+
+			ut_asserteq(crc_table_ref(~0, p, len, crc32_table),
+				    crc32_no_comp(~0, p, len));
+			ut_asserteq(crc_table_ref(0x12345678, p, len,
+						  crc32c_table),
+				    crc32c_cal(0x12345678, (const char *)p, len,
+					       crc32c_table));
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_crc32, 0);
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the log ring buffer
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <log.h>
+#include <asm/global_data.h>
+#include <test/log.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Test that messages are formatted correctly from the stored arguments */
+static int log_test_ring(struct unit_test_state *uts)
+{
+	u8 mac[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+	int log_fmt = gd->log_fmt;
+	char str[] = "string";
+	char ptr[20], buf[200];
+	void *addr = &str;
+
+	log_ring_clear();
+	gd->log_fmt = BIT(LOGF_LEVEL) | BIT(LOGF_CAT) | BIT(LOGF_MSG);
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), false));
+	log(LOGC_ARCH, LOGL_ERR, "int %d long %lx quad %lld char %c\n", -12,
+	    0x1234abcdUL, 0x123456789abcdLL, 'z');
+	log(LOGC_BOOT, LOGL_WARNING, "str %s/%-8s/%.3s/%.*s/%*d/%s %%\n", str,
+	    str, str, 2, str, 4, 5, (char *)NULL);
+	log(LOGC_DM, LOGL_INFO, "ptr %p mac %pM\n", addr, mac);
+	log(LOGC_EFI, LOGL_INFO, "no args ");
+	log_cont("cont %d\n", 1);
+
+	/* Strings are copied, so later changes do not matter */
+	strcpy(str, "change");
+	ut_assertok(run_command("log rec spi info rec.c 12 func msg", 0));
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), true));
+
+	console_record_reset_enable();
+	ut_asserteq(6, log_ring_show());
+	ut_assert_nextline("ERR.arch, int -12 long 1234abcd quad 320255973501901 char z");
+	ut_assert_nextline("WARNING.boot, str string/string  /str/st/   5/<NULL> %%");
+	snprintf(ptr, sizeof(ptr), "%p", addr);
+	ut_assert_nextline("INFO.dm, ptr %s mac 00:11:22:33:44:55", ptr);
+	ut_assert_nextline("INFO.efi, no args cont 1");
+	ut_assert_nextline("INFO.spi, msg");
+	ut_assert_console_end();
+
+	/* The file and function for 'log rec' are copied too */
+	gd->log_fmt = BIT(LOGF_FILE) | BIT(LOGF_LINE) | BIT(LOGF_MSG);
+	ut_asserteq(6, log_ring_show());
+	ut_assert_skip_to_line("rec.c:12- msg");
+	ut_assert_console_end();
+
+	/* When exporting to a small buffer, only the latest records fit */
+	gd->log_fmt = BIT(LOGF_MSG);
+	ut_asserteq(19, log_ring_export(buf, 24));
+	ut_asserteq_str("no args cont 1\nmsg\n", buf);
+	ut_asserteq(0, log_ring_export(buf, 3));
+	ut_asserteq_str("", buf);
+
+	log_ring_clear();
+	ut_asserteq(0, log_ring_show());
+	gd->log_fmt = log_fmt;
+
+	return 0;
+}
+LOG_TEST_FLAGS(log_test_ring, UT_TESTF_CONSOLE_REC);
+
+/* Test that the oldest records are overwritten when the buffer is full */
+static int log_test_ring_wrap(struct unit_test_state *uts)
+{
+	int log_fmt = gd->log_fmt;
+	char buf[100], expect[30];
+	int i, len, count;
+
+	log_ring_clear();
+	gd->log_fmt = BIT(LOGF_MSG);
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), false));
+	for (i = 0; i < CONFIG_LOG_RING_SIZE / 16; i++)
+		log(LOGC_ARCH, LOGL_ERR, "record %d of %s\n", i, "many");
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), true));
+
+	console_record_reset_enable();
+	count = log_ring_show();
+	ut_assert(count > 0);
+	ut_assert(count < i);
+	ut_assert_nextline("record %d of many", i - count);
+	ut_assert_skip_to_line("record %d of many", i - 1);
+	ut_assert_console_end();
+
+	/* The export ends with the latest record */
+	len = log_ring_export(buf, sizeof(buf));
+	ut_assert(len > 0 && len < sizeof(buf));
+	snprintf(expect, sizeof(expect), "record %d of many\n", i - 1);
+	ut_asserteq_str(expect, buf + len - strlen(expect));
+	log_ring_clear();
+	gd->log_fmt = log_fmt;
+
+	return 0;
+}
+LOG_TEST_FLAGS(log_test_ring_wrap, UT_TESTF_CONSOLE_REC);
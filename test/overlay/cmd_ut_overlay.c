@@ -11,6 +11,7 @@
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
+#include <time.h>
 
 #include <linux/sizes.h>
 
@@ -211,6 +212,118 @@ static int fdt_overlay_stacked(struct unit_test_state *uts)
 }
 OVERLAY_TEST(fdt_overlay_stacked, 0);
 
+/* Number of overlays to apply in the batch benchmark */
+#define BATCH_BENCH_COUNT	16
+
+/**
+ * overlay_copies() - Make writable copies of an overlay stack
+ *
+ * @fdtos: Returns the copies
+ * @count: Number of copies to make
+ * @stack: Overlays to copy, in order, repeating as needed to fill @count
+ * @stack_count: Number of overlays in @stack
+ * Return: 0 if OK, -ve on error
+ */
+static int overlay_copies(void *fdtos[], int count, void *const stack[],
+			  int stack_count)
+{
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		fdtos[i] = malloc(FDT_COPY_SIZE);
+		if (!fdtos[i])
+			return -ENOMEM;
+		ret = fdt_open_into(stack[i % stack_count], fdtos[i],
+				    FDT_COPY_SIZE);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void overlay_free(void *fdtos[], int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		free(fdtos[i]);
+}
+
+/* Test that applying a batch gives the same result as one at a time */
+static int fdt_overlay_batch(struct unit_test_state *uts)
+{
+	void *const stack[] = {
+		&__dtb_test_fdt_overlay_begin,
+		&__dtb_test_fdt_overlay_stacked_begin,
+	};
+	void *fdtos[ARRAY_SIZE(stack)] = {};
+	void *base;
+
+	base = malloc(FDT_COPY_SIZE);
+	ut_assertnonnull(base);
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, base,
+				  FDT_COPY_SIZE));
+	ut_assertok(overlay_copies(fdtos, ARRAY_SIZE(stack), stack,
+				   ARRAY_SIZE(stack)));
+
+	ut_assertok(fdt_overlay_apply_batch(base, fdtos, ARRAY_SIZE(stack)));
+	ut_asserteq(fdt_totalsize(fdt), fdt_totalsize(base));
+	ut_asserteq_mem(fdt, base, fdt_totalsize(fdt));
+
+	overlay_free(fdtos, ARRAY_SIZE(stack));
+	free(base);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_batch, 0);
+
+/* Compare the time taken to apply a stack of overlays one by one and batched */
+static int fdt_overlay_batch_bench(struct unit_test_state *uts)
+{
+	void *const stack[] = {
+		&__dtb_test_fdt_overlay_begin,
+		&__dtb_test_fdt_overlay_stacked_begin,
+	};
+	void *fdtos[BATCH_BENCH_COUNT] = {};
+	ulong seq_us, batch_us, start;
+	void *seq, *batch;
+	int i;
+
+	seq = malloc(SZ_64K);
+	batch = malloc(SZ_64K);
+	ut_assertnonnull(seq);
+	ut_assertnonnull(batch);
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, seq, SZ_64K));
+	ut_assertok(fdt_open_into(&__dtb_test_fdt_base_begin, batch, SZ_64K));
+
+	ut_assertok(overlay_copies(fdtos, BATCH_BENCH_COUNT, stack,
+				   ARRAY_SIZE(stack)));
+	start = timer_get_us();
+	for (i = 0; i < BATCH_BENCH_COUNT; i++)
+		ut_assertok(fdt_overlay_apply(seq, fdtos[i]));
+	seq_us = timer_get_us() - start;
+	overlay_free(fdtos, BATCH_BENCH_COUNT);
+
+	ut_assertok(overlay_copies(fdtos, BATCH_BENCH_COUNT, stack,
+				   ARRAY_SIZE(stack)));
+	start = timer_get_us();
+	ut_assertok(fdt_overlay_apply_batch(batch, fdtos, BATCH_BENCH_COUNT));
+	batch_us = timer_get_us() - start;
+	overlay_free(fdtos, BATCH_BENCH_COUNT);
+
+	ut_asserteq(fdt_totalsize(seq), fdt_totalsize(batch));
+	ut_asserteq_mem(seq, batch, fdt_totalsize(seq));
+	printf("%d overlays: one at a time %lu us, batch %lu us\n",
+	       BATCH_BENCH_COUNT, seq_us, batch_us);
+
+	free(batch);
+	free(seq);
+
+	return CMD_RET_SUCCESS;
+}
+OVERLAY_TEST(fdt_overlay_batch_bench, 0);
+
 int do_ut_overlay(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct unit_test *tests = UNIT_TEST_SUITE_START(overlay_test);
@@ -65,3 +65,28 @@ def test_bootstage_unstash(u_boot_console):
     u_boot_console.run_command('bootstage unstash %x %x' % (addr, size))
     output = u_boot_console.run_command('echo $?')
     assert output.endswith('0')
+
+@pytest.mark.buildconfigspec('bootstage_events')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_events(u_boot_console):
+    output = u_boot_console.run_command('bootstage events')
+    assert 'Elapsed' in output
+    assert 'initcall:' in output
+    assert 'probe:' in output
+
+    output = u_boot_console.run_command('bootstage events chrome')
+    lines = output.splitlines()
+    assert lines[0] == '['
+    assert lines[-1] == ']'
+    assert '"ph":"X"' in lines[1]
+
+    # Each line has a stack of frames followed by the self time
+    output = u_boot_console.run_command('bootstage events folded')
+    for line in output.splitlines():
+        stack, us = line.rsplit(' ', 1)
+        assert stack
+        assert int(us) > 0
+
+    u_boot_console.run_command('bootstage events clear')
+    output = u_boot_console.run_command('bootstage events folded')
+    assert output == ''